@@ -0,0 +1,254 @@
+/**
+ * @file dashboard_bench.c
+ * Headless frame-time benchmark of the dashboard
+ *
+ * Builds the dashboard with N synthetic lights on an offscreen display,
+ * replays a scripted input sequence and reports per-phase frame render
+ * time, rendered area, dirty areas and LVGL heap usage.
+ *
+ * Usage: dashboard_bench [lights] [max_avg_frame_ms] [render_mode]
+ * With max_avg_frame_ms the exit status is 1 if any phase's average frame
+ * time exceeds it, so the benchmark can gate CI. render_mode is "direct"
+ * (default), "full" or "partial[:lines[:buffers]]".
+ * Built with DASHBOARD_TRACE=1 it also writes a Chrome trace of the run to
+ * DASHBOARD_TRACE_FILE (default dashboard_bench_trace.json).
+ */
+
+#include "lvgl/lvgl.h"
+#include "dashboard.h"
+#include "headless_display.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Offscreen display size, same as the SDL window */
+#define BENCH_WIDTH  1024
+#define BENCH_HEIGHT 600
+
+/* Simulated time per frame */
+#define BENCH_FRAME_MS 33
+
+/* Enough lights for the virtualized grid to matter */
+#define BENCH_DEFAULT_LIGHTS 500
+
+/* Per-phase results */
+typedef struct {
+    const char *name;
+    uint32_t frames;
+    double total_ms;
+    double max_ms;
+    uint64_t pixels;
+    uint64_t rects;          /* Invalidated areas */
+    uint64_t dirty_pixels;   /* Pixels left to redraw after merging them */
+} bench_phase_t;
+
+static light_state_t bench_lights[DASHBOARD_MAX_LIGHTS];
+static uint32_t mem_max_used = 0;
+
+/**
+ * Milliseconds from a monotonic clock
+ */
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+/**
+ * Advance time by one frame and let LVGL read input, lay out and render
+ */
+static void bench_frame(bench_phase_t *phase)
+{
+    headless_display_stats_t before;
+    headless_display_stats_t after;
+    display_config_stats_t dirty_before;
+    display_config_stats_t dirty_after;
+
+    headless_display_get_stats(&before);
+    display_config_get_stats(&dirty_before);
+    lv_tick_inc(BENCH_FRAME_MS);
+
+    double start = now_ms();
+    lv_timer_handler();
+    double elapsed = now_ms() - start;
+
+    headless_display_get_stats(&after);
+    display_config_get_stats(&dirty_after);
+    phase->frames++;
+    phase->total_ms += elapsed;
+    if (elapsed > phase->max_ms) {
+        phase->max_ms = elapsed;
+    }
+    phase->pixels += after.pixels - before.pixels;
+    phase->rects += dirty_after.rects - dirty_before.rects;
+    phase->dirty_pixels += dirty_after.merged_pixels - dirty_before.merged_pixels;
+
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    if (mon.max_used > mem_max_used) {
+        mem_max_used = mon.max_used;
+    }
+}
+
+/**
+ * Drag the pointer in a straight line over a number of frames
+ */
+static void bench_drag(bench_phase_t *phase, int32_t x0, int32_t y0, int32_t x1, int32_t y1, int steps)
+{
+    for (int i = 0; i <= steps; i++) {
+        headless_pointer_set(x0 + (x1 - x0) * i / steps, y0 + (y1 - y0) * i / steps, true);
+        bench_frame(phase);
+    }
+    headless_pointer_set(x1, y1, false);
+    bench_frame(phase);
+}
+
+/**
+ * Print one phase
+ */
+static void bench_report(const bench_phase_t *phase)
+{
+    double avg = phase->frames ? phase->total_ms / phase->frames : 0.0;
+    double px = phase->frames ? (double)phase->pixels / phase->frames : 0.0;
+    double rects = phase->frames ? (double)phase->rects / phase->frames : 0.0;
+    double dirty = phase->frames ? (double)phase->dirty_pixels / phase->frames : 0.0;
+
+    printf("%-14s %6u %9.3f %9.3f %12.0f %7.1f%% %7.1f %7.1f%%\n", phase->name, (unsigned)phase->frames,
+           avg, phase->max_ms, px, px * 100.0 / (BENCH_WIDTH * BENCH_HEIGHT),
+           rects, dirty * 100.0 / (BENCH_WIDTH * BENCH_HEIGHT));
+}
+
+/**
+ * Fill the synthetic light list, alternating switch and color lights
+ */
+static void bench_make_lights(int count)
+{
+    for (int i = 0; i < count; i++) {
+        light_state_t *light = &bench_lights[i];
+        memset(light, 0, sizeof(*light));
+        snprintf(light->name, sizeof(light->name), "Light %d", i + 1);
+        snprintf(light->entity_id, sizeof(light->entity_id), "light.bench_%d", i + 1);
+        light->type = (i % 2) ? LIGHT_TYPE_COLOR : LIGHT_TYPE_SWITCH;
+        light->is_on = (i % 3) != 0;
+        light->brightness = (uint8_t)(i * 37);
+        light->red = (uint8_t)(i * 53);
+        light->green = (uint8_t)(i * 97);
+        light->blue = (uint8_t)(i * 151);
+        light->color_temp = (uint16_t)(2000 + (i * 250) % 4500);
+    }
+}
+
+/**
+ * Benchmark entry point
+ */
+int main(int argc, char *argv[])
+{
+    int count = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_LIGHTS;
+    double max_avg_ms = argc > 2 ? atof(argv[2]) : 0.0;
+    display_config_t config = {.mode = LV_DISPLAY_RENDER_MODE_DIRECT};
+
+    if (count < 1 || count > DASHBOARD_MAX_LIGHTS) {
+        fprintf(stderr, "Light count must be between 1 and %d\n", DASHBOARD_MAX_LIGHTS);
+        return 2;
+    }
+
+    if (argc > 3 && !display_config_parse(argv[3], &config)) {
+        fprintf(stderr, "Unknown render mode %s\n", argv[3]);
+        return 2;
+    }
+    
+    lv_init();
+    TRACE_THREAD_NAME("bench");
+    lv_display_t *disp = headless_display_create_with_config(BENCH_WIDTH, BENCH_HEIGHT, &config);
+    if (!disp) {
+        return 2;
+    }
+    display_config_attach_stats(disp);
+    headless_pointer_create();
+
+    lv_obj_t *screen = lv_screen_active();
+    lv_obj_set_style_bg_color(screen, lv_color_hex(0x0A0A0A), 0);
+
+    bench_make_lights(count);
+
+    bench_phase_t phases[] = {
+        {.name = "build"},
+        {.name = "first frame"},
+        {.name = "slider drag"},
+        {.name = "scroll"},
+        {.name = "idle"},
+        {.name = "state refresh"},
+    };
+    bench_phase_t *build = &phases[0];
+    bench_phase_t *first = &phases[1];
+    bench_phase_t *slider = &phases[2];
+    bench_phase_t *scroll = &phases[3];
+    bench_phase_t *idle = &phases[4];
+    bench_phase_t *refresh = &phases[5];
+
+    /* Widget creation is timed on its own, the first frame renders it */
+    double start = now_ms();
+    dashboard_init_with_lights(screen, bench_lights, count);
+    build->frames = 1;
+    build->total_ms = build->max_ms = now_ms() - start;
+
+    bench_frame(first);
+
+    /* Brightness slider of the first card, back and forth */
+    for (int i = 0; i < 3; i++) {
+        bench_drag(slider, 60, 302, 240, 302, 10);
+        bench_drag(slider, 240, 302, 60, 302, 10);
+    }
+
+    /* Scroll down through the grid and back up */
+    for (int i = 0; i < 5; i++) {
+        bench_drag(scroll, 700, 560, 700, 200, 12);
+    }
+    for (int i = 0; i < 5; i++) {
+        bench_drag(scroll, 700, 200, 700, 560, 12);
+    }
+
+    for (int i = 0; i < 30; i++) {
+        bench_frame(idle);
+    }
+
+    /* Re-render every card from unchanged state, as after a reconnect */
+    for (int i = 0; i < 30; i++) {
+        dashboard_update();
+        bench_frame(refresh);
+    }
+
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+
+    char mode[32];
+    display_config_describe(&config, mode, sizeof(mode));
+    printf("\nDashboard benchmark: %d lights, %dx%d, %s\n\n", count, BENCH_WIDTH, BENCH_HEIGHT, mode);
+    printf("%-14s %6s %9s %9s %12s %8s %7s %8s\n", "phase", "frames", "avg ms", "max ms", "px/frame", "screen",
+           "rects", "dirty");
+    int status = 0;
+    for (size_t i = 0; i < sizeof(phases) / sizeof(phases[0]); i++) {
+        bench_report(&phases[i]);
+        if (max_avg_ms > 0.0 && i > 0 && phases[i].frames &&
+            phases[i].total_ms / phases[i].frames > max_avg_ms) {
+            status = 1;
+        }
+    }
+    printf("\nLVGL heap: %u bytes peak, %u bytes in use of %u\n",
+           (unsigned)mem_max_used, (unsigned)(mon.total_size - mon.free_size), (unsigned)mon.total_size);
+
+    if (status) {
+        printf("FAIL: average frame time above %.3f ms\n", max_avg_ms);
+    }
+
+    if (trace_enabled()) {
+        trace_dump(getenv("DASHBOARD_TRACE_FILE") ? getenv("DASHBOARD_TRACE_FILE") : "dashboard_bench_trace.json");
+    }
+
+    headless_display_delete();
+    lv_deinit();
+    return status;
+}
@@ -0,0 +1,218 @@
+/**
+ * @file light_store_bench.c
+ * Microbenchmark of bulk light operations: light_state_t array vs light_store
+ *
+ * Runs "all off", a diff against a server snapshot and a scene applied to a
+ * third of the lights over the same data in both layouts and prints the
+ * time per light.
+ *
+ * Usage: light_store_bench [lights] [iterations]
+ */
+
+#include "light_store.h"
+#include "ha_api.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_DEFAULT_LIGHTS 10000
+#define BENCH_DEFAULT_ITERATIONS 2000
+
+/* Keeps results alive so the loops are not optimized away */
+static volatile int sink;
+
+/**
+ * Nanoseconds from a monotonic clock
+ */
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * AoS: turn every light off
+ */
+static int aos_all_off(light_state_t *lights, int count)
+{
+    int was_on = 0;
+    for (int i = 0; i < count; i++) {
+        was_on += lights[i].is_on;
+        lights[i].is_on = false;
+    }
+    return was_on;
+}
+
+/**
+ * AoS: diff against a snapshot
+ */
+static int aos_diff(const light_state_t *lights, const light_state_t *snapshot, int count, uint8_t *fields)
+{
+    int changed = 0;
+    for (int i = 0; i < count; i++) {
+        const light_state_t *a = &lights[i];
+        const light_state_t *b = &snapshot[i];
+        uint8_t f = 0;
+        if (a->is_on != b->is_on) f |= HA_LIGHT_FIELD_POWER;
+        if (a->brightness != b->brightness) f |= HA_LIGHT_FIELD_BRIGHTNESS;
+        if (a->red != b->red || a->green != b->green || a->blue != b->blue) f |= HA_LIGHT_FIELD_COLOR;
+        if (a->color_temp != b->color_temp) f |= HA_LIGHT_FIELD_COLOR_TEMP;
+        fields[i] = f;
+        changed += f != 0;
+    }
+    return changed;
+}
+
+/**
+ * AoS: apply a scene to the selected lights
+ */
+static void aos_apply_scene(light_state_t *lights, int count, const uint8_t *members, const light_scene_t *scene)
+{
+    for (int i = 0; i < count; i++) {
+        if (!members[i]) {
+            continue;
+        }
+        lights[i].is_on = scene->is_on;
+        lights[i].brightness = scene->brightness;
+        lights[i].red = scene->red;
+        lights[i].green = scene->green;
+        lights[i].blue = scene->blue;
+        lights[i].color_temp = scene->color_temp;
+    }
+}
+
+/**
+ * Print one comparison line
+ */
+static void report(const char *name, double aos_ns, double soa_ns, int count, int iterations)
+{
+    double per = (double)count * iterations;
+    printf("%-12s %10.3f %10.3f %8.1fx\n", name, aos_ns / per, soa_ns / per, aos_ns / soa_ns);
+}
+
+/**
+ * Benchmark entry point
+ */
+int main(int argc, char *argv[])
+{
+    int count = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_LIGHTS;
+    int iterations = argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_ITERATIONS;
+
+    if (count < 1 || iterations < 1) {
+        fprintf(stderr, "Usage: %s [lights] [iterations]\n", argv[0]);
+        return 2;
+    }
+
+    light_state_t *lights = calloc((size_t)count, sizeof(*lights));
+    light_state_t *lights_snapshot = calloc((size_t)count, sizeof(*lights_snapshot));
+    uint8_t *members = calloc((size_t)count, 1);
+    uint8_t *fields = calloc((size_t)count, 1);
+    light_store_t store;
+    light_store_t store_snapshot;
+
+    if (!lights || !lights_snapshot || !members || !fields ||
+        !light_store_init(&store, count) || !light_store_init(&store_snapshot, count)) {
+        fprintf(stderr, "Out of memory\n");
+        return 2;
+    }
+
+    /* Same pseudo-random lights in both layouts; the snapshot differs in
+     * about one light out of eight */
+    srand(1);
+    for (int i = 0; i < count; i++) {
+        light_state_t *light = &lights[i];
+        snprintf(light->name, sizeof(light->name), "Light %d", i);
+        snprintf(light->entity_id, sizeof(light->entity_id), "light.l%d", i);
+        light->handle = (entity_handle_t)i;
+        light->type = (i & 1) ? LIGHT_TYPE_COLOR : LIGHT_TYPE_SWITCH;
+        light->is_on = rand() & 1;
+        light->brightness = (uint8_t)rand();
+        light->red = (uint8_t)rand();
+        light->green = (uint8_t)rand();
+        light->blue = (uint8_t)rand();
+        light->color_temp = (uint16_t)(2000 + rand() % 4500);
+
+        lights_snapshot[i] = *light;
+        if ((rand() & 7) == 0) {
+            lights_snapshot[i].brightness ^= 0x10;
+        }
+        members[i] = (i % 3) == 0;
+
+        light_store_add(&store, light);
+        light_store_add(&store_snapshot, &lights_snapshot[i]);
+    }
+
+    light_scene_t scene = {
+        .fields = HA_LIGHT_FIELD_POWER | HA_LIGHT_FIELD_BRIGHTNESS |
+                  HA_LIGHT_FIELD_COLOR | HA_LIGHT_FIELD_COLOR_TEMP,
+        .is_on = true, .brightness = 180, .red = 255, .green = 160, .blue = 60, .color_temp = 2700
+    };
+
+    double start;
+    double aos_ns;
+    double soa_ns;
+    int result = 0;
+
+    printf("Bulk light operations, %d lights, %d iterations (ns per light)\n\n", count, iterations);
+    printf("%-12s %10s %10s %9s\n", "operation", "AoS", "SoA", "speedup");
+
+    start = now_ns();
+    for (int it = 0; it < iterations; it++) {
+        result += aos_diff(lights, lights_snapshot, count, fields);
+    }
+    aos_ns = now_ns() - start;
+    start = now_ns();
+    for (int it = 0; it < iterations; it++) {
+        result += light_store_diff(&store, &store_snapshot, fields);
+    }
+    soa_ns = now_ns() - start;
+    report("diff", aos_ns, soa_ns, count, iterations);
+
+    start = now_ns();
+    for (int it = 0; it < iterations; it++) {
+        aos_apply_scene(lights, count, members, &scene);
+    }
+    aos_ns = now_ns() - start;
+    start = now_ns();
+    for (int it = 0; it < iterations; it++) {
+        light_store_apply_scene(&store, members, &scene);
+    }
+    soa_ns = now_ns() - start;
+    report("scene", aos_ns, soa_ns, count, iterations);
+
+    start = now_ns();
+    for (int it = 0; it < iterations; it++) {
+        lights[it % count].is_on = true;
+        result += aos_all_off(lights, count);
+    }
+    aos_ns = now_ns() - start;
+    start = now_ns();
+    for (int it = 0; it < iterations; it++) {
+        store.is_on[it % count] = 1;
+        result += light_store_all_off(&store);
+    }
+    soa_ns = now_ns() - start;
+    report("all off", aos_ns, soa_ns, count, iterations);
+
+    /* Both layouts must agree */
+    int aos_changed = aos_diff(lights, lights_snapshot, count, fields);
+    int soa_changed = light_store_diff(&store, &store_snapshot, fields);
+    printf("\nHot data: AoS %zu bytes, SoA %zu bytes\n",
+           (size_t)count * sizeof(light_state_t), (size_t)count * 8);
+    sink = result;
+
+    light_store_free(&store);
+    light_store_free(&store_snapshot);
+    free(lights);
+    free(lights_snapshot);
+    free(members);
+    free(fields);
+
+    if (aos_changed != soa_changed) {
+        printf("FAIL: layouts disagree (%d vs %d changed lights)\n", aos_changed, soa_changed);
+        return 1;
+    }
+    return 0;
+}
@@ -19,15 +19,42 @@
    MEMORY SETTINGS
  *=========================*/
 
+/* Heap backends, selected with -DDASHBOARD_MEM_BACKEND (CMake option of the same name):
+ * BUILTIN - LVGL's TLSF allocator on a fixed LV_MEM_SIZE pool
+ * SYSTEM  - system malloc, with byte accounting (src/mem_system.c)
+ * ARENA   - TLSF on a small fixed pool plus an arena sized from the light count */
+#define DASHBOARD_MEM_BUILTIN 0
+#define DASHBOARD_MEM_SYSTEM  1
+#define DASHBOARD_MEM_ARENA   2
+
+#ifndef DASHBOARD_MEM_BACKEND
+#define DASHBOARD_MEM_BACKEND DASHBOARD_MEM_BUILTIN
+#endif
+
+#if DASHBOARD_MEM_BACKEND == DASHBOARD_MEM_SYSTEM
+#define LV_USE_STDLIB_MALLOC LV_STDLIB_CUSTOM
+#else
+#define LV_USE_STDLIB_MALLOC LV_STDLIB_BUILTIN
+#endif
+
 /* Size of the memory available for `lv_mem_alloc()` in bytes */
+#if DASHBOARD_MEM_BACKEND == DASHBOARD_MEM_ARENA
+#define LV_MEM_SIZE (32U * 1024U)  /* Screen, theme and groups; cards go to the arena */
+#else
 #define LV_MEM_SIZE (64U * 1024U)
+#endif
 
 /*====================
    HAL SETTINGS
  *====================*/
 
-/* Default display refresh period. LVG will redraw changed areas with this period time */
-#define LV_DISP_DEF_REFR_PERIOD 30
+/* Default display refresh period. LVG will redraw changed areas with this period time
+ * (-DDASHBOARD_REFR_PERIOD, CMake option of the same name) */
+#ifndef DASHBOARD_REFR_PERIOD
+#define DASHBOARD_REFR_PERIOD 30
+#endif
+#define LV_DEF_REFR_PERIOD DASHBOARD_REFR_PERIOD
+#define LV_DISP_DEF_REFR_PERIOD DASHBOARD_REFR_PERIOD  /* Name used before LVGL v9 */
 
 /* DPI of the display */
 #define LV_DPI_DEF 130
@@ -80,6 +107,17 @@
 /* Enable SDL support */
 #define LV_USE_SDL 1
 
+/* The SDL driver fixes its render mode at compile time (-DDASHBOARD_SDL_RENDER_MODE):
+ * partial renders into two band buffers, direct and full into the window's texture */
+#ifndef DASHBOARD_SDL_RENDER_MODE
+#define DASHBOARD_SDL_RENDER_MODE LV_DISPLAY_RENDER_MODE_DIRECT
+#endif
+#ifndef DASHBOARD_SDL_BUF_COUNT
+#define DASHBOARD_SDL_BUF_COUNT 1
+#endif
+#define LV_SDL_RENDER_MODE DASHBOARD_SDL_RENDER_MODE
+#define LV_SDL_BUF_COUNT DASHBOARD_SDL_BUF_COUNT
+
 /*====================
  * WIDGETS
  *====================*/
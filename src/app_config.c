@@ -0,0 +1,385 @@
+/**
+ * @file app_config.c
+ * Runtime dashboard configuration file implementation
+ */
+
+#include "app_config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Section the parser is in */
+typedef enum {
+    APP_CONFIG_SECTION_NONE,
+    APP_CONFIG_SECTION_HA,
+    APP_CONFIG_SECTION_DASHBOARD,
+    APP_CONFIG_SECTION_LIGHT,
+    APP_CONFIG_SECTION_GROUP,
+    APP_CONFIG_SECTION_UNKNOWN
+} app_config_section_t;
+
+/* Piece of the mapped file */
+typedef struct {
+    const char *p;
+    size_t len;
+} app_config_span_t;
+
+/* Parser position, for error messages */
+typedef struct {
+    const char *path;
+    int line;
+    bool ok;
+} app_config_parser_t;
+
+/* Name of the watched file inside the watched directory */
+static char watch_name[256] = {0};
+
+/**
+ * Report a problem on the current line
+ */
+static void parse_error(app_config_parser_t *parser, const char *msg, app_config_span_t span)
+{
+    fprintf(stderr, "Config %s:%d: %s '%.*s'\n", parser->path, parser->line, msg, (int)span.len, span.p);
+    parser->ok = false;
+}
+
+/**
+ * Strip spaces and tabs from both ends
+ */
+static app_config_span_t span_trim(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) {
+        end--;
+    }
+    app_config_span_t span = {p, (size_t)(end - p)};
+    return span;
+}
+
+/**
+ * Compare a span with a string
+ */
+static bool span_eq(app_config_span_t span, const char *s)
+{
+    return strlen(s) == span.len && memcmp(span.p, s, span.len) == 0;
+}
+
+/**
+ * Copy a span into a fixed-size field
+ * @return false if it does not fit
+ */
+static bool span_copy(char *dst, size_t size, app_config_span_t span)
+{
+    if (span.len >= size) {
+        return false;
+    }
+    memcpy(dst, span.p, span.len);
+    dst[span.len] = '\0';
+    return true;
+}
+
+/**
+ * Parse a small non-negative integer
+ * @return -1 if the span is not one
+ */
+static int span_int(app_config_span_t span)
+{
+    int value = 0;
+
+    if (span.len == 0 || span.len > 4) {
+        return -1;
+    }
+    for (size_t i = 0; i < span.len; i++) {
+        if (span.p[i] < '0' || span.p[i] > '9') {
+            return -1;
+        }
+        value = value * 10 + (span.p[i] - '0');
+    }
+    return value;
+}
+
+/**
+ * Start a new section
+ */
+static app_config_section_t parse_section(app_config_parser_t *parser, app_config_t *config,
+                                          app_config_span_t name)
+{
+    static const char group_prefix[] = "group ";
+
+    if (span_eq(name, "homeassistant")) {
+        return APP_CONFIG_SECTION_HA;
+    }
+    if (span_eq(name, "dashboard")) {
+        return APP_CONFIG_SECTION_DASHBOARD;
+    }
+
+    if (name.len > 6 && memcmp(name.p, "light.", 6) == 0) {
+        if (config->num_lights >= DASHBOARD_MAX_LIGHTS) {
+            parse_error(parser, "too many lights at", name);
+            return APP_CONFIG_SECTION_UNKNOWN;
+        }
+        app_config_light_t *light = &config->lights[config->num_lights];
+        if (!span_copy(light->entity_id, sizeof(light->entity_id), name)) {
+            parse_error(parser, "entity ID too long", name);
+            return APP_CONFIG_SECTION_UNKNOWN;
+        }
+        light->type = -1;
+        config->num_lights++;
+        return APP_CONFIG_SECTION_LIGHT;
+    }
+
+    if (name.len > sizeof(group_prefix) - 1 && memcmp(name.p, group_prefix, sizeof(group_prefix) - 1) == 0) {
+        app_config_span_t group_name = span_trim(name.p + sizeof(group_prefix) - 1, name.p + name.len);
+        if (config->num_groups >= DASHBOARD_MAX_GROUPS) {
+            parse_error(parser, "too many groups at", name);
+            return APP_CONFIG_SECTION_UNKNOWN;
+        }
+        app_config_group_t *group = &config->groups[config->num_groups];
+        if (!span_copy(group->name, sizeof(group->name), group_name)) {
+            parse_error(parser, "group name too long", group_name);
+            return APP_CONFIG_SECTION_UNKNOWN;
+        }
+        config->num_groups++;
+        return APP_CONFIG_SECTION_GROUP;
+    }
+
+    parse_error(parser, "unknown section", name);
+    return APP_CONFIG_SECTION_UNKNOWN;
+}
+
+/**
+ * Apply one "key = value" line of a section
+ */
+static void parse_value(app_config_parser_t *parser, app_config_t *config, app_config_section_t section,
+                        app_config_span_t key, app_config_span_t value)
+{
+    bool fits = true;
+
+    switch (section) {
+    case APP_CONFIG_SECTION_HA:
+        if (span_eq(key, "url")) {
+            fits = span_copy(config->ha_url, sizeof(config->ha_url), value);
+        } else if (span_eq(key, "token")) {
+            fits = span_copy(config->ha_token, sizeof(config->ha_token), value);
+        } else {
+            parse_error(parser, "unknown key", key);
+        }
+        break;
+
+    case APP_CONFIG_SECTION_DASHBOARD:
+        if (span_eq(key, "title")) {
+            fits = span_copy(config->title, sizeof(config->title), value);
+        } else if (span_eq(key, "columns")) {
+            config->columns = span_int(value);
+            if (config->columns < 0 || config->columns > 16) {
+                config->columns = 0;
+                parse_error(parser, "columns must be 0 to 16, not", value);
+            }
+        } else if (span_eq(key, "snapshot")) {
+            fits = span_copy(config->snapshot, sizeof(config->snapshot), value);
+            config->has_snapshot = true;
+        } else {
+            parse_error(parser, "unknown key", key);
+        }
+        break;
+
+    case APP_CONFIG_SECTION_LIGHT: {
+        app_config_light_t *light = &config->lights[config->num_lights - 1];
+        if (span_eq(key, "name")) {
+            fits = span_copy(light->name, sizeof(light->name), value);
+        } else if (span_eq(key, "type")) {
+            if (span_eq(value, "switch")) {
+                light->type = LIGHT_TYPE_SWITCH;
+            } else if (span_eq(value, "color")) {
+                light->type = LIGHT_TYPE_COLOR;
+            } else {
+                parse_error(parser, "unknown light type", value);
+            }
+        } else {
+            parse_error(parser, "unknown key", key);
+        }
+        break;
+    }
+
+    case APP_CONFIG_SECTION_GROUP: {
+        app_config_group_t *group = &config->groups[config->num_groups - 1];
+        if (span_eq(key, "area")) {
+            fits = span_copy(group->area_id, sizeof(group->area_id), value);
+        } else if (span_eq(key, "lights")) {
+            fits = span_copy(group->members, sizeof(group->members), value);
+        } else {
+            parse_error(parser, "unknown key", key);
+        }
+        break;
+    }
+
+    case APP_CONFIG_SECTION_NONE:
+        parse_error(parser, "key outside a section", key);
+        break;
+
+    case APP_CONFIG_SECTION_UNKNOWN:
+        /* Already reported at the section header */
+        break;
+    }
+
+    if (!fits) {
+        parse_error(parser, "value too long", value);
+    }
+}
+
+/**
+ * Parse the whole file, line by line
+ */
+static bool parse_text(app_config_parser_t *parser, app_config_t *config, const char *text, size_t size)
+{
+    app_config_section_t section = APP_CONFIG_SECTION_NONE;
+    const char *p = text;
+    const char *end = text + size;
+
+    while (p < end) {
+        const char *eol = memchr(p, '\n', (size_t)(end - p));
+        if (!eol) {
+            eol = end;
+        }
+        parser->line++;
+
+        app_config_span_t line = span_trim(p, eol);
+        p = eol + 1;
+
+        /* A comment may also follow a value after a blank */
+        for (size_t i = 1; i < line.len; i++) {
+            if ((line.p[i] == '#' || line.p[i] == ';') && (line.p[i - 1] == ' ' || line.p[i - 1] == '\t')) {
+                line = span_trim(line.p, line.p + i);
+                break;
+            }
+        }
+
+        if (line.len == 0 || line.p[0] == '#' || line.p[0] == ';') {
+            continue;
+        }
+
+        if (line.p[0] == '[') {
+            if (line.p[line.len - 1] != ']') {
+                parse_error(parser, "unterminated section", line);
+                section = APP_CONFIG_SECTION_UNKNOWN;
+                continue;
+            }
+            section = parse_section(parser, config, span_trim(line.p + 1, line.p + line.len - 1));
+            continue;
+        }
+
+        const char *eq = memchr(line.p, '=', line.len);
+        if (!eq) {
+            parse_error(parser, "expected key = value, got", line);
+            continue;
+        }
+        parse_value(parser, config, section, span_trim(line.p, eq), span_trim(eq + 1, line.p + line.len));
+    }
+
+    return parser->ok;
+}
+
+/**
+ * Load and parse a configuration file
+ */
+bool app_config_load(const char *path, app_config_t *config)
+{
+    if (!path || !config) {
+        return false;
+    }
+    memset(config, 0, sizeof(*config));
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno != ENOENT) {
+            fprintf(stderr, "Config: cannot open %s: %s\n", path, strerror(errno));
+        }
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror("fstat");
+        close(fd);
+        return false;
+    }
+
+    app_config_parser_t parser = {path, 0, true};
+    if (st.st_size == 0) {
+        close(fd);
+        return true;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return false;
+    }
+
+    bool ok = parse_text(&parser, config, (const char *)map, size);
+    munmap(map, size);
+    return ok;
+}
+
+/**
+ * Watch a configuration file for changes
+ */
+int app_config_watch(const char *path)
+{
+    char dir[512];
+    const char *slash = path ? strrchr(path, '/') : NULL;
+
+    if (!path || !path[0]) {
+        return -1;
+    }
+    if (slash) {
+        snprintf(dir, sizeof(dir), "%.*s", slash == path ? 1 : (int)(slash - path), path);
+        snprintf(watch_name, sizeof(watch_name), "%s", slash + 1);
+    } else {
+        snprintf(dir, sizeof(dir), ".");
+        snprintf(watch_name, sizeof(watch_name), "%s", path);
+    }
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        perror("inotify_init1");
+        return -1;
+    }
+    if (inotify_add_watch(fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        fprintf(stderr, "Config: cannot watch %s: %s\n", dir, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Drain the watch descriptor
+ */
+bool app_config_changed(int fd)
+{
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool changed = false;
+    ssize_t len;
+
+    while ((len = read(fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + len; ) {
+            const struct inotify_event *event = (const struct inotify_event *)p;
+            if (event->len > 0 && strcmp(event->name, watch_name) == 0) {
+                changed = true;
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file app_config.h
+ * Runtime dashboard configuration file
+ *
+ * INI style text file, one "key = value" per line, '#' or ';' starts a
+ * comment line:
+ *
+ *   [homeassistant]
+ *   url = http://homeassistant.local:8123
+ *   token = ...
+ *
+ *   [dashboard]
+ *   title = Downstairs
+ *   columns = 3          # 0: as many as fit
+ *   snapshot = /var/cache/dashboard/lights.snapshot
+ *
+ *   [light.kitchen_rgb]  # Listed lights are shown in this order, others are hidden
+ *   name = Kitchen
+ *   type = color         # switch or color, default: as reported
+ *
+ *   [group Downstairs]
+ *   lights = light.kitchen_rgb, light.hallway
+ *   area = living_room   # Optional: one call targets the whole area
+ *
+ * The file is mapped and parsed in one pass straight into fixed-size
+ * fields; nothing is allocated.
+ */
+
+#ifndef APP_CONFIG_H
+#define APP_CONFIG_H
+
+#include "dashboard.h"
+#include <stdbool.h>
+
+/* Longest member list of a group */
+#define APP_CONFIG_MEMBERS_MAX 1024
+
+/* Light listed in the configuration */
+typedef struct {
+    char entity_id[64];
+    char name[64];       /* Empty: name reported by Home Assistant */
+    int type;            /* light_type_t, or -1 for the reported type */
+} app_config_light_t;
+
+/* Group card listed in the configuration */
+typedef struct {
+    char name[64];
+    char area_id[64];    /* Empty: the group targets its members */
+    char members[APP_CONFIG_MEMBERS_MAX];  /* Comma separated entity IDs */
+} app_config_group_t;
+
+/* Parsed configuration file */
+typedef struct app_config {
+    char ha_url[256];    /* Empty when not set */
+    char ha_token[256];
+    char snapshot[256];
+    bool has_snapshot;   /* snapshot was set, possibly to "" (disabled) */
+    char title[64];
+    int columns;         /* Most card columns, 0 for as many as fit */
+    int num_lights;      /* 0: every light Home Assistant reports */
+    app_config_light_t lights[DASHBOARD_MAX_LIGHTS];
+    int num_groups;
+    app_config_group_t groups[DASHBOARD_MAX_GROUPS];
+} app_config_t;
+
+/**
+ * Load and parse a configuration file
+ * @param path Configuration file
+ * @param config Output configuration, cleared first
+ * @return false if the file is missing or has errors (reported on stderr)
+ */
+bool app_config_load(const char *path, app_config_t *config);
+
+/**
+ * Watch a configuration file for changes with inotify. The directory is
+ * watched, so editors that replace the file are noticed too, and the file
+ * does not have to exist yet.
+ * @param path Configuration file
+ * @return Descriptor readable on changes, or -1
+ */
+int app_config_watch(const char *path);
+
+/**
+ * Drain the watch descriptor
+ * @param fd Descriptor from app_config_watch
+ * @return true if the watched file was written or replaced
+ */
+bool app_config_changed(int fd);
+
+#endif /* APP_CONFIG_H */
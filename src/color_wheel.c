@@ -0,0 +1,311 @@
+/**
+ * @file color_wheel.c
+ * Hue/saturation color wheel picker implementation
+ */
+
+#include "color_wheel.h"
+#include "theme.h"
+#include "mem_stats.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define WHEEL_HALF (COLOR_WHEEL_SIZE / 2)
+
+/* Diameter of the selection marker */
+#define COLOR_WHEEL_MARKER_SIZE 14
+
+/* Hue error allowed between the marker and the pixel under it (rounding) */
+#define COLOR_WHEEL_CHECK_TOLERANCE 3
+
+/* Polar coordinates of a pixel of the upper right quadrant */
+typedef struct {
+    uint8_t angle;   /* 0-90 degrees from the horizontal axis */
+    uint8_t sat;     /* Distance from the center, 255 at the rim and beyond */
+    bool inside;     /* Pixel center lies on the disc */
+} wheel_polar_t;
+
+/* Per-wheel state */
+typedef struct {
+    uint16_t hue;    /* 0-359 */
+    uint8_t sat;     /* 0-255 */
+    bool tracking;   /* The current press started on the disc */
+    lv_obj_t *marker;
+} color_wheel_data_t;
+
+/* Shared by every wheel, built on first use */
+static wheel_polar_t polar[WHEEL_HALF][WHEEL_HALF];
+static lv_color32_t wheel_pixels[COLOR_WHEEL_SIZE * COLOR_WHEEL_SIZE];
+static lv_image_dsc_t wheel_image;
+static bool wheel_ready = false;
+
+/**
+ * Hue and saturation under a pixel of the wheel
+ * @return true if the pixel lies on the disc
+ */
+static bool wheel_lookup(int32_t x, int32_t y, uint16_t *hue, uint8_t *sat)
+{
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x >= COLOR_WHEEL_SIZE) x = COLOR_WHEEL_SIZE - 1;
+    if (y >= COLOR_WHEEL_SIZE) y = COLOR_WHEEL_SIZE - 1;
+
+    bool right = x >= WHEEL_HALF;
+    bool top = y < WHEEL_HALF;
+    const wheel_polar_t *p = &polar[top ? WHEEL_HALF - 1 - y : y - WHEEL_HALF]
+                                   [right ? x - WHEEL_HALF : WHEEL_HALF - 1 - x];
+
+    /* Fold the quadrant angle: hue 0 points right and grows counterclockwise */
+    if (right) {
+        *hue = top ? p->angle : (uint16_t)((360 - p->angle) % 360);
+    } else {
+        *hue = top ? (uint16_t)(180 - p->angle) : (uint16_t)(180 + p->angle);
+    }
+    *sat = p->sat;
+    return p->inside;
+}
+
+/**
+ * Convert hue/saturation at full value to RGB
+ */
+static void hsv_to_rgb(uint16_t hue, uint8_t sat, uint8_t *red, uint8_t *green, uint8_t *blue)
+{
+    uint32_t sector = hue / 60;
+    uint32_t rem = (hue % 60) * 255 / 60;
+    uint8_t p = (uint8_t)(255 - sat);
+    uint8_t q = (uint8_t)(255 - sat * rem / 255);
+    uint8_t t = (uint8_t)(255 - sat * (255 - rem) / 255);
+
+    switch (sector) {
+        case 0:  *red = 255; *green = t;   *blue = p;   break;
+        case 1:  *red = q;   *green = 255; *blue = p;   break;
+        case 2:  *red = p;   *green = 255; *blue = t;   break;
+        case 3:  *red = p;   *green = q;   *blue = 255; break;
+        case 4:  *red = t;   *green = p;   *blue = 255; break;
+        default: *red = 255; *green = p;   *blue = q;   break;
+    }
+}
+
+/**
+ * Convert RGB to hue/saturation, ignoring the value
+ */
+static void rgb_to_hs(uint8_t red, uint8_t green, uint8_t blue, uint16_t *hue, uint8_t *sat)
+{
+    int32_t max = red > green ? (red > blue ? red : blue) : (green > blue ? green : blue);
+    int32_t min = red < green ? (red < blue ? red : blue) : (green < blue ? green : blue);
+    int32_t delta = max - min;
+    int32_t h;
+
+    if (delta == 0) {
+        *hue = 0;
+        *sat = 0;
+        return;
+    }
+
+    if (max == red) {
+        h = 60 * (green - blue) / delta;
+    } else if (max == green) {
+        h = 120 + 60 * (blue - red) / delta;
+    } else {
+        h = 240 + 60 * (red - green) / delta;
+    }
+    *hue = (uint16_t)((h + 360) % 360);
+    *sat = (uint8_t)(delta * 255 / max);
+}
+
+/**
+ * Pixel of the wheel showing a hue and saturation
+ */
+static void wheel_marker_center(uint16_t hue, uint8_t sat, int32_t *x, int32_t *y)
+{
+    int32_t radius = (int32_t)sat * WHEEL_HALF / 255;
+    *x = WHEEL_HALF + lv_trigo_cos((int16_t)hue) * radius / (1 << LV_TRIGO_SHIFT);
+    *y = WHEEL_HALF - lv_trigo_sin((int16_t)hue) * radius / (1 << LV_TRIGO_SHIFT);
+}
+
+/**
+ * Check that the marker of each axis hue lands on pixels of that hue
+ * @return true if the polar table and the marker agree
+ */
+static bool wheel_check(void)
+{
+    static const uint16_t axis_hues[] = { 0, 90, 180, 270 };
+    bool ok = true;
+
+    for (size_t k = 0; k < sizeof(axis_hues) / sizeof(axis_hues[0]); k++) {
+        int32_t x;
+        int32_t y;
+        uint16_t hue;
+        uint8_t sat;
+        wheel_marker_center(axis_hues[k], 200, &x, &y);
+        wheel_lookup(x, y, &hue, &sat);
+
+        int diff = (hue - axis_hues[k] + 360) % 360;
+        if (diff > 180) {
+            diff = 360 - diff;
+        }
+        if (diff > COLOR_WHEEL_CHECK_TOLERANCE) {
+            printf("Warning: color wheel marker for hue %u lies on hue %u\n", axis_hues[k], hue);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+/**
+ * Build the polar table and rasterize the disc (once)
+ */
+static void wheel_init(void)
+{
+    if (wheel_ready) {
+        return;
+    }
+
+    /* Pixel centers in half pixels, so the rim is at COLOR_WHEEL_SIZE */
+    for (int ay = 0; ay < WHEEL_HALF; ay++) {
+        for (int ax = 0; ax < WHEEL_HALF; ax++) {
+            uint32_t px = (uint32_t)(2 * ax + 1);
+            uint32_t py = (uint32_t)(2 * ay + 1);
+            uint32_t dist2 = px * px + py * py;
+            lv_sqrt_res_t dist;
+            lv_sqrt(dist2, &dist, 0x8000);
+
+            uint32_t sat = (uint32_t)dist.i * 255 / COLOR_WHEEL_SIZE;
+            polar[ay][ax].angle = (uint8_t)lv_atan2((int)py, (int)px);
+            polar[ay][ax].sat = (uint8_t)(sat > 255 ? 255 : sat);
+            polar[ay][ax].inside = dist2 <= (uint32_t)COLOR_WHEEL_SIZE * COLOR_WHEEL_SIZE;
+        }
+    }
+
+    for (int y = 0; y < COLOR_WHEEL_SIZE; y++) {
+        for (int x = 0; x < COLOR_WHEEL_SIZE; x++) {
+            lv_color32_t *px = &wheel_pixels[y * COLOR_WHEEL_SIZE + x];
+            uint16_t hue;
+            uint8_t sat;
+            px->alpha = wheel_lookup(x, y, &hue, &sat) ? 255 : 0;
+            hsv_to_rgb(hue, sat, &px->red, &px->green, &px->blue);
+        }
+    }
+
+    memset(&wheel_image, 0, sizeof(wheel_image));
+    wheel_image.header.magic = LV_IMAGE_HEADER_MAGIC;
+    wheel_image.header.cf = LV_COLOR_FORMAT_ARGB8888;
+    wheel_image.header.w = COLOR_WHEEL_SIZE;
+    wheel_image.header.h = COLOR_WHEEL_SIZE;
+    wheel_image.header.stride = COLOR_WHEEL_SIZE * sizeof(lv_color32_t);
+    wheel_image.data_size = sizeof(wheel_pixels);
+    wheel_image.data = (const uint8_t *)wheel_pixels;
+    wheel_ready = true;
+    wheel_check();
+}
+
+/**
+ * Move the marker to the selected hue and saturation
+ */
+static void wheel_place_marker(color_wheel_data_t *data)
+{
+    int32_t x;
+    int32_t y;
+    wheel_marker_center(data->hue, data->sat, &x, &y);
+
+    lv_obj_set_pos(data->marker, x - COLOR_WHEEL_MARKER_SIZE / 2, y - COLOR_WHEEL_MARKER_SIZE / 2);
+}
+
+/**
+ * Press and drag handler
+ */
+static void wheel_event_handler(lv_event_t *e)
+{
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t *wheel = lv_event_get_current_target(e);
+    color_wheel_data_t *data = (color_wheel_data_t *)lv_obj_get_user_data(wheel);
+
+    if (code == LV_EVENT_DELETE) {
+        lv_free(data);
+        lv_obj_set_user_data(wheel, NULL);
+        return;
+    }
+
+    lv_point_t point;
+    lv_area_t coords;
+    uint16_t hue;
+    uint8_t sat;
+
+    lv_indev_get_point(lv_indev_active(), &point);
+    lv_obj_get_coords(wheel, &coords);
+    bool inside = wheel_lookup(point.x - coords.x1, point.y - coords.y1, &hue, &sat);
+
+    /* Presses in the corners are ignored; a drag leaving the disc follows its rim */
+    if (code == LV_EVENT_PRESSED) {
+        data->tracking = inside;
+    }
+    if (!data->tracking || (hue == data->hue && sat == data->sat)) {
+        return;
+    }
+
+    data->hue = hue;
+    data->sat = sat;
+    wheel_place_marker(data);
+    lv_obj_send_event(wheel, LV_EVENT_VALUE_CHANGED, NULL);
+}
+
+/**
+ * Create a color wheel
+ */
+lv_obj_t *color_wheel_create(lv_obj_t *parent)
+{
+    color_wheel_data_t *data = (color_wheel_data_t *)lv_malloc(sizeof(color_wheel_data_t));
+    if (!data) {
+        mem_stats_failure("color wheel");
+        return NULL;
+    }
+    memset(data, 0, sizeof(*data));
+
+    wheel_init();
+
+    lv_obj_t *wheel = lv_image_create(parent);
+    lv_image_set_src(wheel, &wheel_image);
+    lv_obj_add_flag(wheel, LV_OBJ_FLAG_CLICKABLE);
+    /* Dragging picks a color instead of scrolling the dashboard */
+    lv_obj_clear_flag(wheel, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_clear_flag(wheel, LV_OBJ_FLAG_SCROLL_CHAIN);
+    lv_obj_set_user_data(wheel, data);
+
+    data->marker = lv_obj_create(wheel);
+    lv_obj_remove_style_all(data->marker);
+    lv_obj_set_size(data->marker, COLOR_WHEEL_MARKER_SIZE, COLOR_WHEEL_MARKER_SIZE);
+    theme_add(data->marker, THEME_MARKER, 0);
+    lv_obj_clear_flag(data->marker, LV_OBJ_FLAG_CLICKABLE);
+    wheel_place_marker(data);
+
+    lv_obj_add_event_cb(wheel, wheel_event_handler, LV_EVENT_PRESSED, NULL);
+    lv_obj_add_event_cb(wheel, wheel_event_handler, LV_EVENT_PRESSING, NULL);
+    lv_obj_add_event_cb(wheel, wheel_event_handler, LV_EVENT_DELETE, NULL);
+    return wheel;
+}
+
+/**
+ * Select the hue and saturation of a color
+ */
+void color_wheel_set_rgb(lv_obj_t *wheel, uint8_t red, uint8_t green, uint8_t blue)
+{
+    color_wheel_data_t *data = (color_wheel_data_t *)lv_obj_get_user_data(wheel);
+    if (!data) return;
+
+    rgb_to_hs(red, green, blue, &data->hue, &data->sat);
+    wheel_place_marker(data);
+}
+
+/**
+ * Get the selected color at full value
+ */
+void color_wheel_get_rgb(lv_obj_t *wheel, uint8_t *red, uint8_t *green, uint8_t *blue)
+{
+    color_wheel_data_t *data = (color_wheel_data_t *)lv_obj_get_user_data(wheel);
+    if (!data) {
+        *red = *green = *blue = 255;
+        return;
+    }
+
+    hsv_to_rgb(data->hue, data->sat, red, green, blue);
+}
@@ -0,0 +1,48 @@
+/**
+ * @file color_wheel.h
+ * Hue/saturation color wheel picker
+ *
+ * The disc is rasterized once into a static ARGB8888 image that every wheel
+ * shows, so creating a card or drawing a frame never redraws it. Touches
+ * are mapped to hue and saturation through a precomputed polar table of
+ * one quadrant, folded by symmetry; picking does no trigonometry.
+ *
+ * A wheel sends LV_EVENT_VALUE_CHANGED while it is dragged and
+ * LV_EVENT_RELEASED when it is let go.
+ */
+
+#ifndef COLOR_WHEEL_H
+#define COLOR_WHEEL_H
+
+#include "lvgl/lvgl.h"
+#include <stdint.h>
+
+/* Diameter of the wheel in pixels (even) */
+#define COLOR_WHEEL_SIZE 120
+
+/**
+ * Create a color wheel
+ * @param parent Parent object
+ * @return Wheel object, or NULL if out of memory
+ */
+lv_obj_t *color_wheel_create(lv_obj_t *parent);
+
+/**
+ * Select the hue and saturation of a color (its value is ignored)
+ * @param wheel Wheel object
+ * @param red Red component (0-255)
+ * @param green Green component (0-255)
+ * @param blue Blue component (0-255)
+ */
+void color_wheel_set_rgb(lv_obj_t *wheel, uint8_t red, uint8_t green, uint8_t blue);
+
+/**
+ * Get the selected color at full value
+ * @param wheel Wheel object
+ * @param red Output red component (0-255)
+ * @param green Output green component (0-255)
+ * @param blue Output blue component (0-255)
+ */
+void color_wheel_get_rgb(lv_obj_t *wheel, uint8_t *red, uint8_t *green, uint8_t *blue);
+
+#endif /* COLOR_WHEEL_H */
@@ -6,15 +6,42 @@
 #include "dashboard.h"
 #include "light_control.h"
 #include "ha_api.h"
+#include "light_coalescer.h"
+#include "entity_registry.h"
+#include "theme.h"
+#include "mem_stats.h"
+#include "light_snapshot.h"
+#include "app_config.h"
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
+
+/* With more lights than this only the cards in view are instantiated */
+#define DASHBOARD_VIRTUAL_MIN_LIGHTS 24
+
+/* Rows kept instantiated above and below the viewport */
+#define DASHBOARD_OVERSCAN_ROWS 1
+
+/* Gap between cards */
+#define DASHBOARD_CARD_GAP 15
+
+/* Group card row below the title */
+#define DASHBOARD_GROUP_BAR_Y 60
+#define DASHBOARD_GROUP_BAR_HEIGHT 90
+#define DASHBOARD_GROUP_CARD_HEIGHT 80
+
+/* Screen title unless the configuration sets one */
+#define DASHBOARD_TITLE "Home Assistant Light Dashboard"
+
+/* A changed light list is written to the snapshot at most this often */
+#define DASHBOARD_SNAPSHOT_DELAY_MS 2000
 
 /* Dashboard data */
 static lv_obj_t *dashboard_screen = NULL;
 static lv_obj_t *light_container = NULL;
 
-/* Sample lights for demonstration */
-static light_state_t lights[] = {
+/* Sample lights, used when Home Assistant cannot be reached */
+static const light_state_t sample_lights[] = {
     {
         .name = "Living Room",
         .entity_id = "light.living_room",
@@ -61,12 +88,1135 @@ static light_state_t lights[] = {
     }
 };
 
-static const int num_lights = sizeof(lights) / sizeof(lights[0]);
+/* Lights shown on the dashboard, filled once at startup. The entity
+ * registry maps each light's handle to its index here and to its card
+ * (NULL while it is scrolled out of view). */
+static light_state_t lights[DASHBOARD_MAX_LIGHTS];
+static int num_lights = 0;
+
+/* Virtualized grid: cards are positioned by row and recycled as rows
+ * scroll in and out of view, so the number of cards only depends on the
+ * viewport size */
+static bool grid_virtual = false;
+static int grid_cols = 1;
+static int grid_rows = 0;
+static int32_t grid_row_y[DASHBOARD_MAX_LIGHTS + 1];  /* Row tops, [grid_rows] is the total height */
+static int grid_first_row = 0;                        /* Bound rows, empty when first > last */
+static int grid_last_row = -1;
+static lv_obj_t *grid_spacer = NULL;                  /* Sets the scrollable height */
+static bool grid_expanded[DASHBOARD_MAX_LIGHTS];      /* Color controls shown, survives card recycling */
+static lv_obj_t *grid_rebind_card[DASHBOARD_MAX_LIGHTS]; /* Bound card whose slot got another light */
+
+/* Group card: one command fanned out to several lights */
+typedef struct {
+    char area_id[64];                           /* Empty: members are targeted by entity_id */
+    int num_members;
+    int num_on;
+    entity_handle_t members[DASHBOARD_MAX_LIGHTS];
+    lv_obj_t *card;                             /* NULL: free slot */
+    lv_obj_t *status_label;
+    lv_obj_t *switch_btn;
+    lv_obj_t *brightness_slider;
+    int32_t heap_bytes;                         /* Charged to MEM_STATS_GROUPS */
+    bool all;                                   /* Follows the light list ("All lights") */
+    bool from_config;                           /* Rebuilt when the configuration changes */
+} dashboard_group_t;
+
+static lv_obj_t *group_bar = NULL;
+static dashboard_group_t groups[DASHBOARD_MAX_GROUPS];
+static int num_groups = 0;
+static uint8_t light_groups[DASHBOARD_MAX_LIGHTS];    /* Bit per group a light belongs to */
+static uint8_t groups_dirty = 0;                      /* Groups whose card needs a refresh */
+static bool groups_deferred = false;                  /* Refresh once after a fan-out */
+
+/* Warm start: lights[] is saved here and shown from it on the next start
+ * while the live states load in the background */
+static char snapshot_path[256] = {0};                 /* Empty: no snapshot */
+static lv_timer_t *snapshot_timer = NULL;
+static bool snapshot_dirty = false;
+static light_state_t live_lights[DASHBOARD_MAX_LIGHTS];
+static uint8_t live_fields[DASHBOARD_MAX_LIGHTS];
+
+/* Runtime configuration: light list, groups and layout. The groups it was
+ * last applied with are kept to rebuild their cards only when they change. */
+static const app_config_t *config = NULL;
+static lv_obj_t *title_label = NULL;
+static int max_columns = 0;                           /* 0: as many as fit */
+static app_config_group_t applied_groups[DASHBOARD_MAX_GROUPS];
+static int num_applied_groups = 0;
+static light_state_t staged_lights[DASHBOARD_MAX_LIGHTS];
+static uint8_t staged_fields[DASHBOARD_MAX_LIGHTS];
 
 /**
- * Initialize the dashboard UI
+ * Write lights[] to the snapshot
  */
-void dashboard_init(lv_obj_t *parent)
+static void snapshot_save(void)
+{
+    snapshot_dirty = false;
+    if (snapshot_timer) {
+        lv_timer_pause(snapshot_timer);
+    }
+    if (snapshot_path[0]) {
+        light_snapshot_save(snapshot_path, lights, num_lights);
+    }
+}
+
+/**
+ * Debounce timer: the light states settled
+ */
+static void snapshot_timer_cb(lv_timer_t *timer)
+{
+    (void)timer;
+    snapshot_save();
+}
+
+/**
+ * Schedule a snapshot write; a burst of changes (slider drags) costs one
+ */
+static void snapshot_mark_dirty(void)
+{
+    if (!snapshot_timer || snapshot_dirty) {
+        return;
+    }
+    snapshot_dirty = true;
+    lv_timer_reset(snapshot_timer);
+    lv_timer_resume(snapshot_timer);
+}
+
+/**
+ * Card currently showing lights[i], or NULL
+ */
+static lv_obj_t *card_at(int i)
+{
+    return (lv_obj_t *)entity_registry_get_card(lights[i].handle);
+}
+
+/**
+ * Intern every light and map its handle to its slot in lights[]
+ */
+static void dashboard_register_lights(void)
+{
+    int kept = 0;
+    
+    for (int i = 0; i < num_lights; i++) {
+        entity_handle_t handle = entity_registry_intern(lights[i].entity_id);
+        if (handle == ENTITY_HANDLE_INVALID) {
+            continue;
+        }
+        if (kept != i) {
+            lights[kept] = lights[i];
+        }
+        lights[kept].handle = handle;
+        entity_registry_set_slot(handle, kept);
+        /* The loaded state is the first one the server confirmed */
+        light_coalescer_reconcile(handle, &lights[kept],
+                                  HA_LIGHT_FIELD_POWER | HA_LIGHT_FIELD_BRIGHTNESS |
+                                  HA_LIGHT_FIELD_COLOR | HA_LIGHT_FIELD_COLOR_TEMP);
+        kept++;
+    }
+    num_lights = kept;
+}
+
+/**
+ * Height of the card of lights[i] in the virtualized grid
+ */
+static int32_t grid_card_height(int i)
+{
+    return grid_expanded[i] ? LIGHT_CARD_HEIGHT_COLOR : LIGHT_CARD_HEIGHT_SWITCH;
+}
+
+/**
+ * Compute the column count and row offsets for the current container width
+ */
+static void grid_layout(void)
+{
+    int32_t width = lv_obj_get_content_width(light_container);
+    
+    grid_cols = (int)((width + DASHBOARD_CARD_GAP) / (LIGHT_CARD_WIDTH + DASHBOARD_CARD_GAP));
+    if (max_columns > 0 && grid_cols > max_columns) {
+        grid_cols = max_columns;
+    }
+    if (grid_cols < 1) {
+        grid_cols = 1;
+    }
+    grid_rows = (num_lights + grid_cols - 1) / grid_cols;
+    
+    /* A row is as tall as its tallest card */
+    grid_row_y[0] = 0;
+    for (int row = 0; row < grid_rows; row++) {
+        int32_t height = LIGHT_CARD_HEIGHT_SWITCH;
+        for (int i = row * grid_cols; i < num_lights && i < (row + 1) * grid_cols; i++) {
+            if (grid_card_height(i) > height) {
+                height = grid_card_height(i);
+            }
+        }
+        grid_row_y[row + 1] = grid_row_y[row] + height + DASHBOARD_CARD_GAP;
+    }
+    
+    lv_obj_set_pos(grid_spacer, 0, grid_row_y[grid_rows] > 0 ? grid_row_y[grid_rows] - 1 : 0);
+}
+
+/**
+ * Row containing the given y offset
+ */
+static int grid_row_at(int32_t y)
+{
+    int low = 0;
+    int high = grid_rows - 1;
+    
+    while (low < high) {
+        int mid = (low + high + 1) / 2;
+        if (grid_row_y[mid] <= y) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return low;
+}
+
+/**
+ * Return the cards of a row to the card pool
+ */
+static void grid_release_row(int row)
+{
+    for (int i = row * grid_cols; i < num_lights && i < (row + 1) * grid_cols; i++) {
+        lv_obj_t *card = card_at(i);
+        if (card) {
+            light_control_release_card(card);
+            entity_registry_set_card(lights[i].handle, NULL);
+        }
+    }
+}
+
+/**
+ * Bind a card (pooled when possible) to every light of a row
+ */
+static void grid_bind_row(int row)
+{
+    for (int i = row * grid_cols; i < num_lights && i < (row + 1) * grid_cols; i++) {
+        if (card_at(i)) {
+            continue;
+        }
+        
+        lv_obj_t *card = light_control_acquire_card(light_container, &lights[i]);
+        if (!card) {
+            printf("Error: Failed to create light card for %s\n", lights[i].name);
+            continue;
+        }
+        
+        light_control_set_expanded(card, grid_expanded[i]);
+        lv_obj_set_height(card, grid_card_height(i));
+        lv_obj_set_pos(card, (i % grid_cols) * (LIGHT_CARD_WIDTH + DASHBOARD_CARD_GAP), grid_row_y[row]);
+        entity_registry_set_card(lights[i].handle, card);
+    }
+}
+
+/**
+ * Bind the rows in view (plus overscan) and release the others
+ */
+static void grid_update_viewport(void)
+{
+    if (grid_rows == 0) {
+        return;
+    }
+    
+    int32_t top = lv_obj_get_scroll_y(light_container);
+    int32_t bottom = top + lv_obj_get_content_height(light_container);
+    
+    int first = grid_row_at(top) - DASHBOARD_OVERSCAN_ROWS;
+    int last = grid_row_at(bottom) + DASHBOARD_OVERSCAN_ROWS;
+    if (first < 0) {
+        first = 0;
+    }
+    if (last > grid_rows - 1) {
+        last = grid_rows - 1;
+    }
+    if (first == grid_first_row && last == grid_last_row) {
+        return;
+    }
+    
+    /* Release first so the bound rows can reuse those cards */
+    for (int row = grid_first_row; row <= grid_last_row; row++) {
+        if (row < first || row > last) {
+            grid_release_row(row);
+        }
+    }
+    for (int row = first; row <= last; row++) {
+        grid_bind_row(row);
+    }
+    
+    grid_first_row = first;
+    grid_last_row = last;
+}
+
+/**
+ * A card was expanded or collapsed: in the virtualized grid the rows below
+ * it move (flex layouts follow the card's content size by themselves)
+ */
+static void grid_card_expanded(lv_obj_t *card, light_state_t *light, bool expanded, void *user_data)
+{
+    (void)card;
+    (void)user_data;
+    
+    int slot = entity_registry_get_slot(light->handle);
+    if (!grid_virtual || slot < 0 || slot >= num_lights) {
+        return;
+    }
+    
+    grid_expanded[slot] = expanded;
+    grid_layout();
+    for (int row = grid_first_row; row <= grid_last_row; row++) {
+        for (int i = row * grid_cols; i < num_lights && i < (row + 1) * grid_cols; i++) {
+            lv_obj_t *bound = card_at(i);
+            if (bound) {
+                lv_obj_set_height(bound, grid_card_height(i));
+                lv_obj_set_y(bound, grid_row_y[row]);
+            }
+        }
+    }
+    grid_update_viewport();
+}
+
+/**
+ * Return every bound card to the pool and lay the grid out again
+ */
+static void grid_reset(void)
+{
+    for (int row = grid_first_row; row <= grid_last_row; row++) {
+        grid_release_row(row);
+    }
+    grid_first_row = 0;
+    grid_last_row = -1;
+    grid_layout();
+}
+
+/**
+ * Before the light list is replaced: keep the bound cards whose slot shows
+ * the same light, set aside those whose slot gets another light of the same
+ * type and return the others to the pool
+ * @param next New light list
+ * @param count Number of lights in next
+ */
+static void grid_release_changed(const light_state_t *next, int count)
+{
+    for (int row = grid_first_row; row <= grid_last_row; row++) {
+        for (int i = row * grid_cols; i < num_lights && i < (row + 1) * grid_cols; i++) {
+            lv_obj_t *card = card_at(i);
+            grid_rebind_card[i] = NULL;
+            if (!card) {
+                continue;
+            }
+            if (i < count && next[i].handle == lights[i].handle && next[i].type == lights[i].type &&
+                strcmp(next[i].name, lights[i].name) == 0) {
+                continue;
+            }
+            
+            entity_registry_set_card(lights[i].handle, NULL);
+            if (i < count && next[i].type == lights[i].type) {
+                grid_rebind_card[i] = card;
+            } else {
+                light_control_release_card(card);
+            }
+        }
+    }
+}
+
+/**
+ * After the light list is replaced: bind the cards set aside by
+ * grid_release_changed to their slot's new light, move the bound cards to
+ * the new row offsets and fill the empty slots
+ */
+static void grid_rebind(void)
+{
+    grid_layout();
+    if (grid_last_row > grid_rows - 1) {
+        grid_last_row = grid_rows - 1;
+    }
+    
+    for (int row = grid_first_row; row <= grid_last_row; row++) {
+        for (int i = row * grid_cols; i < num_lights && i < (row + 1) * grid_cols; i++) {
+            lv_obj_t *card = card_at(i);
+            if (grid_rebind_card[i] && card) {
+                light_control_release_card(grid_rebind_card[i]);
+            } else if (grid_rebind_card[i]) {
+                card = grid_rebind_card[i];
+                light_control_bind_card(card, &lights[i]);
+                light_control_set_expanded(card, grid_expanded[i]);
+                entity_registry_set_card(lights[i].handle, card);
+            }
+            grid_rebind_card[i] = NULL;
+            if (card) {
+                lv_obj_set_height(card, grid_card_height(i));
+                lv_obj_set_y(card, grid_row_y[row]);
+            }
+        }
+        grid_bind_row(row);
+    }
+    
+    grid_update_viewport();
+}
+
+/**
+ * Scroll and resize handler of the virtualized light container
+ */
+static void grid_event_handler(lv_event_t *e)
+{
+    lv_event_code_t code = lv_event_get_code(e);
+    
+    if (code == LV_EVENT_SIZE_CHANGED) {
+        /* The column count may change: start over with all cards free */
+        grid_reset();
+    }
+    
+    grid_update_viewport();
+}
+
+/**
+ * Wrap the flex layout after max_columns cards
+ */
+static void flex_apply_columns(void)
+{
+    for (int i = 0; i < num_lights; i++) {
+        lv_obj_t *card = card_at(i);
+        if (!card) {
+            continue;
+        }
+        if (max_columns > 0 && i > 0 && i % max_columns == 0) {
+            lv_obj_add_flag(card, LV_OBJ_FLAG_FLEX_IN_NEW_TRACK);
+        } else {
+            lv_obj_clear_flag(card, LV_OBJ_FLAG_FLEX_IN_NEW_TRACK);
+        }
+    }
+}
+
+/**
+ * Get a card for lights[i] in the flex layout
+ * @return The card, or NULL
+ */
+static lv_obj_t *flex_acquire_card(int i)
+{
+    lv_obj_t *card = light_control_acquire_card(light_container, &lights[i]);
+    if (!card) {
+        printf("Error: Failed to create light card for %s\n", lights[i].name);
+        return NULL;
+    }
+    
+    /* Cards recycled from the virtualized grid have a fixed height */
+    lv_obj_set_height(card, LV_SIZE_CONTENT);
+    light_control_set_expanded(card, grid_expanded[i]);
+    entity_registry_set_card(lights[i].handle, card);
+    return card;
+}
+
+/**
+ * Give every light a card in a wrapping flex layout
+ */
+static void flex_enable(void)
+{
+    lv_obj_set_flex_flow(light_container, LV_FLEX_FLOW_ROW_WRAP);
+    lv_obj_set_flex_align(light_container, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_START);
+    for (int i = 0; i < num_lights; i++) {
+        flex_acquire_card(i);
+    }
+    flex_apply_columns();
+}
+
+/**
+ * Return every card of the flex layout to the pool and drop the layout
+ */
+static void flex_disable(void)
+{
+    for (int i = 0; i < num_lights; i++) {
+        lv_obj_t *card = card_at(i);
+        if (card) {
+            light_control_release_card(card);
+            entity_registry_set_card(lights[i].handle, NULL);
+        }
+    }
+    lv_obj_set_layout(light_container, LV_LAYOUT_NONE);
+}
+
+/**
+ * Switch to the virtualized grid: no layout, cards are positioned by row
+ */
+static void grid_enable(void)
+{
+    grid_virtual = true;
+    light_control_set_expand_cb(grid_card_expanded, NULL);
+    grid_spacer = lv_obj_create(light_container);
+    lv_obj_remove_style_all(grid_spacer);
+    lv_obj_set_size(grid_spacer, 1, 1);
+    lv_obj_clear_flag(grid_spacer, LV_OBJ_FLAG_CLICKABLE);
+    
+    lv_obj_update_layout(light_container);
+    grid_first_row = 0;
+    grid_last_row = -1;
+    grid_layout();
+    grid_update_viewport();
+    
+    lv_obj_add_event_cb(light_container, grid_event_handler, LV_EVENT_SCROLL, NULL);
+    lv_obj_add_event_cb(light_container, grid_event_handler, LV_EVENT_SIZE_CHANGED, NULL);
+    
+    printf("Virtualized grid: %d lights in %d rows of %d\n", num_lights, grid_rows, grid_cols);
+}
+
+/**
+ * Leave the virtualized grid, returning its cards to the pool
+ */
+static void grid_disable(void)
+{
+    for (int row = grid_first_row; row <= grid_last_row; row++) {
+        grid_release_row(row);
+    }
+    grid_first_row = 0;
+    grid_last_row = -1;
+    
+    while (lv_obj_remove_event_cb(light_container, grid_event_handler)) {
+    }
+    light_control_set_expand_cb(NULL, NULL);
+    lv_obj_delete(grid_spacer);
+    grid_spacer = NULL;
+    grid_virtual = false;
+}
+
+/**
+ * Make room on the heap for the cards of a light list
+ * @param count Number of lights
+ */
+static void dashboard_reserve_cards(int count)
+{
+    /* The virtualized grid only builds the cards in view, and its pools
+     * keep at most this many */
+    int max_cards = count;
+    if (count > DASHBOARD_VIRTUAL_MIN_LIGHTS && max_cards > LIGHT_CONTROL_POOL_SIZE * LIGHT_TYPE_COUNT) {
+        max_cards = LIGHT_CONTROL_POOL_SIZE * LIGHT_TYPE_COUNT;
+    }
+    mem_stats_reserve_cards(max_cards);
+}
+
+/**
+ * Create the cards, all of them or only those in view
+ */
+static void dashboard_create_cards(void)
+{
+    dashboard_reserve_cards(num_lights);
+    
+    if (num_lights > DASHBOARD_VIRTUAL_MIN_LIGHTS) {
+        grid_enable();
+    } else {
+        flex_enable();
+    }
+}
+
+/**
+ * Show how many lights of each changed group are on
+ */
+static void groups_refresh(void)
+{
+    for (int g = 0; g < num_groups; g++) {
+        if (!(groups_dirty & (1u << g)) || !groups[g].card) {
+            continue;
+        }
+        dashboard_group_t *group = &groups[g];
+        lv_label_set_text_fmt(group->status_label, "%d/%d on", group->num_on, group->num_members);
+        if (group->num_on > 0) {
+            lv_obj_add_state(group->switch_btn, LV_STATE_CHECKED);
+        } else {
+            lv_obj_clear_state(group->switch_btn, LV_STATE_CHECKED);
+        }
+    }
+    groups_dirty = 0;
+}
+
+/**
+ * Send one change to every light of a group
+ */
+static void group_command(dashboard_group_t *group, const light_state_t *state, uint8_t fields)
+{
+    /* The members' cards are updated through the coalescer's view
+     * callback; the group card is refreshed once at the end */
+    groups_deferred = true;
+    if (group->area_id[0]) {
+        ha_light_group_t target = {group->area_id, group->members, group->num_members};
+        light_coalescer_set_group(&target, state, fields);
+    } else {
+        for (int first = 0; first < group->num_members; first += HA_API_GROUP_MAX) {
+            int count = group->num_members - first;
+            ha_light_group_t target = {NULL, &group->members[first],
+                                       count < HA_API_GROUP_MAX ? count : HA_API_GROUP_MAX};
+            light_coalescer_set_group(&target, state, fields);
+        }
+    }
+    groups_deferred = false;
+    groups_refresh();
+}
+
+/**
+ * Group power switch handler
+ */
+static void group_switch_event_handler(lv_event_t *e)
+{
+    dashboard_group_t *group = (dashboard_group_t *)lv_event_get_user_data(e);
+    light_state_t state;
+    
+    memset(&state, 0, sizeof(state));
+    state.is_on = lv_obj_has_state(lv_event_get_target(e), LV_STATE_CHECKED);
+    group_command(group, &state, HA_LIGHT_FIELD_POWER);
+}
+
+/**
+ * Group brightness slider handler, sends on release
+ */
+static void group_brightness_event_handler(lv_event_t *e)
+{
+    dashboard_group_t *group = (dashboard_group_t *)lv_event_get_user_data(e);
+    light_state_t state;
+    
+    memset(&state, 0, sizeof(state));
+    state.is_on = true;
+    state.brightness = (uint8_t)lv_slider_get_value(lv_event_get_target(e));
+    group_command(group, &state, HA_LIGHT_FIELD_POWER | HA_LIGHT_FIELD_BRIGHTNESS);
+}
+
+/**
+ * Create a group card for the given lights in the first free group slot
+ * @return The group, or NULL
+ */
+static dashboard_group_t *group_create(const char *name, const char *area_id, const int *slots, int count)
+{
+    int g = 0;
+    
+    while (g < num_groups && groups[g].card) {
+        g++;
+    }
+    if (g >= DASHBOARD_MAX_GROUPS || count <= 0 || !group_bar) {
+        return NULL;
+    }
+    if (area_id && count > HA_API_GROUP_MAX) {
+        printf("Error: area group %s has more than %d lights\n", name, HA_API_GROUP_MAX);
+        return NULL;
+    }
+    
+    if (g == num_groups) {
+        num_groups++;
+    }
+    dashboard_group_t *group = &groups[g];
+    int brightness = 0;
+    
+    memset(group, 0, sizeof(*group));
+    snprintf(group->area_id, sizeof(group->area_id), "%s", area_id ? area_id : "");
+    for (int i = 0; i < count; i++) {
+        group->members[group->num_members++] = lights[slots[i]].handle;
+        group->num_on += lights[slots[i]].is_on;
+        brightness += lights[slots[i]].brightness;
+        light_groups[slots[i]] |= (uint8_t)(1u << g);
+    }
+    
+    size_t heap_before = mem_stats_used();
+    lv_obj_t *card = lv_obj_create(group_bar);
+    group->card = card;
+    lv_obj_set_size(card, LIGHT_CARD_WIDTH, DASHBOARD_GROUP_CARD_HEIGHT);
+    theme_add(card, THEME_GROUP_CARD, 0);
+    lv_obj_clear_flag(card, LV_OBJ_FLAG_SCROLLABLE);
+    
+    lv_obj_t *title = lv_label_create(card);
+    lv_label_set_text(title, name);
+    lv_obj_align(title, LV_ALIGN_TOP_LEFT, 0, 0);
+    
+    group->status_label = lv_label_create(card);
+    theme_add(group->status_label, THEME_TEXT_DIM, 0);
+    lv_obj_align(group->status_label, LV_ALIGN_TOP_RIGHT, 0, 0);
+    
+    group->switch_btn = lv_switch_create(card);
+    lv_obj_align(group->switch_btn, LV_ALIGN_BOTTOM_LEFT, 0, 0);
+    lv_obj_add_event_cb(group->switch_btn, group_switch_event_handler, LV_EVENT_VALUE_CHANGED, group);
+    
+    group->brightness_slider = lv_slider_create(card);
+    lv_obj_set_width(group->brightness_slider, 170);
+    theme_add(group->brightness_slider, THEME_SLIDER_INDICATOR, LV_PART_INDICATOR);
+    lv_obj_align(group->brightness_slider, LV_ALIGN_BOTTOM_RIGHT, -10, -8);
+    lv_slider_set_range(group->brightness_slider, 0, 255);
+    lv_slider_set_value(group->brightness_slider, brightness / count, LV_ANIM_OFF);
+    lv_obj_add_event_cb(group->brightness_slider, group_brightness_event_handler, LV_EVENT_RELEASED, group);
+    group->heap_bytes = (int32_t)(mem_stats_used() - heap_before);
+    mem_stats_charge(MEM_STATS_GROUPS, group->heap_bytes);
+    
+    groups_dirty |= (uint8_t)(1u << g);
+    groups_refresh();
+    return group;
+}
+
+/**
+ * Delete a group card and free its slot
+ */
+static void group_delete(dashboard_group_t *group)
+{
+    uint8_t bit = (uint8_t)(1u << (group - groups));
+    
+    for (int i = 0; i < num_lights; i++) {
+        light_groups[i] &= (uint8_t)~bit;
+    }
+    groups_dirty &= (uint8_t)~bit;
+    
+    lv_obj_delete(group->card);
+    mem_stats_charge(MEM_STATS_GROUPS, -group->heap_bytes);
+    memset(group, 0, sizeof(*group));
+}
+
+/**
+ * Create a group card for the lights with the given entity IDs
+ * @return The group, or NULL
+ */
+static dashboard_group_t *group_create_from_ids(const char *name, const char *area_id,
+                                                const char *const *entity_ids, int count)
+{
+    int slots[DASHBOARD_MAX_LIGHTS];
+    int num_slots = 0;
+    
+    /* Only lights on the dashboard can be fanned out to */
+    for (int i = 0; i < count && num_slots < DASHBOARD_MAX_LIGHTS; i++) {
+        int slot = entity_registry_get_slot(entity_registry_find(entity_ids[i]));
+        if (slot >= 0 && slot < num_lights) {
+            slots[num_slots++] = slot;
+        } else {
+            printf("Warning: group %s: unknown light %s\n", name, entity_ids[i]);
+        }
+    }
+    return group_create(name, area_id, slots, num_slots);
+}
+
+/**
+ * Create the "All lights" card; switching everything off takes one call
+ * per HA_API_GROUP_MAX lights
+ */
+static void group_create_all(void)
+{
+    static int all_slots[DASHBOARD_MAX_LIGHTS];
+    
+    for (int i = 0; i < num_lights; i++) {
+        all_slots[i] = i;
+    }
+    dashboard_group_t *group = group_create("All lights", NULL, all_slots, num_lights);
+    if (group) {
+        group->all = true;
+    }
+}
+
+/**
+ * Recompute group membership after the light list changed: members that
+ * left the dashboard are dropped, "All lights" follows the whole list
+ */
+static void groups_remap(void)
+{
+    bool has_all = false;
+    
+    memset(light_groups, 0, sizeof(light_groups));
+    
+    for (int g = 0; g < num_groups; g++) {
+        dashboard_group_t *group = &groups[g];
+        if (!group->card) {
+            continue;
+        }
+        if (group->all) {
+            for (int i = 0; i < num_lights; i++) {
+                group->members[i] = lights[i].handle;
+            }
+            group->num_members = num_lights;
+        }
+        
+        int kept = 0;
+        group->num_on = 0;
+        for (int m = 0; m < group->num_members; m++) {
+            int slot = entity_registry_get_slot(group->members[m]);
+            if (slot < 0 || slot >= num_lights) {
+                continue;
+            }
+            group->members[kept++] = group->members[m];
+            group->num_on += lights[slot].is_on;
+            light_groups[slot] |= (uint8_t)(1u << g);
+        }
+        group->num_members = kept;
+        groups_dirty |= (uint8_t)(1u << g);
+        has_all = has_all || group->all;
+    }
+    groups_refresh();
+    
+    if (!has_all && num_lights > 1) {
+        group_create_all();
+    }
+}
+
+/**
+ * Rebuild the group cards of the configuration if its groups changed
+ */
+static void groups_apply_config(void)
+{
+    int count = config ? config->num_groups : 0;
+    
+    if (count == num_applied_groups &&
+        memcmp(applied_groups, config ? config->groups : applied_groups, (size_t)count * sizeof(applied_groups[0])) == 0) {
+        return;
+    }
+    
+    for (int g = 0; g < num_groups; g++) {
+        if (groups[g].card && groups[g].from_config) {
+            group_delete(&groups[g]);
+        }
+    }
+    
+    num_applied_groups = count;
+    if (count > 0) {
+        memcpy(applied_groups, config->groups, (size_t)count * sizeof(applied_groups[0]));
+    }
+    
+    for (int g = 0; g < count; g++) {
+        /* Split the member list in place */
+        app_config_group_t *def = &applied_groups[g];
+        char members[APP_CONFIG_MEMBERS_MAX];
+        const char *ids[DASHBOARD_MAX_LIGHTS];
+        int num_ids = 0;
+        
+        memcpy(members, def->members, sizeof(members));
+        for (char *id = strtok(members, ", \t"); id && num_ids < DASHBOARD_MAX_LIGHTS; id = strtok(NULL, ", \t")) {
+            ids[num_ids++] = id;
+        }
+        
+        dashboard_group_t *group = group_create_from_ids(def->name, def->area_id[0] ? def->area_id : NULL,
+                                                         ids, num_ids);
+        if (group) {
+            group->from_config = true;
+        } else {
+            printf("Warning: group %s has no lights on the dashboard\n", def->name);
+        }
+    }
+}
+
+/**
+ * Count a light switching on or off in every group it belongs to
+ */
+static void groups_count_power(int i, bool is_on)
+{
+    for (int g = 0; g < num_groups; g++) {
+        if (light_groups[i] & (1u << g)) {
+            groups[g].num_on += is_on ? 1 : -1;
+            groups_dirty |= (uint8_t)(1u << g);
+        }
+    }
+}
+
+/**
+ * Show new values of some fields of a light on its card
+ */
+static void dashboard_show_state(const light_state_t *state, uint8_t fields, void *user_data)
+{
+    (void)user_data;
+    
+    int i = entity_registry_get_slot(state->handle);
+    if (i < 0 || i >= num_lights) {
+        return;
+    }
+    
+    /* Keep the last known attributes for fields the push did not carry */
+    light_state_t merged = lights[i];
+    if (fields & HA_LIGHT_FIELD_POWER) {
+        merged.is_on = state->is_on;
+    }
+    if (fields & HA_LIGHT_FIELD_BRIGHTNESS) {
+        merged.brightness = state->brightness;
+    }
+    if (fields & HA_LIGHT_FIELD_COLOR) {
+        merged.red = state->red;
+        merged.green = state->green;
+        merged.blue = state->blue;
+    }
+    if (fields & HA_LIGHT_FIELD_COLOR_TEMP) {
+        merged.color_temp = state->color_temp;
+    }
+    
+    if (merged.is_on != lights[i].is_on) {
+        groups_count_power(i, merged.is_on);
+    }
+    
+    lv_obj_t *card = card_at(i);
+    if (card) {
+        light_control_update_card(card, &merged);
+    } else {
+        lights[i] = merged;
+    }
+    
+    if (!groups_deferred) {
+        groups_refresh();
+    }
+    snapshot_mark_dirty();
+}
+
+/**
+ * The user switched a single card: count the light in its groups before the
+ * card writes the new state
+ */
+static void dashboard_card_power(light_state_t *light, bool is_on, void *user_data)
+{
+    (void)user_data;
+    
+    int i = entity_registry_get_slot(light->handle);
+    if (i < 0 || i >= num_lights || lights[i].is_on == is_on) {
+        return;
+    }
+    
+    groups_count_power(i, is_on);
+    if (!groups_deferred) {
+        groups_refresh();
+    }
+}
+
+/**
+ * Apply a state change pushed by Home Assistant to the matching card
+ */
+static void dashboard_state_changed(const light_state_t *state, uint8_t fields, void *user_data)
+{
+    /* Fields the user just changed keep their optimistic value until the
+     * command completes */
+    fields = light_coalescer_reconcile(state->handle, state, fields);
+    if (fields) {
+        dashboard_show_state(state, fields, user_data);
+    }
+}
+
+/**
+ * Order and rename lights as the configuration lists them; lights it does
+ * not list are left out and listed ones Home Assistant did not report are
+ * shown as off. Without a light list in the configuration lights are
+ * copied as they are.
+ * @param in Lights as loaded
+ * @param in_fields HA_LIGHT_FIELD_* bits per light, or NULL
+ * @param count Number of lights in in
+ * @param out Output array, DASHBOARD_MAX_LIGHTS long (not in)
+ * @param out_fields Output bits, or NULL
+ * @return Number of lights in out
+ */
+static int config_filter_lights(const light_state_t *in, const uint8_t *in_fields, int count,
+                                light_state_t *out, uint8_t *out_fields)
+{
+    if (!config || config->num_lights == 0) {
+        memcpy(out, in, (size_t)count * sizeof(out[0]));
+        if (out_fields) {
+            memcpy(out_fields, in_fields, (size_t)count);
+        }
+        return count;
+    }
+    
+    /* Quadratic, but both lists are short and this only runs on (re)load */
+    for (int c = 0; c < config->num_lights; c++) {
+        const app_config_light_t *listed = &config->lights[c];
+        light_state_t *light = &out[c];
+        int k = 0;
+        
+        while (k < count && strcmp(in[k].entity_id, listed->entity_id) != 0) {
+            k++;
+        }
+        if (k < count) {
+            *light = in[k];
+        } else {
+            memset(light, 0, sizeof(*light));
+            memcpy(light->entity_id, listed->entity_id, sizeof(light->entity_id));
+            memcpy(light->name, listed->entity_id, sizeof(light->name));
+            light->handle = ENTITY_HANDLE_INVALID;
+        }
+        if (out_fields) {
+            out_fields[c] = k < count ? in_fields[k] : 0;
+        }
+        if (listed->name[0]) {
+            memcpy(light->name, listed->name, sizeof(light->name));
+        }
+        if (listed->type >= 0) {
+            light->type = (light_type_t)listed->type;
+        }
+    }
+    return config->num_lights;
+}
+
+/**
+ * Switch to a new light list, touching only the cards that changed: lights
+ * that stay keep their card and current state, new lights and lights whose
+ * type changed get a card (from the pool when possible), the cards of lights
+ * that left go back to the pool
+ * @param next New light list
+ * @param count Number of lights in next
+ */
+static void lights_replace(const light_state_t *next, int count)
+{
+    static light_state_t merged[DASHBOARD_MAX_LIGHTS];
+    static bool merged_expanded[DASHBOARD_MAX_LIGHTS];
+    static bool kept[DASHBOARD_MAX_LIGHTS];
+    bool changed = count != num_lights;
+    int n = 0;
+    
+    memset(kept, 0, sizeof(kept));
+    for (int k = 0; k < count && n < DASHBOARD_MAX_LIGHTS; k++) {
+        entity_handle_t handle = entity_registry_intern(next[k].entity_id);
+        if (handle == ENTITY_HANDLE_INVALID) {
+            continue;
+        }
+        
+        int old = entity_registry_get_slot(handle);
+        if (old < 0 || old >= num_lights || lights[old].handle != handle || lights[old].type != next[k].type) {
+            old = -1;
+        }
+        
+        merged[n] = old >= 0 ? lights[old] : next[k];
+        memcpy(merged[n].name, next[k].name, sizeof(merged[n].name));
+        merged[n].handle = handle;
+        if (old >= 0 && grid_virtual) {
+            merged_expanded[n] = grid_expanded[old];
+        } else {
+            merged_expanded[n] = old >= 0 && card_at(old) && light_control_is_expanded(card_at(old));
+        }
+        if (old >= 0) {
+            kept[old] = true;
+        }
+        changed = changed || old != n || strcmp(lights[old].name, next[k].name) != 0;
+        n++;
+    }
+    if (!changed) {
+        return;
+    }
+    
+    /* A longer list may need more cards than the heap was sized for */
+    dashboard_reserve_cards(n);
+    
+    /* Crossing the threshold switches layouts: all cards are rebuilt */
+    bool virtual_next = n > DASHBOARD_VIRTUAL_MIN_LIGHTS;
+    bool relayout = virtual_next != grid_virtual;
+    
+    /* Free the cards of lights that left or changed type */
+    if (relayout) {
+        if (grid_virtual) {
+            grid_disable();
+        } else {
+            flex_disable();
+        }
+    } else if (grid_virtual) {
+        grid_release_changed(merged, n);
+    } else {
+        for (int i = 0; i < num_lights; i++) {
+            lv_obj_t *card = card_at(i);
+            if (!kept[i] && card) {
+                light_control_release_card(card);
+                entity_registry_set_card(lights[i].handle, NULL);
+            }
+        }
+    }
+    for (int i = 0; i < num_lights; i++) {
+        entity_registry_set_slot(lights[i].handle, -1);
+    }
+    
+    memcpy(lights, merged, (size_t)n * sizeof(lights[0]));
+    memcpy(grid_expanded, merged_expanded, sizeof(grid_expanded));
+    num_lights = n;
+    for (int i = 0; i < num_lights; i++) {
+        entity_registry_set_slot(lights[i].handle, i);
+    }
+    
+    if (relayout) {
+        if (virtual_next) {
+            grid_enable();
+        } else {
+            flex_enable();
+        }
+    } else if (grid_virtual) {
+        grid_rebind();
+    } else {
+        /* Kept cards follow their light to its new slot */
+        for (int i = 0; i < num_lights; i++) {
+            lv_obj_t *card = card_at(i);
+            if (card) {
+                bool expanded = light_control_is_expanded(card);
+                light_control_bind_card(card, &lights[i]);
+                light_control_set_expanded(card, expanded);
+            } else if (!(card = flex_acquire_card(i))) {
+                continue;
+            }
+            lv_obj_move_to_index(card, i);
+        }
+        flex_apply_columns();
+    }
+    
+    groups_remap();
+    snapshot_mark_dirty();
+    printf("Light list updated: %d lights\n", num_lights);
+}
+
+/**
+ * The live light list arrived (after a warm start or a configuration
+ * reload): apply changes to the list, then bring the states up to date
+ */
+static void dashboard_lights_refreshed(const light_state_t *live, const uint8_t *fields, int count,
+                                       void *user_data)
+{
+    if (count < 0) {
+        printf("Warning: could not refresh the lights, states may be stale\n");
+        return;
+    }
+    
+    count = config_filter_lights(live, fields, count, staged_lights, staged_fields);
+    lights_replace(staged_lights, count);
+    
+    groups_deferred = true;
+    for (int k = 0; k < count; k++) {
+        staged_lights[k].handle = entity_registry_find(staged_lights[k].entity_id);
+        if (staged_fields[k]) {
+            dashboard_state_changed(&staged_lights[k], staged_fields[k], user_data);
+        }
+    }
+    groups_deferred = false;
+    groups_refresh();
+    
+    printf("Reconciled %d lights with Home Assistant\n", num_lights);
+}
+
+/**
+ * Fill lights[] from the snapshot or Home Assistant, or from the samples
+ * when offline
+ */
+static void dashboard_load_lights(void)
+{
+    clock_t start = clock();
+    int count = snapshot_path[0] ? light_snapshot_load(snapshot_path, lights, DASHBOARD_MAX_LIGHTS) : -1;
+    
+    if (count > 0) {
+        num_lights = count;
+        printf("Loaded %d lights from %s in %.1f ms CPU\n", num_lights, snapshot_path,
+               (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC);
+        /* The first frame shows the cached states; live ones follow */
+        if (ha_api_refresh_lights(live_lights, live_fields, DASHBOARD_MAX_LIGHTS,
+                                  dashboard_lights_refreshed, NULL) == HA_REQUEST_INVALID) {
+            printf("Warning: showing cached light states\n");
+        }
+        return;
+    }
+    
+    count = ha_api_load_lights(lights, DASHBOARD_MAX_LIGHTS);
+    if (count >= 0) {
+        num_lights = count;
+        printf("Loaded %d lights from Home Assistant in %.1f ms CPU\n",
+               num_lights, (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC);
+        if (snapshot_path[0]) {
+            light_snapshot_save(snapshot_path, lights, num_lights);
+        }
+        return;
+    }
+    
+    printf("Warning: using sample lights\n");
+    num_lights = (int)(sizeof(sample_lights) / sizeof(sample_lights[0]));
+    memcpy(lights, sample_lights, sizeof(sample_lights));
+    light_coalescer_set_offline(true);
+}
+
+/**
+ * Build the dashboard from preloaded lights, or load them when NULL
+ */
+static void dashboard_setup(lv_obj_t *parent, const light_state_t *preload, int count)
 {
     if (!parent) {
         printf("Error: parent object is NULL\n");
@@ -75,35 +1225,148 @@ void dashboard_init(lv_obj_t *parent)
     
     dashboard_screen = parent;
     
+    /* Coalesce slider commands before they reach Home Assistant */
+    light_coalescer_init(LIGHT_COALESCER_DEFAULT_PERIOD_MS);
+    light_coalescer_set_view_cb(dashboard_show_state, NULL);
+    light_control_set_power_cb(dashboard_card_power, NULL);
+    
     /* Create title */
-    lv_obj_t *title = lv_label_create(parent);
-    lv_label_set_text(title, "Home Assistant Light Dashboard");
-    lv_obj_set_style_text_font(title, &lv_font_montserrat_28, 0);
-    lv_obj_set_style_text_color(title, lv_color_white(), 0);
-    lv_obj_align(title, LV_ALIGN_TOP_MID, 0, 20);
+    title_label = lv_label_create(parent);
+    lv_label_set_text(title_label, config && config->title[0] ? config->title : DASHBOARD_TITLE);
+    theme_add(title_label, THEME_SCREEN_TITLE, 0);
+    lv_obj_align(title_label, LV_ALIGN_TOP_MID, 0, 20);
+    max_columns = config ? config->columns : 0;
+    
+    /* Create the row of group cards */
+    group_bar = lv_obj_create(parent);
+    lv_obj_set_size(group_bar, LV_PCT(95), DASHBOARD_GROUP_BAR_HEIGHT);
+    lv_obj_align(group_bar, LV_ALIGN_TOP_MID, 0, DASHBOARD_GROUP_BAR_Y);
+    theme_add(group_bar, THEME_BAR, 0);
+    lv_obj_set_style_pad_gap(group_bar, DASHBOARD_CARD_GAP, 0);
+    lv_obj_set_flex_flow(group_bar, LV_FLEX_FLOW_ROW);
+    lv_obj_set_scroll_dir(group_bar, LV_DIR_HOR);
     
     /* Create container for lights */
     light_container = lv_obj_create(parent);
-    lv_obj_set_size(light_container, LV_PCT(95), LV_PCT(85));
+    lv_obj_set_size(light_container, LV_PCT(95), LV_PCT(70));
     lv_obj_align(light_container, LV_ALIGN_BOTTOM_MID, 0, -10);
-    lv_obj_set_style_bg_color(light_container, lv_color_hex(0x1C1C1C), 0);
-    lv_obj_set_style_border_width(light_container, 0, 0);
-    lv_obj_set_flex_flow(light_container, LV_FLEX_FLOW_ROW_WRAP);
-    lv_obj_set_flex_align(light_container, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_START);
-    lv_obj_set_style_pad_all(light_container, 10, 0);
-    lv_obj_set_style_pad_gap(light_container, 15, 0);
+    theme_add(light_container, THEME_CONTAINER, 0);
+    lv_obj_set_style_pad_gap(light_container, DASHBOARD_CARD_GAP, 0);
     
     /* Create light cards */
-    for (int i = 0; i < num_lights; i++) {
-        lv_obj_t *card = light_control_create_card(light_container, &lights[i]);
-        if (!card) {
-            printf("Error: Failed to create light card for %s\n", lights[i].name);
-        }
+    if (preload) {
+        num_lights = count < DASHBOARD_MAX_LIGHTS ? count : DASHBOARD_MAX_LIGHTS;
+        memcpy(lights, preload, (size_t)num_lights * sizeof(lights[0]));
+        /* Without a server (the benchmark) changes stay local */
+        light_coalescer_set_offline(!ha_api_is_initialized());
+    } else {
+        dashboard_load_lights();
+    }
+    num_lights = config_filter_lights(lights, NULL, num_lights, staged_lights, NULL);
+    memcpy(lights, staged_lights, (size_t)num_lights * sizeof(lights[0]));
+    dashboard_register_lights();
+    dashboard_create_cards();
+    
+    if (num_lights > 1) {
+        group_create_all();
+    }
+    groups_apply_config();
+    
+    /* Light changes are written back to the snapshot once they settle */
+    if (snapshot_path[0] && !snapshot_timer) {
+        snapshot_timer = lv_timer_create(snapshot_timer_cb, DASHBOARD_SNAPSHOT_DELAY_MS, NULL);
+        lv_timer_pause(snapshot_timer);
+    }
+    
+    /* Cards follow state pushes from Home Assistant instead of polling */
+    ha_api_set_state_cb(dashboard_state_changed, NULL);
+    if (!ha_api_subscribe_states()) {
+        printf("Warning: live state updates are not available\n");
     }
     
     printf("Dashboard initialized with %d lights\n", num_lights);
 }
 
+/**
+ * Initialize the dashboard UI
+ */
+void dashboard_init(lv_obj_t *parent)
+{
+    dashboard_setup(parent, NULL, 0);
+}
+
+/**
+ * Initialize the dashboard UI with the given lights
+ */
+void dashboard_init_with_lights(lv_obj_t *parent, const light_state_t *lights_in, int count)
+{
+    if (!lights_in || count < 0) {
+        printf("Error: invalid light list\n");
+        return;
+    }
+    dashboard_setup(parent, lights_in, count);
+}
+
+/**
+ * Set the light snapshot used for warm starts
+ */
+void dashboard_set_snapshot_path(const char *path)
+{
+    snprintf(snapshot_path, sizeof(snapshot_path), "%s", path ? path : "");
+}
+
+/**
+ * Write pending light changes to the snapshot
+ */
+void dashboard_save_snapshot(void)
+{
+    if (snapshot_dirty) {
+        snapshot_save();
+    }
+}
+
+/**
+ * Use a runtime configuration, or apply a reloaded one
+ */
+void dashboard_set_config(const struct app_config *cfg)
+{
+    config = cfg;
+    if (!dashboard_screen || !light_container) {
+        return;
+    }
+    
+    lv_label_set_text(title_label, config && config->title[0] ? config->title : DASHBOARD_TITLE);
+    
+    int columns = config ? config->columns : 0;
+    if (columns != max_columns) {
+        max_columns = columns;
+        if (grid_virtual) {
+            grid_reset();
+            grid_update_viewport();
+        } else {
+            flex_apply_columns();
+        }
+    }
+    
+    /* Listed lights that are already known show up at once; the live list
+     * fills in the others and their states */
+    int count = config_filter_lights(lights, NULL, num_lights, staged_lights, NULL);
+    lights_replace(staged_lights, count);
+    groups_apply_config();
+    ha_api_refresh_lights(live_lights, live_fields, DASHBOARD_MAX_LIGHTS, dashboard_lights_refreshed, NULL);
+}
+
+/**
+ * Add a group card
+ */
+bool dashboard_add_group(const char *name, const char *area_id, const char *const *entity_ids, int count)
+{
+    if (!name || !entity_ids || count <= 0) {
+        return false;
+    }
+    return group_create_from_ids(name, area_id, entity_ids, count) != NULL;
+}
+
 /**
  * Update dashboard with new data
  */
@@ -113,11 +1376,14 @@ void dashboard_update(void)
         return;
     }
     
-    /* In a real application, this would:
-     * 1. Fetch updated state from Home Assistant
-     * 2. Update each light card with new state
-     * 3. Handle any errors or disconnections
-     */
-    
-    printf("Dashboard update requested\n");
+    /* State pushes update individual cards as they arrive (see
+     * dashboard_state_changed); this re-renders every card from the
+     * current light states */
+    for (int i = 0; i < num_lights; i++) {
+        lv_obj_t *card = card_at(i);
+        if (card) {
+            light_state_t state = lights[i];
+            light_control_update_card(card, &state);
+        }
+    }
 }
@@ -7,6 +7,15 @@
 #define DASHBOARD_H
 
 #include "lvgl/lvgl.h"
+#include "light_control.h"
+
+/* Maximum number of lights shown on the dashboard: every light the entity
+ * registry can hold. Only light states are stored per light; cards come
+ * from fixed-size pools once the grid is virtualized. */
+#define DASHBOARD_MAX_LIGHTS ENTITY_REGISTRY_MAX
+
+/* Maximum number of group cards, including "All lights" */
+#define DASHBOARD_MAX_GROUPS 8
 
 /**
  * Initialize the dashboard UI
@@ -15,7 +24,58 @@
 void dashboard_init(lv_obj_t *parent);
 
 /**
- * Update dashboard with new data
+ * Initialize the dashboard UI with a fixed set of lights instead of
+ * loading them from Home Assistant (benchmarks, demos)
+ * @param parent Parent object to create the dashboard in
+ * @param lights Lights to show (copied, at most DASHBOARD_MAX_LIGHTS)
+ * @param count Number of lights
+ */
+void dashboard_init_with_lights(lv_obj_t *parent, const light_state_t *lights, int count);
+
+/**
+ * Set the light snapshot used for warm starts. When the file is valid,
+ * dashboard_init shows its lights at once and reconciles them with Home
+ * Assistant in the background; otherwise the lights are loaded from Home
+ * Assistant and the snapshot is created. Light changes are written back a
+ * few seconds after they settle. Call before dashboard_init.
+ * @param path Snapshot file, or NULL or "" to disable the snapshot
+ */
+void dashboard_set_snapshot_path(const char *path);
+
+/**
+ * Write light changes not yet saved to the snapshot (call before exiting)
+ */
+void dashboard_save_snapshot(void);
+
+struct app_config;
+
+/**
+ * Use a runtime configuration (light list, names and types, groups, title
+ * and columns). Before dashboard_init it is applied when the dashboard is
+ * built; afterwards the changes are applied in place: only the cards of
+ * lights that were added, removed, renamed or changed type are touched,
+ * and the group cards of the configuration are rebuilt if they changed.
+ * @param config Configuration (must stay valid until replaced), or NULL
+ */
+void dashboard_set_config(const struct app_config *config);
+
+/**
+ * Add a group card that switches several lights with one service call
+ * (one per HA_API_GROUP_MAX lights when they are listed by entity_id).
+ * The change is shown on the member cards immediately and rolled back if
+ * the call fails. An "All lights" group is created by dashboard_init.
+ * @param name Card title
+ * @param area_id Home Assistant area to target, or NULL to list the members
+ * @param entity_ids Member lights; lights not on the dashboard are skipped
+ * @param count Number of entity IDs (at most HA_API_GROUP_MAX with an area)
+ * @return true if the card was created
+ */
+bool dashboard_add_group(const char *name, const char *area_id, const char *const *entity_ids, int count);
+
+/**
+ * Re-render every light card from the current light states.
+ * Live changes are pushed to the cards automatically once the
+ * Home Assistant state subscription is running.
  */
 void dashboard_update(void);
 
@@ -0,0 +1,319 @@
+/**
+ * @file display_config.c
+ * Display render mode configuration and dirty-rectangle statistics implementation
+ */
+
+#include "display_config.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Areas invalidated since the last refresh */
+static lv_area_t areas[DISPLAY_CONFIG_MAX_AREAS];
+static bool areas_joined[DISPLAY_CONFIG_MAX_AREAS];
+static int num_areas = 0;
+static uint32_t frame_rects = 0;
+static bool frame_full = false;
+
+static lv_display_t *stats_display = NULL;
+static display_config_stats_t stats;
+
+/**
+ * Parse a render mode description
+ */
+bool display_config_parse(const char *spec, display_config_t *config)
+{
+    config->mode = LV_DISPLAY_RENDER_MODE_PARTIAL;
+    config->lines = DISPLAY_CONFIG_DEFAULT_LINES;
+    config->buffers = DISPLAY_CONFIG_DEFAULT_BUFFERS;
+
+    if (!spec || spec[0] == '\0') {
+        return true;
+    }
+
+    if (strcmp(spec, "direct") == 0) {
+        config->mode = LV_DISPLAY_RENDER_MODE_DIRECT;
+        return true;
+    }
+    if (strcmp(spec, "full") == 0) {
+        config->mode = LV_DISPLAY_RENDER_MODE_FULL;
+        return true;
+    }
+    if (strncmp(spec, "partial", 7) != 0 || (spec[7] != '\0' && spec[7] != ':')) {
+        return false;
+    }
+
+    const char *p = spec + 7;
+    char *end;
+    if (*p == ':') {
+        long lines = strtol(p + 1, &end, 10);
+        if (end == p + 1 || lines < 1) {
+            return false;
+        }
+        config->lines = (uint32_t)lines;
+        p = end;
+    }
+    if (*p == ':') {
+        long buffers = strtol(p + 1, &end, 10);
+        if (end == p + 1 || buffers < 1 || buffers > 2) {
+            return false;
+        }
+        config->buffers = (uint32_t)buffers;
+        p = end;
+    }
+    return *p == '\0';
+}
+
+/**
+ * Describe a configuration
+ */
+void display_config_describe(const display_config_t *config, char *buf, size_t size)
+{
+    switch (config->mode) {
+        case LV_DISPLAY_RENDER_MODE_DIRECT:
+            snprintf(buf, size, "direct");
+            break;
+        case LV_DISPLAY_RENDER_MODE_FULL:
+            snprintf(buf, size, "full");
+            break;
+        default:
+            snprintf(buf, size, "partial:%u:%u", (unsigned)config->lines, (unsigned)config->buffers);
+            break;
+    }
+}
+
+/**
+ * Size of one draw buffer for a configuration
+ */
+uint32_t display_config_buffer_size(const display_config_t *config, lv_display_t *disp)
+{
+    int32_t hor_res = lv_display_get_horizontal_resolution(disp);
+    int32_t ver_res = lv_display_get_vertical_resolution(disp);
+    uint32_t stride = lv_draw_buf_width_to_stride((uint32_t)hor_res, lv_display_get_color_format(disp));
+    uint32_t lines = (uint32_t)ver_res;
+
+    if (config->mode == LV_DISPLAY_RENDER_MODE_PARTIAL && config->lines < lines) {
+        lines = config->lines;
+    }
+    return stride * lines;
+}
+
+/**
+ * Whether two areas overlap
+ */
+static bool area_overlaps(const lv_area_t *a, const lv_area_t *b)
+{
+    return a->x1 <= b->x2 && a->x2 >= b->x1 && a->y1 <= b->y2 && a->y2 >= b->y1;
+}
+
+/**
+ * Whether an area lies within another
+ */
+static bool area_within(const lv_area_t *inner, const lv_area_t *outer)
+{
+    return inner->x1 >= outer->x1 && inner->y1 >= outer->y1 &&
+           inner->x2 <= outer->x2 && inner->y2 <= outer->y2;
+}
+
+/**
+ * Size of an area
+ */
+static uint32_t area_size(const lv_area_t *a)
+{
+    return (uint32_t)(a->x2 - a->x1 + 1) * (uint32_t)(a->y2 - a->y1 + 1);
+}
+
+/**
+ * Record an invalidated area (already clipped to the screen by LVGL)
+ */
+static void record_area(const lv_area_t *area)
+{
+    frame_rects++;
+    if (frame_full) {
+        return;
+    }
+
+    for (int i = 0; i < num_areas; i++) {
+        if (area_within(area, &areas[i])) {
+            return;
+        }
+    }
+
+    if (num_areas >= DISPLAY_CONFIG_MAX_AREAS) {
+        frame_full = true;
+        return;
+    }
+    areas[num_areas++] = *area;
+}
+
+/**
+ * Merge the recorded areas like lv_refr does and return the pixels to redraw
+ */
+static uint32_t merge_areas(void)
+{
+    uint32_t pixels = 0;
+
+    memset(areas_joined, 0, sizeof(areas_joined));
+    for (int in = 0; in < num_areas; in++) {
+        if (areas_joined[in]) {
+            continue;
+        }
+        for (int from = 0; from < num_areas; from++) {
+            if (from == in || areas_joined[from] || !area_overlaps(&areas[in], &areas[from])) {
+                continue;
+            }
+
+            /* Join only when the bounding box is smaller than the two apart */
+            lv_area_t joined;
+            joined.x1 = LV_MIN(areas[in].x1, areas[from].x1);
+            joined.y1 = LV_MIN(areas[in].y1, areas[from].y1);
+            joined.x2 = LV_MAX(areas[in].x2, areas[from].x2);
+            joined.y2 = LV_MAX(areas[in].y2, areas[from].y2);
+            if (area_size(&joined) < area_size(&areas[in]) + area_size(&areas[from])) {
+                areas[in] = joined;
+                areas_joined[from] = true;
+            }
+        }
+    }
+
+    for (int i = 0; i < num_areas; i++) {
+        if (!areas_joined[i]) {
+            pixels += area_size(&areas[i]);
+        }
+    }
+    return pixels;
+}
+
+/**
+ * Display event handler: collect invalidations, account for them once the
+ * refresh is done
+ */
+static void stats_event_cb(lv_event_t *e)
+{
+    lv_event_code_t code = lv_event_get_code(e);
+
+    if (code == LV_EVENT_INVALIDATE_AREA) {
+        const lv_area_t *area = (const lv_area_t *)lv_event_get_param(e);
+        if (area) {
+            record_area(area);
+        }
+        return;
+    }
+
+    /* LV_EVENT_REFR_READY */
+    if (frame_rects == 0) {
+        return;
+    }
+
+    uint32_t pixels;
+    if (frame_full) {
+        pixels = (uint32_t)lv_display_get_horizontal_resolution(stats_display) *
+                 (uint32_t)lv_display_get_vertical_resolution(stats_display);
+        stats.full_frames++;
+    } else {
+        pixels = merge_areas();
+    }
+
+    stats.frames++;
+    stats.rects += frame_rects;
+    stats.merged_pixels += pixels;
+    stats.last_rects = frame_rects;
+    stats.last_merged_pixels = pixels;
+    if (pixels > stats.max_merged_pixels) {
+        stats.max_merged_pixels = pixels;
+    }
+
+    num_areas = 0;
+    frame_rects = 0;
+    frame_full = false;
+}
+
+#if DASHBOARD_TRACE
+/**
+ * Display event handler: trace the refresh, render and flush phases
+ */
+static void trace_event_cb(lv_event_t *e)
+{
+    static uint64_t refr_start = 0;
+    static uint64_t render_start = 0;
+    static uint64_t flush_start = 0;
+
+    switch (lv_event_get_code(e)) {
+    case LV_EVENT_REFR_START:
+        refr_start = trace_now_ns();
+        break;
+    case LV_EVENT_REFR_READY:
+        TRACE_COMPLETE("display_refresh", refr_start);
+        break;
+    case LV_EVENT_RENDER_START:
+        render_start = trace_now_ns();
+        break;
+    case LV_EVENT_RENDER_READY:
+        TRACE_COMPLETE("render", render_start);
+        break;
+    case LV_EVENT_FLUSH_START:
+        flush_start = trace_now_ns();
+        break;
+    case LV_EVENT_FLUSH_FINISH:
+        TRACE_COMPLETE("flush", flush_start);
+        break;
+    default:
+        break;
+    }
+}
+#endif
+
+/**
+ * Follow the invalidated areas of a display
+ */
+void display_config_attach_stats(lv_display_t *disp)
+{
+    if (stats_display == disp) {
+        return;
+    }
+
+    stats_display = disp;
+    memset(&stats, 0, sizeof(stats));
+    num_areas = 0;
+    frame_rects = 0;
+    frame_full = false;
+
+    lv_display_add_event_cb(disp, stats_event_cb, LV_EVENT_INVALIDATE_AREA, NULL);
+    lv_display_add_event_cb(disp, stats_event_cb, LV_EVENT_REFR_READY, NULL);
+
+#if DASHBOARD_TRACE
+    lv_display_add_event_cb(disp, trace_event_cb, LV_EVENT_REFR_START, NULL);
+    lv_display_add_event_cb(disp, trace_event_cb, LV_EVENT_REFR_READY, NULL);
+    lv_display_add_event_cb(disp, trace_event_cb, LV_EVENT_RENDER_START, NULL);
+    lv_display_add_event_cb(disp, trace_event_cb, LV_EVENT_RENDER_READY, NULL);
+    lv_display_add_event_cb(disp, trace_event_cb, LV_EVENT_FLUSH_START, NULL);
+    lv_display_add_event_cb(disp, trace_event_cb, LV_EVENT_FLUSH_FINISH, NULL);
+#endif
+}
+
+/**
+ * Get the dirty-rectangle statistics
+ */
+void display_config_get_stats(display_config_stats_t *out)
+{
+    *out = stats;
+}
+
+/**
+ * Print the dirty-rectangle statistics on one line
+ */
+void display_config_log_stats(void)
+{
+    if (!stats_display || stats.frames == 0) {
+        return;
+    }
+
+    double screen = (double)lv_display_get_horizontal_resolution(stats_display) *
+                    (double)lv_display_get_vertical_resolution(stats_display);
+    printf("Redrawn %u frames: %.1f dirty areas and %.1f%% of the screen per frame, "
+           "peak %.1f%%, %u full redraws\n",
+           (unsigned)stats.frames, (double)stats.rects / stats.frames,
+           (double)stats.merged_pixels * 100.0 / stats.frames / screen,
+           (double)stats.max_merged_pixels * 100.0 / screen, (unsigned)stats.full_frames);
+}
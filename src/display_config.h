@@ -0,0 +1,90 @@
+/**
+ * @file display_config.h
+ * Display render mode configuration and dirty-rectangle statistics
+ *
+ * A render mode is described by a short string, so it can be picked at
+ * run time on displays whose buffers we own (the headless display, SPI
+ * panels):
+ *   "partial[:lines[:buffers]]" - band buffers of `lines` rows, 1 or 2 of them
+ *   "direct"                    - full-size framebuffer, only dirty areas redrawn
+ *   "full"                      - full-size framebuffer, whole screen redrawn
+ *
+ * The statistics follow invalidations and merge them the way LVGL does, so
+ * they work on any display, including the SDL window.
+ */
+
+#ifndef DISPLAY_CONFIG_H
+#define DISPLAY_CONFIG_H
+
+#include "lvgl/lvgl.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Partial mode defaults: two bands of a tenth of a 600 line screen */
+#define DISPLAY_CONFIG_DEFAULT_LINES 60
+#define DISPLAY_CONFIG_DEFAULT_BUFFERS 2
+
+/* Invalidated areas LVGL keeps per frame before redrawing the whole screen */
+#define DISPLAY_CONFIG_MAX_AREAS 32
+
+/* Render mode and buffer sizes */
+typedef struct {
+    lv_display_render_mode_t mode;
+    uint32_t lines;    /* Band height, partial mode only */
+    uint32_t buffers;  /* 1 or 2, partial mode only */
+} display_config_t;
+
+/* Dirty-rectangle statistics over the frames that redrew something */
+typedef struct {
+    uint32_t frames;
+    uint64_t rects;          /* Invalidated areas */
+    uint64_t merged_pixels;  /* Pixels to redraw after merging */
+    uint32_t last_rects;
+    uint32_t last_merged_pixels;
+    uint32_t max_merged_pixels;
+    uint32_t full_frames;    /* Frames with too many areas, redrawn whole */
+} display_config_stats_t;
+
+/**
+ * Parse a render mode description
+ * @param spec Description (see above), NULL or empty for partial defaults
+ * @param config Output configuration
+ * @return false if the description is not valid
+ */
+bool display_config_parse(const char *spec, display_config_t *config);
+
+/**
+ * Describe a configuration in the syntax display_config_parse accepts
+ * @param config Configuration
+ * @param buf Output buffer
+ * @param size Size of the buffer
+ */
+void display_config_describe(const display_config_t *config, char *buf, size_t size);
+
+/**
+ * Size of one draw buffer for a configuration
+ * @param config Configuration
+ * @param disp Display the buffer is for (resolution, color format)
+ * @return Buffer size in bytes
+ */
+uint32_t display_config_buffer_size(const display_config_t *config, lv_display_t *disp);
+
+/**
+ * Follow the invalidated areas of a display (one display at a time), and
+ * trace its refresh, render and flush phases in DASHBOARD_TRACE builds
+ * @param disp Display
+ */
+void display_config_attach_stats(lv_display_t *disp);
+
+/**
+ * Get the dirty-rectangle statistics
+ * @param stats Output statistics
+ */
+void display_config_get_stats(display_config_stats_t *stats);
+
+/**
+ * Print the dirty-rectangle statistics on one line
+ */
+void display_config_log_stats(void);
+
+#endif /* DISPLAY_CONFIG_H */
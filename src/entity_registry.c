@@ -0,0 +1,167 @@
+/**
+ * @file entity_registry.c
+ * Interned Home Assistant entity IDs implementation
+ */
+
+#include "entity_registry.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Open addressing table, kept at most half full */
+#define ENTITY_REGISTRY_BUCKETS (ENTITY_REGISTRY_MAX * 2)
+#define ENTITY_REGISTRY_BUCKET_MASK (ENTITY_REGISTRY_BUCKETS - 1)
+
+/* Per-handle data */
+typedef struct {
+    uint32_t hash;
+    uint32_t id_offset;   /* Entity ID in the arena */
+    int slot;
+    void *card;
+} entity_entry_t;
+
+static entity_entry_t entries[ENTITY_REGISTRY_MAX];
+static int num_entries = 0;
+
+/* Bucket -> handle, ENTITY_HANDLE_INVALID when empty */
+static entity_handle_t buckets[ENTITY_REGISTRY_BUCKETS];
+static bool buckets_ready = false;
+
+static char arena[ENTITY_REGISTRY_ARENA_SIZE];
+static size_t arena_used = 0;
+
+/**
+ * FNV-1a hash of a string
+ */
+static uint32_t hash_id(const char *id)
+{
+    uint32_t hash = 2166136261u;
+    while (*id) {
+        hash ^= (uint8_t)*id++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Find the bucket holding an ID, or the empty bucket where it belongs
+ */
+static uint32_t find_bucket(const char *entity_id, uint32_t hash)
+{
+    if (!buckets_ready) {
+        memset(buckets, 0xFF, sizeof(buckets));
+        buckets_ready = true;
+    }
+
+    uint32_t bucket = hash & ENTITY_REGISTRY_BUCKET_MASK;
+    for (;;) {
+        entity_handle_t handle = buckets[bucket];
+        if (handle == ENTITY_HANDLE_INVALID) {
+            return bucket;
+        }
+        if (entries[handle].hash == hash &&
+            strcmp(arena + entries[handle].id_offset, entity_id) == 0) {
+            return bucket;
+        }
+        bucket = (bucket + 1) & ENTITY_REGISTRY_BUCKET_MASK;
+    }
+}
+
+/**
+ * Intern an entity ID
+ */
+entity_handle_t entity_registry_intern(const char *entity_id)
+{
+    if (!entity_id) {
+        return ENTITY_HANDLE_INVALID;
+    }
+
+    uint32_t hash = hash_id(entity_id);
+    uint32_t bucket = find_bucket(entity_id, hash);
+    if (buckets[bucket] != ENTITY_HANDLE_INVALID) {
+        return buckets[bucket];
+    }
+
+    size_t len = strlen(entity_id) + 1;
+    if (num_entries >= ENTITY_REGISTRY_MAX || arena_used + len > sizeof(arena)) {
+        printf("Error: entity registry full, ignoring %s\n", entity_id);
+        return ENTITY_HANDLE_INVALID;
+    }
+
+    entity_handle_t handle = (entity_handle_t)num_entries++;
+    entity_entry_t *entry = &entries[handle];
+    entry->hash = hash;
+    entry->id_offset = (uint32_t)arena_used;
+    entry->slot = -1;
+    entry->card = NULL;
+    memcpy(arena + arena_used, entity_id, len);
+    arena_used += len;
+
+    buckets[bucket] = handle;
+    return handle;
+}
+
+/**
+ * Look up an entity ID
+ */
+entity_handle_t entity_registry_find(const char *entity_id)
+{
+    if (!entity_id || num_entries == 0) {
+        return ENTITY_HANDLE_INVALID;
+    }
+    return buckets[find_bucket(entity_id, hash_id(entity_id))];
+}
+
+/**
+ * Get the entity ID of a handle
+ */
+const char *entity_registry_get_id(entity_handle_t handle)
+{
+    if (handle >= num_entries) {
+        return NULL;
+    }
+    return arena + entries[handle].id_offset;
+}
+
+/**
+ * Number of interned entities
+ */
+int entity_registry_count(void)
+{
+    return num_entries;
+}
+
+/**
+ * Associate a state slot with an entity
+ */
+void entity_registry_set_slot(entity_handle_t handle, int slot)
+{
+    if (handle < num_entries) {
+        entries[handle].slot = slot;
+    }
+}
+
+/**
+ * Get the state slot of an entity
+ */
+int entity_registry_get_slot(entity_handle_t handle)
+{
+    return handle < num_entries ? entries[handle].slot : -1;
+}
+
+/**
+ * Associate the card showing an entity
+ */
+void entity_registry_set_card(entity_handle_t handle, void *card)
+{
+    if (handle < num_entries) {
+        entries[handle].card = card;
+    }
+}
+
+/**
+ * Get the card showing an entity
+ */
+void *entity_registry_get_card(entity_handle_t handle)
+{
+    return handle < num_entries ? entries[handle].card : NULL;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file entity_registry.h
+ * Interned Home Assistant entity IDs
+ *
+ * Every entity ID the dashboard deals with is interned once into a compact
+ * handle. Handles index plain arrays (light state slot, card, acknowledged
+ * state, command coalescing), so an incoming state change costs one hash
+ * lookup instead of a strcmp scan. The registry is only used from the UI
+ * thread.
+ */
+
+#ifndef ENTITY_REGISTRY_H
+#define ENTITY_REGISTRY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Compact entity identifier */
+typedef uint16_t entity_handle_t;
+
+/* Returned when an entity is unknown or the registry is full */
+#define ENTITY_HANDLE_INVALID 0xFFFF
+
+/* Maximum number of interned entities */
+#define ENTITY_REGISTRY_MAX 1024
+
+/* Storage for the interned ID strings */
+#define ENTITY_REGISTRY_ARENA_SIZE (32 * 1024)
+
+/**
+ * Intern an entity ID, adding it if it is not known yet
+ * @param entity_id Entity ID
+ * @return Handle, or ENTITY_HANDLE_INVALID if the registry is full
+ */
+entity_handle_t entity_registry_intern(const char *entity_id);
+
+/**
+ * Look up an entity ID without adding it
+ * @param entity_id Entity ID
+ * @return Handle, or ENTITY_HANDLE_INVALID if it was never interned
+ */
+entity_handle_t entity_registry_find(const char *entity_id);
+
+/**
+ * Get the entity ID of a handle
+ * @param handle Entity handle
+ * @return Entity ID, or NULL for an invalid handle
+ */
+const char *entity_registry_get_id(entity_handle_t handle);
+
+/**
+ * Get the number of interned entities (handles are 0 to count - 1)
+ */
+int entity_registry_count(void);
+
+/**
+ * Associate a state slot with an entity (e.g. its index in the light array)
+ * @param handle Entity handle
+ * @param slot Slot index, or -1 for none
+ */
+void entity_registry_set_slot(entity_handle_t handle, int slot);
+
+/**
+ * Get the state slot of an entity
+ * @return Slot index, or -1 if none was set
+ */
+int entity_registry_get_slot(entity_handle_t handle);
+
+/**
+ * Associate the UI card currently showing an entity
+ * @param handle Entity handle
+ * @param card Card object, or NULL when the entity has no card
+ */
+void entity_registry_set_card(entity_handle_t handle, void *card);
+
+/**
+ * Get the UI card currently showing an entity
+ * @return Card object, or NULL
+ */
+void *entity_registry_get_card(entity_handle_t handle);
+
+#endif /* ENTITY_REGISTRY_H */
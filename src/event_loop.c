@@ -0,0 +1,280 @@
+/**
+ * @file event_loop.c
+ * epoll based main loop implementation
+ */
+
+#include "event_loop.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+#if LV_USE_SDL
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_syswm.h>
+#endif
+
+/* epoll tag of the deadline timer (watched descriptors use their index) */
+#define EVENT_LOOP_TIMER_TAG EVENT_LOOP_MAX_FDS
+
+/* Most LVGL timers serving input (SDL event pump, input device reads) */
+#define EVENT_LOOP_MAX_INPUT_TIMERS 8
+
+/* Input timers keep running this long after the last input event */
+#define EVENT_LOOP_INPUT_LINGER_MS 500
+
+/* Watched descriptor */
+typedef struct {
+    int fd;
+    event_loop_cb_t cb;
+    void *user_data;
+} event_loop_watch_t;
+
+static int epoll_fd = -1;
+static int timer_fd = -1;
+static event_loop_watch_t watches[EVENT_LOOP_MAX_FDS];
+static int num_watches = 0;
+static uint32_t wakeups = 0;
+
+/* First LVGL timer that existed before the SDL window was created */
+static lv_timer_t *first_timer = NULL;
+
+/* Input timers, paused while there is no input */
+static lv_timer_t *input_timers[EVENT_LOOP_MAX_INPUT_TIMERS];
+static int num_input_timers = 0;
+static bool input_paused = false;
+static uint32_t last_input_tick = 0;
+
+/**
+ * Create the epoll instance and the deadline timerfd
+ */
+bool event_loop_init(void)
+{
+    if (epoll_fd >= 0) {
+        return true;
+    }
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        perror("epoll_create1");
+        return false;
+    }
+
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd < 0) {
+        perror("timerfd_create");
+        close(epoll_fd);
+        epoll_fd = -1;
+        return false;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = EVENT_LOOP_TIMER_TAG;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &ev) != 0) {
+        perror("epoll_ctl");
+        event_loop_deinit();
+        return false;
+    }
+
+    /* Timers are inserted at the head of the list: everything created from
+     * now on comes before this one */
+    first_timer = lv_timer_get_next(NULL);
+    return true;
+}
+
+/**
+ * Close the event loop descriptors
+ */
+void event_loop_deinit(void)
+{
+    if (timer_fd >= 0) {
+        close(timer_fd);
+        timer_fd = -1;
+    }
+    if (epoll_fd >= 0) {
+        close(epoll_fd);
+        epoll_fd = -1;
+    }
+    num_watches = 0;
+    num_input_timers = 0;
+}
+
+/**
+ * Watch a file descriptor for readability
+ */
+bool event_loop_add_fd(int fd, event_loop_cb_t cb, void *user_data)
+{
+    if (epoll_fd < 0 || fd < 0 || num_watches >= EVENT_LOOP_MAX_FDS) {
+        return false;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = (uint32_t)num_watches;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        perror("epoll_ctl");
+        return false;
+    }
+
+    watches[num_watches].fd = fd;
+    watches[num_watches].cb = cb;
+    watches[num_watches].user_data = user_data;
+    num_watches++;
+    return true;
+}
+
+/**
+ * Window system input is readable: run the input timers right away
+ */
+static void input_ready_cb(int fd, void *user_data)
+{
+    (void)fd;
+    (void)user_data;
+
+    for (int i = 0; i < num_input_timers; i++) {
+        lv_timer_resume(input_timers[i]);
+        lv_timer_ready(input_timers[i]);
+    }
+    input_paused = false;
+    last_input_tick = lv_tick_get();
+}
+
+/**
+ * Pause the input timers once input has been quiet for a while
+ */
+static void input_maybe_pause(void)
+{
+    if (num_input_timers == 0 || input_paused ||
+        lv_tick_elaps(last_input_tick) < EVENT_LOOP_INPUT_LINGER_MS) {
+        return;
+    }
+
+    /* Keep reading while a button is held (long press, scrolling) */
+    for (lv_indev_t *indev = lv_indev_get_next(NULL); indev; indev = lv_indev_get_next(indev)) {
+        if (lv_indev_get_state(indev) == LV_INDEV_STATE_PRESSED) {
+            return;
+        }
+    }
+
+#if LV_USE_SDL
+    /* Events SDL already pulled off the socket would not wake us up */
+    SDL_PumpEvents();
+    if (SDL_HasEvents(SDL_FIRSTEVENT, SDL_LASTEVENT)) {
+        last_input_tick = lv_tick_get();
+        return;
+    }
+#endif
+
+    for (int i = 0; i < num_input_timers; i++) {
+        lv_timer_pause(input_timers[i]);
+    }
+    input_paused = true;
+}
+
+/**
+ * Find the window system connection behind the SDL window
+ */
+static int sdl_connection_fd(lv_display_t *disp)
+{
+#if LV_USE_SDL && defined(SDL_VIDEO_DRIVER_X11)
+    SDL_Renderer *renderer = lv_sdl_window_get_renderer(disp);
+    SDL_Window *window = renderer ? SDL_RenderGetWindow(renderer) : NULL;
+    SDL_SysWMinfo info;
+
+    SDL_VERSION(&info.version);
+    if (window && SDL_GetWindowWMInfo(window, &info) && info.subsystem == SDL_SYSWM_X11) {
+        return ConnectionNumber(info.info.x11.display);
+    }
+#else
+    (void)disp;
+#endif
+    return -1;
+}
+
+/**
+ * Wake on SDL input instead of polling for it
+ */
+bool event_loop_watch_sdl(lv_display_t *disp)
+{
+    int fd = sdl_connection_fd(disp);
+    if (fd < 0) {
+        printf("Event loop: window system fd not available, polling for input\n");
+        return false;
+    }
+
+    /* Timers created with the window and the input devices, except the
+     * display refresh which is paused by LVGL itself when idle */
+    lv_timer_t *refr_timer = lv_display_get_refr_timer(disp);
+    num_input_timers = 0;
+    for (lv_timer_t *timer = lv_timer_get_next(NULL); timer && timer != first_timer;
+         timer = lv_timer_get_next(timer)) {
+        if (timer != refr_timer && num_input_timers < EVENT_LOOP_MAX_INPUT_TIMERS) {
+            input_timers[num_input_timers++] = timer;
+        }
+    }
+
+    if (!event_loop_add_fd(fd, input_ready_cb, NULL)) {
+        num_input_timers = 0;
+        return false;
+    }
+
+    last_input_tick = lv_tick_get();
+    input_paused = false;
+    return true;
+}
+
+/**
+ * Sleep until a watched descriptor is readable or the timeout expires
+ */
+void event_loop_wait(uint32_t timeout_ms)
+{
+    struct epoll_event events[EVENT_LOOP_MAX_FDS + 1];
+    struct itimerspec its;
+
+    if (epoll_fd < 0) {
+        return;
+    }
+
+    input_maybe_pause();
+
+    /* Arm the timerfd for the next LVGL deadline (all zero disarms it) */
+    memset(&its, 0, sizeof(its));
+    if (timeout_ms != LV_NO_TIMER_READY && timeout_ms > 0) {
+        its.it_value.tv_sec = timeout_ms / 1000;
+        its.it_value.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+    }
+    timerfd_settime(timer_fd, 0, &its, NULL);
+
+    int n = epoll_wait(epoll_fd, events, EVENT_LOOP_MAX_FDS + 1, timeout_ms == 0 ? 0 : -1);
+    if (n < 0) {
+        if (errno != EINTR) {
+            perror("epoll_wait");
+        }
+        return;
+    }
+
+    wakeups++;
+    for (int i = 0; i < n; i++) {
+        uint32_t tag = events[i].data.u32;
+        if (tag == EVENT_LOOP_TIMER_TAG) {
+            uint64_t expirations;
+            ssize_t len = read(timer_fd, &expirations, sizeof(expirations));
+            (void)len;
+        } else if (tag < (uint32_t)num_watches && watches[tag].cb) {
+            watches[tag].cb(watches[tag].fd, watches[tag].user_data);
+        }
+    }
+}
+
+/**
+ * Number of times the loop woke up
+ */
+uint32_t event_loop_get_wakeups(void)
+{
+    return wakeups;
+}
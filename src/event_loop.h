@@ -0,0 +1,72 @@
+/**
+ * @file event_loop.h
+ * epoll based main loop
+ *
+ * The UI thread sleeps in epoll_wait until an input event arrives, a
+ * watched file descriptor (such as the Home Assistant result eventfd)
+ * becomes readable, or the timerfd armed for the next LVGL timer
+ * deadline expires. Nothing wakes the process while the panel is idle.
+ */
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include "lvgl/lvgl.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Most file descriptors that can be watched */
+#define EVENT_LOOP_MAX_FDS 8
+
+/**
+ * Callback invoked on the UI thread when a watched descriptor is readable
+ * @param fd The readable descriptor
+ * @param user_data User data given to event_loop_add_fd
+ */
+typedef void (*event_loop_cb_t)(int fd, void *user_data);
+
+/**
+ * Create the epoll instance and the deadline timerfd.
+ * Call after lv_init() and before the SDL window is created.
+ * @return true if successful
+ */
+bool event_loop_init(void);
+
+/**
+ * Close the event loop descriptors
+ */
+void event_loop_deinit(void);
+
+/**
+ * Watch a file descriptor for readability
+ * @param fd Descriptor to watch
+ * @param cb Callback, or NULL to only wake up the loop
+ * @param user_data User data passed to the callback
+ * @return true if successful
+ */
+bool event_loop_add_fd(int fd, event_loop_cb_t cb, void *user_data);
+
+/**
+ * Wake on SDL input instead of polling for it. Pauses the SDL driver's
+ * polling timer and input device read timers and runs them only when the
+ * window system connection is readable. Falls back to polling (returns
+ * false) when the connection descriptor cannot be found.
+ * @param disp Display created by lv_sdl_window_create
+ * @return true if input is event driven
+ */
+bool event_loop_watch_sdl(lv_display_t *disp);
+
+/**
+ * Sleep until a watched descriptor is readable or the timeout expires
+ * @param timeout_ms Time until the next LVGL timer (the value returned by
+ *                   lv_timer_handler), LV_NO_TIMER_READY to wait forever
+ */
+void event_loop_wait(uint32_t timeout_ms);
+
+/**
+ * Get the number of times the loop woke up
+ * @return Wakeups since event_loop_init
+ */
+uint32_t event_loop_get_wakeups(void);
+
+#endif /* EVENT_LOOP_H */
@@ -1,17 +1,1066 @@
 /**
  * @file ha_api.c
  * Home Assistant API integration implementation
+ *
+ * Requests are pushed by the UI thread into a lock-free single-producer /
+ * single-consumer ring and executed by one I/O worker thread, which keeps a
+ * small pool of keep-alive connections and pipelines requests over them. Results travel
+ * back through a second ring that ha_api_process() drains on the UI thread.
+ * A separate thread holds the WebSocket state_changed subscription and feeds
+ * light state pushes through a third ring.
  */
 
 #include "ha_api.h"
+#include "ha_http.h"
+#include "ha_json.h"
+#include "ha_ws.h"
+#include "entity_registry.h"
+#include "trace.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#define HA_API_QUEUE_MASK (HA_API_QUEUE_SIZE - 1)
+
+/* Largest state response the worker will buffer for parsing */
+#define HA_API_RESPONSE_MAX 16384
+
+/* Largest single entity object kept while streaming /api/states */
+#define HA_API_ENTITY_MAX 16384
+
+/* Largest WebSocket message accepted from the server */
+#define HA_API_WS_MESSAGE_MAX 65536
+
+/* Reconnect backoff limits for the WebSocket subscription */
+#define HA_API_WS_BACKOFF_MIN_S 1
+#define HA_API_WS_BACKOFF_MAX_S 30
+
+/* Largest service call body (a multi-light call lists every entity_id) */
+#define HA_API_BODY_MAX 2048
+
+/* Most jobs handled in one pipelined batch */
+#define HA_API_BATCH_MAX (HA_API_POOL_SIZE * HA_API_PIPELINE_DEPTH)
+
+#define HA_LIGHT_FIELD_ALL (HA_LIGHT_FIELD_POWER | HA_LIGHT_FIELD_BRIGHTNESS | \
+                            HA_LIGHT_FIELD_COLOR | HA_LIGHT_FIELD_COLOR_TEMP)
+
+/* Request kinds */
+typedef enum {
+    HA_JOB_GET_STATE,
+    HA_JOB_SERVICE,
+    HA_JOB_LOAD_STATES    /* Every light, into refresh_loader */
+} ha_job_kind_t;
+
+/* Queued request */
+typedef struct {
+    ha_request_t id;
+    ha_job_kind_t kind;
+    char path[128];
+    char body[HA_API_BODY_MAX];
+    entity_handle_t entity;  /* Entity the job targets, ENTITY_HANDLE_INVALID for a group */
+    uint8_t ack_fields;   /* HA_LIGHT_FIELD_* bits applied on success */
+    uint8_t unsent;       /* Requested HA_LIGHT_FIELD_* bits the call does not carry */
+    light_state_t target;
+    uint8_t group_count;  /* Entities a multi-light call affects */
+    entity_handle_t group[HA_API_GROUP_MAX];
+} ha_job_t;
+
+/* Completed request */
+typedef struct {
+    ha_request_t id;
+    ha_job_kind_t kind;
+    int http_status;
+    bool has_state;
+    uint8_t state_fields;  /* HA_LIGHT_FIELD_* bits present in a parsed state */
+    light_state_t state;
+    entity_handle_t entity;
+    uint8_t ack_fields;
+    uint8_t unsent;
+    uint8_t group_count;
+    entity_handle_t group[HA_API_GROUP_MAX];
+} ha_done_t;
+
+/* State change pushed by the server */
+typedef struct {
+    light_state_t state;
+    uint8_t fields;        /* HA_LIGHT_FIELD_* bits present in the payload */
+} ha_push_t;
+
+/* Streaming splitter for the GET /api/states array */
+typedef struct {
+    light_state_t *lights;
+    uint8_t *fields;          /* HA_LIGHT_FIELD_* bits per light, or NULL */
+    bool intern;              /* On the UI thread: intern and record as acknowledged */
+    bool push;                /* Queue each light as a state push instead of storing it */
+    int max_lights;
+    int count;
+    int depth;
+    bool in_string;
+    bool escape;
+    bool overflow;            /* Current object did not fit in obj[] */
+    size_t obj_len;
+    char obj[HA_API_ENTITY_MAX];
+} ha_bulk_loader_t;
+
+/* WebSocket message kinds we react to */
+typedef enum {
+    HA_WS_MSG_OTHER,
+    HA_WS_MSG_AUTH_REQUIRED,
+    HA_WS_MSG_AUTH_OK,
+    HA_WS_MSG_AUTH_INVALID,
+    HA_WS_MSG_RESULT_OK,
+    HA_WS_MSG_RESULT_ERROR,
+    HA_WS_MSG_STATE
+} ha_ws_msg_t;
+
+/* Last state the server acknowledged for an entity */
+typedef struct {
+    uint8_t known;        /* HA_LIGHT_FIELD_* bits we have a value for */
+    light_state_t state;
+} ha_acked_t;
+
+/* Ring indices; head is written by the producer, tail by the consumer */
+typedef struct {
+    uint32_t head;
+    uint32_t tail;
+} ha_ring_t;
 
 /* Configuration */
 static char ha_url[256] = {0};
 static char ha_token[256] = {0};
 static bool initialized = false;
+static ha_http_endpoint_t endpoint;
+
+/* Worker thread and its persistent connections */
+static pthread_t worker_thread;
+static sem_t worker_sem;
+static volatile int worker_stop = 0;
+static ha_http_conn_t pool[HA_API_POOL_SIZE];
+
+/* Connection statistics snapshot shared with the UI thread */
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static ha_http_stats_t pool_stats[HA_API_POOL_SIZE];
+
+/* Submission queue (UI thread -> worker) */
+static ha_job_t job_slots[HA_API_QUEUE_SIZE];
+static ha_ring_t job_ring;
+
+/* Completion queue (worker -> UI thread) */
+static ha_done_t done_slots[HA_API_QUEUE_SIZE];
+static ha_ring_t done_ring;
+
+/* WebSocket thread and its push queue (WebSocket thread -> UI thread) */
+static pthread_t ws_thread;
+static sem_t ws_sem;
+static bool ws_started = false;
+static volatile int ws_exited = 0;
+static ha_ws_conn_t ws_conn;
+static char ws_buf[HA_API_WS_MESSAGE_MAX];
+static ha_push_t push_slots[HA_API_QUEUE_SIZE];
+static ha_ring_t push_ring;
+
+/* Signalled whenever results or pushes are queued for the UI thread */
+static int notify_fd = -1;
+
+/* UI thread state */
+static ha_request_t next_request_id = 1;
+static ha_api_result_cb_t result_cb = NULL;
+static void *result_cb_user_data = NULL;
+static ha_api_state_cb_t state_cb = NULL;
+static void *state_cb_user_data = NULL;
+static ha_acked_t acked[ENTITY_REGISTRY_MAX];  /* Indexed by entity handle */
+static ha_api_lights_cb_t refresh_cb = NULL;
+static void *refresh_cb_user_data = NULL;
+static bool refresh_pending = false;
+
+/* Background light refresh, owned by the worker while refresh_pending */
+static ha_bulk_loader_t refresh_loader;
+
+/* Response accumulation, only touched by the worker */
+static char response_buf[HA_API_RESPONSE_MAX];
+static size_t response_len = 0;
+static bool response_truncated = false;
+
+/**
+ * Reserve the next free slot for writing
+ * @return false if the ring is full
+ */
+static bool ring_write_slot(ha_ring_t *ring, uint32_t *index)
+{
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= HA_API_QUEUE_SIZE) {
+        return false;
+    }
+    *index = head & HA_API_QUEUE_MASK;
+    return true;
+}
+
+/**
+ * Get the published slot offset entries after the oldest one
+ * @return false if fewer entries are queued
+ */
+static bool ring_peek_slot(ha_ring_t *ring, uint32_t offset, uint32_t *index)
+{
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if (head - tail <= offset) {
+        return false;
+    }
+    *index = (tail + offset) & HA_API_QUEUE_MASK;
+    return true;
+}
+
+/**
+ * Wake up the UI thread's event loop
+ */
+static void notify_ui(void)
+{
+    if (notify_fd >= 0) {
+        uint64_t one = 1;
+        ssize_t n = write(notify_fd, &one, sizeof(one));
+        (void)n;  /* Only fails when the counter is already saturated */
+    }
+}
+
+/**
+ * Publish the slot reserved by ring_write_slot
+ */
+static void ring_publish(ha_ring_t *ring)
+{
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Get the oldest published slot for reading
+ * @return false if the ring is empty
+ */
+static bool ring_read_slot(ha_ring_t *ring, uint32_t *index)
+{
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if (tail == head) {
+        return false;
+    }
+    *index = tail & HA_API_QUEUE_MASK;
+    return true;
+}
+
+/**
+ * Release the slot returned by ring_read_slot
+ */
+static void ring_consume(ha_ring_t *ring)
+{
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Map the "supported_color_modes" list to a light type
+ */
+static bool color_mode_is_color(const ha_json_token_t *tok)
+{
+    return ha_json_token_eq(tok, "rgb") || ha_json_token_eq(tok, "rgbw") ||
+           ha_json_token_eq(tok, "rgbww") || ha_json_token_eq(tok, "hs") ||
+           ha_json_token_eq(tok, "xy") || ha_json_token_eq(tok, "color_temp");
+}
+
+/**
+ * Parse the "attributes" object of a light entity
+ */
+static bool parse_light_attributes(ha_json_lexer_t *lex, light_state_t *state, uint8_t *fields)
+{
+    ha_json_token_t tok;
+    int depth = lex->depth;
+
+    while (ha_json_next(lex, &tok) == HA_JSON_KEY) {
+        if (ha_json_token_eq(&tok, "friendly_name")) {
+            if (ha_json_next(lex, &tok) == HA_JSON_STRING) {
+                ha_json_token_copy(&tok, state->name, sizeof(state->name));
+            }
+        } else if (ha_json_token_eq(&tok, "brightness")) {
+            if (ha_json_next(lex, &tok) == HA_JSON_NUMBER) {
+                long v = ha_json_token_to_long(&tok);
+                state->brightness = (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+                *fields |= HA_LIGHT_FIELD_BRIGHTNESS;
+            }
+        } else if (ha_json_token_eq(&tok, "color_temp_kelvin")) {
+            if (ha_json_next(lex, &tok) == HA_JSON_NUMBER) {
+                state->color_temp = (uint16_t)ha_json_token_to_long(&tok);
+                *fields |= HA_LIGHT_FIELD_COLOR_TEMP;
+            }
+        } else if (ha_json_token_eq(&tok, "rgb_color")) {
+            uint8_t rgb[3] = {0};
+            int n = 0;
+            if (ha_json_next(lex, &tok) != HA_JSON_ARRAY_BEGIN) {
+                continue;  /* null while the light is off */
+            }
+            while (ha_json_next(lex, &tok) == HA_JSON_NUMBER) {
+                if (n < 3) {
+                    long v = ha_json_token_to_long(&tok);
+                    rgb[n++] = (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+                }
+            }
+            if (tok.type != HA_JSON_ARRAY_END) {
+                return false;
+            }
+            state->red = rgb[0];
+            state->green = rgb[1];
+            state->blue = rgb[2];
+            *fields |= HA_LIGHT_FIELD_COLOR;
+        } else if (ha_json_token_eq(&tok, "supported_color_modes")) {
+            if (ha_json_next(lex, &tok) != HA_JSON_ARRAY_BEGIN) {
+                continue;
+            }
+            while (ha_json_next(lex, &tok) == HA_JSON_STRING) {
+                if (color_mode_is_color(&tok)) {
+                    state->type = LIGHT_TYPE_COLOR;
+                }
+            }
+            if (tok.type != HA_JSON_ARRAY_END) {
+                return false;
+            }
+        } else if (!ha_json_skip_value(lex)) {
+            return false;
+        }
+    }
+
+    return tok.type == HA_JSON_OBJECT_END && tok.depth == depth - 1;
+}
+
+/**
+ * Parse a light entity state object
+ * @param lex Tokenizer positioned right after the object's opening brace
+ * @param state Output state; fields missing from the payload are left as is
+ * @param fields Output HA_LIGHT_FIELD_* bits found in the payload
+ */
+static bool parse_light_entity(ha_json_lexer_t *lex, light_state_t *state, uint8_t *fields)
+{
+    ha_json_token_t tok;
+    int depth = lex->depth;
+
+    state->type = LIGHT_TYPE_SWITCH;
+    *fields = 0;
+
+    while (ha_json_next(lex, &tok) == HA_JSON_KEY) {
+        if (ha_json_token_eq(&tok, "entity_id")) {
+            if (ha_json_next(lex, &tok) == HA_JSON_STRING) {
+                ha_json_token_copy(&tok, state->entity_id, sizeof(state->entity_id));
+            }
+        } else if (ha_json_token_eq(&tok, "state")) {
+            if (ha_json_next(lex, &tok) == HA_JSON_STRING) {
+                state->is_on = ha_json_token_eq(&tok, "on");
+                *fields |= HA_LIGHT_FIELD_POWER;
+            }
+        } else if (ha_json_token_eq(&tok, "attributes")) {
+            if (ha_json_next(lex, &tok) != HA_JSON_OBJECT_BEGIN ||
+                !parse_light_attributes(lex, state, fields)) {
+                return false;
+            }
+        } else if (!ha_json_skip_value(lex)) {
+            return false;
+        }
+    }
+
+    return tok.type == HA_JSON_OBJECT_END && tok.depth == depth - 1;
+}
+
+/**
+ * Record server-confirmed fields of an entity
+ */
+static void acked_apply(entity_handle_t entity, const light_state_t *state, uint8_t fields)
+{
+    if (entity >= ENTITY_REGISTRY_MAX) {
+        return;
+    }
+
+    light_state_t *a = &acked[entity].state;
+    if (fields & HA_LIGHT_FIELD_POWER) {
+        a->is_on = state->is_on;
+    }
+    if (fields & HA_LIGHT_FIELD_BRIGHTNESS) {
+        a->brightness = state->brightness;
+    }
+    if (fields & HA_LIGHT_FIELD_COLOR) {
+        a->red = state->red;
+        a->green = state->green;
+        a->blue = state->blue;
+    }
+    if (fields & HA_LIGHT_FIELD_COLOR_TEMP) {
+        a->color_temp = state->color_temp;
+    }
+    acked[entity].known |= fields;
+}
+
+/**
+ * Queue a state push for the UI thread, waiting for room
+ * @return false if the threads are stopping
+ */
+static bool push_publish(const ha_push_t *push)
+{
+    /* TCP pushes back on the server while the UI thread catches up */
+    uint32_t index;
+    while (!ring_write_slot(&push_ring, &index)) {
+        if (__atomic_load_n(&worker_stop, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+        struct timespec ts = {0, 1000000};
+        nanosleep(&ts, NULL);
+    }
+    push_slots[index] = *push;
+    ring_publish(&push_ring);
+    notify_ui();
+    return true;
+}
+
+/**
+ * Parse one captured entity object into the next free light slot, or queue
+ * it as a push
+ */
+static void bulk_finish_object(ha_bulk_loader_t *loader)
+{
+    static const char prefix[] = "{\"entity_id\":\"";
+
+    if (loader->overflow) {
+        fprintf(stderr, "HA: skipping entity larger than %d bytes\n", HA_API_ENTITY_MAX);
+        return;
+    }
+
+    /* Home Assistant emits entity_id first; reject other domains without parsing */
+    if (loader->obj_len > sizeof(prefix) + 6 &&
+        memcmp(loader->obj, prefix, sizeof(prefix) - 1) == 0 &&
+        memcmp(loader->obj + sizeof(prefix) - 1, "light.", 6) != 0) {
+        return;
+    }
+
+    if (loader->push) {
+        ha_push_t push;
+        ha_json_lexer_t lex;
+        ha_json_token_t tok;
+
+        memset(&push, 0, sizeof(push));
+        ha_json_init(&lex, loader->obj, loader->obj_len);
+        if (ha_json_next(&lex, &tok) == HA_JSON_OBJECT_BEGIN &&
+            parse_light_entity(&lex, &push.state, &push.fields) &&
+            strncmp(push.state.entity_id, "light.", 6) == 0 && push_publish(&push)) {
+            loader->count++;
+        }
+        return;
+    }
+
+    if (loader->count >= loader->max_lights) {
+        if (loader->count == loader->max_lights) {
+            fprintf(stderr, "HA: more than %d lights, ignoring the rest\n", loader->max_lights);
+            loader->count++;
+        }
+        return;
+    }
+
+    light_state_t *light = &loader->lights[loader->count];
+    ha_json_lexer_t lex;
+    ha_json_token_t tok;
+    uint8_t fields;
+
+    memset(light, 0, sizeof(*light));
+    ha_json_init(&lex, loader->obj, loader->obj_len);
+    if (ha_json_next(&lex, &tok) != HA_JSON_OBJECT_BEGIN ||
+        !parse_light_entity(&lex, light, &fields) ||
+        strncmp(light->entity_id, "light.", 6) != 0) {
+        return;
+    }
+
+    if (light->name[0] == '\0') {
+        memcpy(light->name, light->entity_id, sizeof(light->name));
+    }
+    if (loader->fields) {
+        loader->fields[loader->count] = fields;
+    }
+    if (loader->intern) {
+        /* Runs on the UI thread (ha_api_load_lights blocks), so it may intern */
+        light->handle = entity_registry_intern(light->entity_id);
+        acked_apply(light->handle, light, fields);
+    } else {
+        /* Worker thread: the UI thread resolves handles on delivery */
+        light->handle = ENTITY_HANDLE_INVALID;
+    }
+    loader->count++;
+}
+
+/**
+ * Split the /api/states array into entity objects as the body streams in
+ */
+static void bulk_feed(const char *data, size_t len, void *user_data)
+{
+    ha_bulk_loader_t *loader = (ha_bulk_loader_t *)user_data;
+
+    for (size_t i = 0; i < len; i++) {
+        char c = data[i];
+
+        if (loader->depth >= 2 || (c == '{' && loader->depth == 1 && !loader->in_string)) {
+            if (loader->depth == 1) {
+                loader->obj_len = 0;
+                loader->overflow = false;
+            }
+            if (loader->obj_len < sizeof(loader->obj)) {
+                loader->obj[loader->obj_len++] = c;
+            } else {
+                loader->overflow = true;
+            }
+        }
+
+        if (loader->in_string) {
+            if (loader->escape) {
+                loader->escape = false;
+            } else if (c == '\\') {
+                loader->escape = true;
+            } else if (c == '"') {
+                loader->in_string = false;
+            }
+            continue;
+        }
+
+        switch (c) {
+        case '"':
+            loader->in_string = true;
+            break;
+        case '{':
+        case '[':
+            loader->depth++;
+            break;
+        case '}':
+        case ']':
+            loader->depth--;
+            if (loader->depth == 1 && c == '}') {
+                bulk_finish_object(loader);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * Collect a response body into response_buf
+ */
+static void collect_response(const char *data, size_t len, void *user_data)
+{
+    (void)user_data;
+
+    if (response_len + len > sizeof(response_buf)) {
+        len = sizeof(response_buf) - response_len;
+        response_truncated = true;
+    }
+    memcpy(response_buf + response_len, data, len);
+    response_len += len;
+}
+
+/**
+ * HTTP method of a job
+ */
+static const char *job_method(const ha_job_t *job)
+{
+    return job->kind == HA_JOB_SERVICE ? "POST" : "GET";
+}
+
+/**
+ * Forget a partially parsed light list before (re)reading it
+ */
+static void bulk_reset(ha_bulk_loader_t *loader)
+{
+    memset(&loader->count, 0, offsetof(ha_bulk_loader_t, obj) - offsetof(ha_bulk_loader_t, count));
+}
+
+/**
+ * Read and interpret the response to a job
+ */
+static void job_read_response(ha_http_conn_t *conn, const ha_job_t *job, ha_done_t *done)
+{
+    if (job->kind == HA_JOB_SERVICE) {
+        done->http_status = ha_http_read_response(conn, "POST", NULL, NULL);
+        return;
+    }
+    if (job->kind == HA_JOB_LOAD_STATES) {
+        bulk_reset(&refresh_loader);
+        done->http_status = ha_http_read_response(conn, "GET", bulk_feed, &refresh_loader);
+        return;
+    }
+
+    response_len = 0;
+    response_truncated = false;
+    done->http_status = ha_http_read_response(conn, "GET", collect_response, NULL);
+}
+
+/**
+ * Run a job synchronously on a fresh or idle connection
+ */
+static void job_run_now(ha_http_conn_t *conn, const ha_job_t *job, ha_done_t *done)
+{
+    ha_http_body_cb_t on_body = NULL;
+    void *body_user_data = NULL;
+
+    if (job->kind == HA_JOB_GET_STATE) {
+        response_len = 0;
+        response_truncated = false;
+        on_body = collect_response;
+    } else if (job->kind == HA_JOB_LOAD_STATES) {
+        bulk_reset(&refresh_loader);
+        on_body = bulk_feed;
+        body_user_data = &refresh_loader;
+    }
+    done->http_status = ha_http_request(conn, job_method(job), job->path, ha_token,
+                                        job->kind == HA_JOB_SERVICE ? job->body : NULL,
+                                        on_body, body_user_data);
+}
+
+/**
+ * Turn the collected response of a state read into a light state
+ */
+static void job_finish(const ha_job_t *job, ha_done_t *done)
+{
+    if (job->kind != HA_JOB_GET_STATE || done->http_status / 100 != 2) {
+        return;
+    }
+
+    ha_json_lexer_t lex;
+    ha_json_token_t tok;
+
+    ha_json_init(&lex, response_buf, response_len);
+    done->has_state = !response_truncated &&
+                      ha_json_next(&lex, &tok) == HA_JSON_OBJECT_BEGIN &&
+                      parse_light_entity(&lex, &done->state, &done->state_fields);
+    done->state.handle = job->entity;
+    if (!done->has_state) {
+        fprintf(stderr, "HA: could not parse state response for %s\n", job->path);
+    }
+}
+
+/**
+ * Execute the queued jobs, pipelining them over the connection pool
+ * @return Number of jobs executed (results are in done[])
+ */
+static uint32_t worker_run_batch(ha_done_t *done)
+{
+    TRACE_FUNC();
+    uint32_t job_index[HA_API_BATCH_MAX];
+    int job_conn[HA_API_BATCH_MAX];
+    uint32_t job_opens[HA_API_BATCH_MAX];
+    uint32_t job_sent_at[HA_API_BATCH_MAX];
+    bool job_sent[HA_API_BATCH_MAX];
+#if DASHBOARD_TRACE
+    uint64_t job_trace_start[HA_API_BATCH_MAX];
+#endif
+    int load[HA_API_POOL_SIZE] = {0};
+    uint32_t count = 0;
+    int next_conn = 0;
+
+    /* Assign jobs round-robin; a connection not yet known to keep requests
+     * alive takes a single request per batch */
+    while (count < HA_API_BATCH_MAX && ring_peek_slot(&job_ring, count, &job_index[count])) {
+        int c = -1;
+        for (int n = 0; n < HA_API_POOL_SIZE; n++) {
+            int candidate = (next_conn + n) % HA_API_POOL_SIZE;
+            int depth = pool[candidate].pipelining ? HA_API_PIPELINE_DEPTH : 1;
+            if (load[candidate] < depth) {
+                c = candidate;
+                break;
+            }
+        }
+        if (c < 0) {
+            break;
+        }
+        job_conn[count] = c;
+        load[c]++;
+        next_conn = (c + 1) % HA_API_POOL_SIZE;
+        count++;
+    }
+
+    /* Send everything first... */
+    for (uint32_t k = 0; k < count; k++) {
+        const ha_job_t *job = &job_slots[job_index[k]];
+        ha_http_conn_t *conn = &pool[job_conn[k]];
+
+        memset(&done[k], 0, sizeof(done[k]));
+        done[k].id = job->id;
+        done[k].kind = job->kind;
+        done[k].entity = job->entity;
+        done[k].ack_fields = job->ack_fields;
+        done[k].unsent = job->unsent;
+        done[k].state = job->target;
+        done[k].group_count = job->group_count;
+        memcpy(done[k].group, job->group, job->group_count * sizeof(job->group[0]));
+
+        job_sent_at[k] = ha_http_now_ms();
+#if DASHBOARD_TRACE
+        job_trace_start[k] = trace_now_ns();
+#endif
+        job_sent[k] = ha_http_send_request(conn, job_method(job), job->path, ha_token,
+                                           job->kind == HA_JOB_SERVICE ? job->body : NULL);
+        job_opens[k] = conn->opens;
+    }
+
+    /* ...then collect the responses in order */
+    for (uint32_t k = 0; k < count; k++) {
+        const ha_job_t *job = &job_slots[job_index[k]];
+        ha_http_conn_t *conn = &pool[job_conn[k]];
+
+        /* Still the connection the request went out on? */
+        if (job_sent[k] && conn->fd >= 0 && conn->opens == job_opens[k]) {
+            job_read_response(conn, job, &done[k]);
+            if (done[k].http_status >= 0) {
+                ha_http_conn_record_rtt(conn, ha_http_now_ms() - job_sent_at[k]);
+            }
+        } else {
+            done[k].http_status = -1;
+        }
+
+        /* The connection dropped under a pipelined batch: fall back to
+         * one request at a time on a new connection */
+        if (done[k].http_status < 0) {
+            conn->pipelining = false;
+            job_run_now(conn, job, &done[k]);
+        }
+
+        job_finish(job, &done[k]);
+        TRACE_COMPLETE("ha_request", job_trace_start[k]);
+        if (done[k].http_status / 100 != 2) {
+            fprintf(stderr, "HA: request %s failed (status %d)\n", job->path, done[k].http_status);
+        }
+    }
+
+    /* Publish a consistent copy of the statistics for the UI thread */
+    pthread_mutex_lock(&stats_lock);
+    for (int c = 0; c < HA_API_POOL_SIZE; c++) {
+        pool_stats[c] = pool[c].stats;
+    }
+    pthread_mutex_unlock(&stats_lock);
+
+    return count;
+}
+
+/**
+ * I/O worker thread
+ */
+static void *worker_main(void *arg)
+{
+    (void)arg;
+    ha_done_t done[HA_API_BATCH_MAX];
+
+    TRACE_THREAD_NAME("ha_worker");
+    for (int c = 0; c < HA_API_POOL_SIZE; c++) {
+        ha_http_conn_init(&pool[c], &endpoint);
+    }
+
+    while (!__atomic_load_n(&worker_stop, __ATOMIC_ACQUIRE)) {
+        sem_wait(&worker_sem);
+
+        /* One wakeup may cover several jobs; extra wakeups find the ring empty */
+        uint32_t count;
+        while ((count = worker_run_batch(done)) > 0) {
+            for (uint32_t k = 0; k < count; k++) {
+                ring_consume(&job_ring);
+            }
+
+            /* Wait for the UI thread to make room for the results */
+            for (uint32_t k = 0; k < count; k++) {
+                uint32_t done_index;
+                while (!ring_write_slot(&done_ring, &done_index)) {
+                    if (__atomic_load_n(&worker_stop, __ATOMIC_ACQUIRE)) {
+                        goto out;
+                    }
+                    struct timespec ts = {0, 1000000};
+                    nanosleep(&ts, NULL);
+                }
+                done_slots[done_index] = done[k];
+                ring_publish(&done_ring);
+            }
+            notify_ui();
+
+            if (__atomic_load_n(&worker_stop, __ATOMIC_ACQUIRE)) {
+                goto out;
+            }
+        }
+    }
+
+out:
+    for (int c = 0; c < HA_API_POOL_SIZE; c++) {
+        ha_http_conn_close(&pool[c]);
+    }
+    return NULL;
+}
+
+/**
+ * Parse the "event" member of a state_changed message
+ * @return false on malformed input or an entity that is not a light
+ */
+static bool parse_ws_event(ha_json_lexer_t *lex, ha_push_t *push, bool *has_state)
+{
+    ha_json_token_t tok;
+
+    while (ha_json_next(lex, &tok) == HA_JSON_KEY) {
+        if (!ha_json_token_eq(&tok, "data")) {
+            if (!ha_json_skip_value(lex)) {
+                return false;
+            }
+            continue;
+        }
+        if (ha_json_next(lex, &tok) != HA_JSON_OBJECT_BEGIN) {
+            return false;
+        }
+        while (ha_json_next(lex, &tok) == HA_JSON_KEY) {
+            if (ha_json_token_eq(&tok, "entity_id")) {
+                /* Bail out early on the (many) non-light entities */
+                if (ha_json_next(lex, &tok) != HA_JSON_STRING ||
+                    !ha_json_token_has_prefix(&tok, "light.")) {
+                    return false;
+                }
+            } else if (ha_json_token_eq(&tok, "new_state")) {
+                ha_json_type_t type = ha_json_next(lex, &tok);
+                if (type == HA_JSON_OBJECT_BEGIN) {
+                    if (!parse_light_entity(lex, &push->state, &push->fields)) {
+                        return false;
+                    }
+                    *has_state = true;
+                } else if (type != HA_JSON_NULL) {
+                    return false;
+                }
+            } else if (!ha_json_skip_value(lex)) {
+                return false;
+            }
+        }
+    }
+
+    return tok.type == HA_JSON_OBJECT_END;
+}
+
+/**
+ * Classify a WebSocket message and extract a light state push
+ */
+static ha_ws_msg_t parse_ws_message(const char *json, size_t len, ha_push_t *push)
+{
+    TRACE_FUNC();
+    ha_json_lexer_t lex;
+    ha_json_token_t tok;
+    ha_json_token_t type = {HA_JSON_NULL, NULL, 0, 0};
+    bool success = false;
+    bool has_state = false;
+
+    ha_json_init(&lex, json, len);
+    if (ha_json_next(&lex, &tok) != HA_JSON_OBJECT_BEGIN) {
+        return HA_WS_MSG_OTHER;
+    }
+
+    while (ha_json_next(&lex, &tok) == HA_JSON_KEY) {
+        if (ha_json_token_eq(&tok, "type")) {
+            ha_json_next(&lex, &type);
+        } else if (ha_json_token_eq(&tok, "success")) {
+            success = ha_json_next(&lex, &tok) == HA_JSON_TRUE;
+        } else if (ha_json_token_eq(&tok, "event")) {
+            if (ha_json_next(&lex, &tok) != HA_JSON_OBJECT_BEGIN ||
+                !parse_ws_event(&lex, push, &has_state)) {
+                return HA_WS_MSG_OTHER;
+            }
+        } else if (!ha_json_skip_value(&lex)) {
+            return HA_WS_MSG_OTHER;
+        }
+    }
+
+    if (type.type != HA_JSON_STRING) {
+        return HA_WS_MSG_OTHER;
+    }
+    if (ha_json_token_eq(&type, "event")) {
+        return has_state ? HA_WS_MSG_STATE : HA_WS_MSG_OTHER;
+    }
+    if (ha_json_token_eq(&type, "auth_required")) {
+        return HA_WS_MSG_AUTH_REQUIRED;
+    }
+    if (ha_json_token_eq(&type, "auth_ok")) {
+        return HA_WS_MSG_AUTH_OK;
+    }
+    if (ha_json_token_eq(&type, "auth_invalid")) {
+        return HA_WS_MSG_AUTH_INVALID;
+    }
+    if (ha_json_token_eq(&type, "result")) {
+        return success ? HA_WS_MSG_RESULT_OK : HA_WS_MSG_RESULT_ERROR;
+    }
+    return HA_WS_MSG_OTHER;
+}
+
+/**
+ * Fetch every light once the subscription is back after a reconnect and
+ * queue them as pushes, so changes missed while disconnected reach the cards.
+ * Events arriving meanwhile wait in the socket and are applied afterwards.
+ */
+static void ws_resync(void)
+{
+    static ha_bulk_loader_t loader;
+
+    memset(&loader, 0, offsetof(ha_bulk_loader_t, obj));
+    loader.push = true;
+
+    ha_http_conn_t conn;
+    ha_http_conn_init(&conn, &endpoint);
+    int status = ha_http_request(&conn, "GET", "/api/states", ha_token, NULL, bulk_feed, &loader);
+    ha_http_conn_close(&conn);
+
+    if (status / 100 != 2) {
+        fprintf(stderr, "HA: resynchronizing states failed (status %d)\n", status);
+    } else {
+        printf("HA: resynchronized %d lights after reconnecting\n", loader.count);
+    }
+}
+
+/**
+ * Run one authenticated WebSocket session until the connection drops
+ * @param resync Fetch every light once subscribed (the session replaces a lost one)
+ * @return false if the token was rejected (no point in reconnecting)
+ */
+static bool ws_session(bool resync)
+{
+    char msg[384];
+    size_t len;
+
+    while (ha_ws_recv(&ws_conn, ws_buf, sizeof(ws_buf), &len)) {
+        ha_push_t push;
+        memset(&push, 0, sizeof(push));
+
+        switch (parse_ws_message(ws_buf, len, &push)) {
+        case HA_WS_MSG_AUTH_REQUIRED: {
+            int n = snprintf(msg, sizeof(msg), "{\"type\":\"auth\",\"access_token\":\"%s\"}", ha_token);
+            if (n < 0 || (size_t)n >= sizeof(msg) || !ha_ws_send_text(&ws_conn, msg, (size_t)n)) {
+                return true;
+            }
+            break;
+        }
+
+        case HA_WS_MSG_AUTH_OK: {
+            int n = snprintf(msg, sizeof(msg),
+                             "{\"id\":1,\"type\":\"subscribe_events\",\"event_type\":\"state_changed\"}");
+            if (!ha_ws_send_text(&ws_conn, msg, (size_t)n)) {
+                return true;
+            }
+            break;
+        }
+
+        case HA_WS_MSG_AUTH_INVALID:
+            fprintf(stderr, "HA: WebSocket authentication rejected, check HA_TOKEN\n");
+            return false;
+
+        case HA_WS_MSG_RESULT_OK:
+            printf("HA: subscribed to state changes\n");
+            if (resync) {
+                ws_resync();
+            }
+            break;
+
+        case HA_WS_MSG_RESULT_ERROR:
+            fprintf(stderr, "HA: state subscription failed\n");
+            return true;
+
+        case HA_WS_MSG_STATE:
+            if (!push_publish(&push)) {
+                return false;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * WebSocket thread: keep a state_changed subscription alive
+ */
+static void *ws_main(void *arg)
+{
+    (void)arg;
+    unsigned backoff = HA_API_WS_BACKOFF_MIN_S;
+    bool reconnecting = false;  /* A session was lost: resynchronize the next one */
+
+    TRACE_THREAD_NAME("ha_ws");
+    while (!__atomic_load_n(&worker_stop, __ATOMIC_ACQUIRE)) {
+        if (ha_ws_connect(&ws_conn, &endpoint, "/api/websocket")) {
+            if (!__atomic_load_n(&worker_stop, __ATOMIC_ACQUIRE) && !ws_session(reconnecting)) {
+                ha_ws_close(&ws_conn);
+                break;
+            }
+            ha_ws_close(&ws_conn);
+            reconnecting = true;
+            backoff = HA_API_WS_BACKOFF_MIN_S;
+        }
+
+        if (__atomic_load_n(&worker_stop, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+
+        /* Interruptible wait before reconnecting */
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += backoff;
+        sem_timedwait(&ws_sem, &deadline);
+        backoff = backoff * 2 > HA_API_WS_BACKOFF_MAX_S ? HA_API_WS_BACKOFF_MAX_S : backoff * 2;
+    }
+
+    __atomic_store_n(&ws_exited, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/**
+ * Queue a job for the worker
+ * @param entity Entity the job targets
+ * @param ack_fields Fields of target applied to the entity on success
+ * @param unsent Requested fields the call leaves out, reported in the result
+ * @param target State the job sets, or NULL
+ * @param group Entities of a multi-light call, also acknowledged on success
+ * @param group_count Number of entities in group
+ */
+static ha_request_t submit_job(ha_job_kind_t kind, const char *path, const char *body,
+                               entity_handle_t entity, uint8_t ack_fields, uint8_t unsent,
+                               const light_state_t *target,
+                               const entity_handle_t *group, int group_count)
+{
+    uint32_t index;
+
+    if (!ring_write_slot(&job_ring, &index)) {
+        fprintf(stderr, "HA: request queue full, dropping %s\n", path);
+        return HA_REQUEST_INVALID;
+    }
+
+    ha_job_t *job = &job_slots[index];
+    job->id = next_request_id++;
+    if (next_request_id == HA_REQUEST_INVALID) {
+        next_request_id = 1;
+    }
+    job->kind = kind;
+    snprintf(job->path, sizeof(job->path), "%s", path);
+    snprintf(job->body, sizeof(job->body), "%s", body ? body : "");
+    job->entity = entity;
+    job->ack_fields = ack_fields;
+    job->unsent = unsent;
+    job->group_count = (uint8_t)group_count;
+    if (group_count > 0) {
+        memcpy(job->group, group, (size_t)group_count * sizeof(job->group[0]));
+    }
+    if (target) {
+        job->target = *target;
+    }
+
+    ring_publish(&job_ring);
+    sem_post(&worker_sem);
+
+    return job->id;
+}
 
 /**
  * Initialize Home Assistant API connection
@@ -21,137 +1070,558 @@ bool ha_api_init(const char *url, const char *token)
     if (!url || !token) {
         return false;
     }
-    
+
+    if (initialized) {
+        return true;
+    }
+
     strncpy(ha_url, url, sizeof(ha_url) - 1);
     ha_url[sizeof(ha_url) - 1] = '\0';  /* Ensure null termination */
-    
+
     strncpy(ha_token, token, sizeof(ha_token) - 1);
     ha_token[sizeof(ha_token) - 1] = '\0';  /* Ensure null termination */
-    
+
+    if (!ha_http_parse_url(ha_url, &endpoint)) {
+        fprintf(stderr, "Invalid Home Assistant URL: %s\n", ha_url);
+        return false;
+    }
+
+    memset(&job_ring, 0, sizeof(job_ring));
+    memset(&done_ring, 0, sizeof(done_ring));
+    memset(&push_ring, 0, sizeof(push_ring));
+    worker_stop = 0;
+
+    notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (notify_fd < 0) {
+        fprintf(stderr, "HA: eventfd failed, results are only seen when polled\n");
+    }
+
+    if (sem_init(&worker_sem, 0, 0) != 0) {
+        return false;
+    }
+    if (pthread_create(&worker_thread, NULL, worker_main, NULL) != 0) {
+        sem_destroy(&worker_sem);
+        return false;
+    }
+
     initialized = true;
-    
+
     printf("Home Assistant API initialized with URL: %s\n", ha_url);
     return true;
 }
 
 /**
- * Get light state from Home Assistant
- * Note: This is a stub implementation. In a real application, this would
- * make HTTP requests to the Home Assistant REST API.
+ * Stop the I/O thread
  */
-bool ha_api_get_light_state(const char *entity_id, light_state_t *state)
+void ha_api_deinit(void)
 {
-    if (!initialized || !entity_id || !state) {
-        return false;
+    if (!initialized) {
+        return;
     }
-    
-    printf("Getting state for light: %s\n", entity_id);
-    
-    /* In a real implementation, this would:
-     * 1. Make HTTP GET request to: {ha_url}/api/states/{entity_id}
-     * 2. Parse JSON response
-     * 3. Extract light state data
-     * 4. Populate the state structure
-     */
-    
-    return true;
+
+    __atomic_store_n(&worker_stop, 1, __ATOMIC_RELEASE);
+    sem_post(&worker_sem);
+    pthread_join(worker_thread, NULL);
+    sem_destroy(&worker_sem);
+
+    if (ws_started) {
+        /* Keep kicking the socket until the thread notices, it may be reconnecting */
+        while (!__atomic_load_n(&ws_exited, __ATOMIC_ACQUIRE)) {
+            ha_ws_interrupt(&ws_conn);
+            sem_post(&ws_sem);
+            struct timespec ts = {0, 10000000};
+            nanosleep(&ts, NULL);
+        }
+        pthread_join(ws_thread, NULL);
+        sem_destroy(&ws_sem);
+        ws_started = false;
+    }
+
+    if (notify_fd >= 0) {
+        close(notify_fd);
+        notify_fd = -1;
+    }
+
+    initialized = false;
 }
 
 /**
- * Set light state in Home Assistant
+ * Check whether the API was initialized
  */
-bool ha_api_set_light_state(const char *entity_id, const light_state_t *state)
+bool ha_api_is_initialized(void)
 {
-    if (!initialized || !entity_id || !state) {
+    return initialized;
+}
+
+/**
+ * Check whether the request queue has no room for another call
+ */
+bool ha_api_queue_full(void)
+{
+    /* Only the UI thread queues jobs, so a free slot stays free until then */
+    uint32_t head = __atomic_load_n(&job_ring.head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&job_ring.tail, __ATOMIC_ACQUIRE);
+    return head - tail >= HA_API_QUEUE_SIZE;
+}
+
+/**
+ * Set the callback receiving request results
+ */
+void ha_api_set_result_cb(ha_api_result_cb_t cb, void *user_data)
+{
+    result_cb = cb;
+    result_cb_user_data = user_data;
+}
+
+/**
+ * Get the statistics of one pooled connection
+ */
+bool ha_api_get_connection_stats(int index, ha_http_stats_t *stats)
+{
+    if (index < 0 || index >= HA_API_POOL_SIZE || !stats) {
         return false;
     }
-    
-    printf("Setting state for light %s: on=%d, brightness=%d\n", 
-           entity_id, state->is_on, state->brightness);
-    
-    /* In a real implementation, this would:
-     * 1. Build JSON payload with light state
-     * 2. Make HTTP POST request to: {ha_url}/api/services/light/turn_on or turn_off
-     * 3. Handle response
-     */
-    
+
+    pthread_mutex_lock(&stats_lock);
+    *stats = pool_stats[index];
+    pthread_mutex_unlock(&stats_lock);
     return true;
 }
 
 /**
- * Turn light on/off
+ * File descriptor that becomes readable when there is work for ha_api_process
  */
-bool ha_api_set_light_power(const char *entity_id, bool on)
+int ha_api_get_event_fd(void)
 {
-    if (!initialized || !entity_id) {
+    return notify_fd;
+}
+
+/**
+ * Set the callback receiving pushed state changes
+ */
+void ha_api_set_state_cb(ha_api_state_cb_t cb, void *user_data)
+{
+    state_cb = cb;
+    state_cb_user_data = user_data;
+}
+
+/**
+ * Start the WebSocket state subscription
+ */
+bool ha_api_subscribe_states(void)
+{
+    if (!initialized) {
+        return false;
+    }
+    if (ws_started) {
+        return true;
+    }
+
+    ha_http_conn_init(&ws_conn.http, &endpoint);
+    ws_exited = 0;
+    if (sem_init(&ws_sem, 0, 0) != 0) {
         return false;
     }
-    
-    printf("Turning light %s %s\n", entity_id, on ? "ON" : "OFF");
-    
-    /* In a real implementation:
-     * POST to {ha_url}/api/services/light/turn_on or turn_off
-     * with JSON body: {"entity_id": entity_id}
-     */
-    
+    if (pthread_create(&ws_thread, NULL, ws_main, NULL) != 0) {
+        sem_destroy(&ws_sem);
+        return false;
+    }
+
+    ws_started = true;
     return true;
 }
 
 /**
- * Set light brightness
+ * Hand a finished background light refresh to its callback
  */
-bool ha_api_set_light_brightness(const char *entity_id, uint8_t brightness)
+static void refresh_deliver(const ha_done_t *done)
 {
-    if (!initialized || !entity_id) {
-        return false;
+    TRACE_FUNC();
+    ha_bulk_loader_t *loader = &refresh_loader;
+    int count = -1;
+
+    refresh_pending = false;
+    if (done->http_status / 100 == 2) {
+        count = loader->count < loader->max_lights ? loader->count : loader->max_lights;
+        for (int i = 0; i < count; i++) {
+            light_state_t *light = &loader->lights[i];
+            light->handle = entity_registry_find(light->entity_id);
+            acked_apply(light->handle, light, loader->fields[i]);
+        }
+    }
+
+    if (refresh_cb) {
+        refresh_cb(loader->lights, loader->fields, count, refresh_cb_user_data);
     }
-    
-    printf("Setting brightness for light %s to %d\n", entity_id, brightness);
-    
-    /* In a real implementation:
-     * POST to {ha_url}/api/services/light/turn_on
-     * with JSON body: {"entity_id": entity_id, "brightness": brightness}
-     */
-    
-    return true;
 }
 
 /**
- * Set light color (RGB)
+ * Deliver completed requests on the UI thread
  */
-bool ha_api_set_light_color(const char *entity_id, uint8_t red, uint8_t green, uint8_t blue)
+void ha_api_process(void)
 {
-    if (!initialized || !entity_id) {
-        return false;
+    TRACE_FUNC();
+    uint32_t index;
+
+    if (!initialized) {
+        return;
+    }
+
+    /* Reset the wakeup counter before draining so no notification is lost */
+    if (notify_fd >= 0) {
+        uint64_t pending;
+        ssize_t n = read(notify_fd, &pending, sizeof(pending));
+        (void)n;
+    }
+
+    while (ring_read_slot(&done_ring, &index)) {
+        const ha_done_t *done = &done_slots[index];
+
+        if (done->kind == HA_JOB_LOAD_STATES) {
+            refresh_deliver(done);
+            ring_consume(&done_ring);
+            continue;
+        }
+
+        if (done->http_status / 100 == 2) {
+            acked_apply(done->entity, &done->state,
+                        done->has_state ? done->state_fields : done->ack_fields);
+            for (int i = 0; i < done->group_count; i++) {
+                acked_apply(done->group[i], &done->state, done->ack_fields);
+            }
+        }
+
+        if (result_cb) {
+            ha_api_result_t result;
+            result.request = done->id;
+            result.entity = done->entity;
+            result.http_status = done->http_status;
+            result.success = done->http_status / 100 == 2;
+            result.unsent = done->unsent;
+            result.state = done->has_state ? &done->state : NULL;
+            result_cb(&result, result_cb_user_data);
+        }
+
+        ring_consume(&done_ring);
+    }
+
+    while (ring_read_slot(&push_ring, &index)) {
+        /* Only entities the UI registered are of interest */
+        entity_handle_t entity = entity_registry_find(push_slots[index].state.entity_id);
+        if (entity != ENTITY_HANDLE_INVALID) {
+            ha_push_t push = push_slots[index];
+            push.state.handle = entity;
+            acked_apply(entity, &push.state, push.fields);
+            if (state_cb) {
+                state_cb(&push.state, push.fields, state_cb_user_data);
+            }
+        }
+
+        ring_consume(&push_ring);
     }
-    
-    printf("Setting color for light %s to RGB(%d, %d, %d)\n", 
-           entity_id, red, green, blue);
-    
-    /* In a real implementation:
-     * POST to {ha_url}/api/services/light/turn_on
-     * with JSON body: {"entity_id": entity_id, "rgb_color": [red, green, blue]}
-     */
-    
-    return true;
 }
 
 /**
- * Set light color temperature
+ * Load all lights with one GET /api/states
+ */
+int ha_api_load_lights(light_state_t *lights, int max_lights)
+{
+    TRACE_FUNC();
+    static ha_bulk_loader_t loader;
+
+    if (!initialized || !lights || max_lights <= 0) {
+        return -1;
+    }
+
+    memset(&loader, 0, offsetof(ha_bulk_loader_t, obj));
+    loader.lights = lights;
+    loader.intern = true;
+    loader.max_lights = max_lights;
+
+    ha_http_conn_t conn;
+    ha_http_conn_init(&conn, &endpoint);
+    int status = ha_http_request(&conn, "GET", "/api/states", ha_token, NULL, bulk_feed, &loader);
+    ha_http_conn_close(&conn);
+
+    if (status / 100 != 2) {
+        fprintf(stderr, "HA: loading states failed (status %d)\n", status);
+        return -1;
+    }
+
+    return loader.count < max_lights ? loader.count : max_lights;
+}
+
+/**
+ * Load every light in the background
+ */
+ha_request_t ha_api_refresh_lights(light_state_t *lights, uint8_t *fields, int max_lights,
+                                   ha_api_lights_cb_t cb, void *user_data)
+{
+    if (!initialized || !lights || !fields || max_lights <= 0 || refresh_pending) {
+        return HA_REQUEST_INVALID;
+    }
+
+    memset(&refresh_loader, 0, offsetof(ha_bulk_loader_t, obj));
+    refresh_loader.lights = lights;
+    refresh_loader.fields = fields;
+    refresh_loader.max_lights = max_lights;
+    refresh_cb = cb;
+    refresh_cb_user_data = user_data;
+
+    ha_request_t id = submit_job(HA_JOB_LOAD_STATES, "/api/states", NULL, ENTITY_HANDLE_INVALID,
+                                 0, 0, NULL, NULL, 0);
+    refresh_pending = id != HA_REQUEST_INVALID;
+    return id;
+}
+
+/**
+ * Get light state from Home Assistant
  */
-bool ha_api_set_light_color_temp(const char *entity_id, uint16_t color_temp)
+ha_request_t ha_api_get_light_state(entity_handle_t entity)
 {
+    const char *entity_id = entity_registry_get_id(entity);
     if (!initialized || !entity_id) {
-        return false;
+        return HA_REQUEST_INVALID;
     }
-    
-    printf("Setting color temperature for light %s to %dK\n", 
-           entity_id, color_temp);
-    
-    /* In a real implementation:
-     * POST to {ha_url}/api/services/light/turn_on
-     * with JSON body: {"entity_id": entity_id, "kelvin": color_temp}
-     */
-    
-    return true;
+
+    char path[128];
+    snprintf(path, sizeof(path), "/api/states/%s", entity_id);
+    return submit_job(HA_JOB_GET_STATE, path, NULL, entity, 0, 0, NULL, NULL, 0);
+}
+
+/**
+ * Append formatted text to a request body
+ * @return New length; once the body overflowed, a length >= size
+ */
+static int body_append(char *body, size_t size, int len, const char *fmt, ...)
+{
+    if (len < 0 || (size_t)len >= size) {
+        return (int)size;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(body + len, size - (size_t)len, fmt, args);
+    va_end(args);
+    return n < 0 ? (int)size : len + n;
+}
+
+/**
+ * Finish a light service call body whose target ("{"entity_id":...) is
+ * already written: a turn_off when changed turns the power off, otherwise a
+ * turn_on with the changed attributes
+ * @param body Body buffer
+ * @param size Size of body
+ * @param len Length already written
+ * @param state Requested state
+ * @param changed HA_LIGHT_FIELD_* bits to send
+ * @param commit Output: fields the call sets on success
+ * @param unsent In/out: changed fields the call leaves out are added
+ * @param target Output: power state after the call
+ * @return Service name, or NULL if the body did not fit
+ */
+static const char *light_service_body(char *body, size_t size, int len, const light_state_t *state,
+                                      uint8_t changed, uint8_t *commit, uint8_t *unsent,
+                                      light_state_t *target)
+{
+    const char *service;
+
+    if ((changed & HA_LIGHT_FIELD_POWER) && !state->is_on) {
+        service = "turn_off";
+        *commit = HA_LIGHT_FIELD_POWER;
+        target->is_on = false;
+    } else {
+        if (changed & HA_LIGHT_FIELD_BRIGHTNESS) {
+            len = body_append(body, size, len, ",\"brightness\":%d", state->brightness);
+        }
+        /* rgb_color and color_temp_kelvin are mutually exclusive; RGB wins */
+        if (changed & HA_LIGHT_FIELD_COLOR) {
+            len = body_append(body, size, len, ",\"rgb_color\":[%d,%d,%d]",
+                              state->red, state->green, state->blue);
+        } else if (changed & HA_LIGHT_FIELD_COLOR_TEMP) {
+            len = body_append(body, size, len, ",\"color_temp_kelvin\":%d", state->color_temp);
+        }
+        service = "turn_on";
+        *commit = (uint8_t)(changed | HA_LIGHT_FIELD_POWER);
+        if ((changed & HA_LIGHT_FIELD_COLOR) && (changed & HA_LIGHT_FIELD_COLOR_TEMP)) {
+            /* The server never sees the dropped color temperature */
+            *commit &= (uint8_t)~HA_LIGHT_FIELD_COLOR_TEMP;
+            *unsent |= HA_LIGHT_FIELD_COLOR_TEMP;
+        }
+        target->is_on = true;
+    }
+
+    len = body_append(body, size, len, "}");
+    return (size_t)len < size ? service : NULL;
+}
+
+/**
+ * Queue one merged light service call for the fields that differ from the
+ * last acknowledged state
+ */
+ha_request_t ha_api_update_light(entity_handle_t entity, const light_state_t *state, uint8_t fields)
+{
+    const char *entity_id = entity_registry_get_id(entity);
+    if (!initialized || !entity_id || !state) {
+        return HA_REQUEST_INVALID;
+    }
+
+    /* Drop fields the server already reported with the same value */
+    const ha_acked_t *a = &acked[entity];
+    uint8_t same = 0;
+    if (a->state.is_on == state->is_on) {
+        same |= HA_LIGHT_FIELD_POWER;
+    }
+    if (a->state.brightness == state->brightness) {
+        same |= HA_LIGHT_FIELD_BRIGHTNESS;
+    }
+    if (a->state.red == state->red && a->state.green == state->green && a->state.blue == state->blue) {
+        same |= HA_LIGHT_FIELD_COLOR;
+    }
+    if (a->state.color_temp == state->color_temp) {
+        same |= HA_LIGHT_FIELD_COLOR_TEMP;
+    }
+    uint8_t changed = fields & (uint8_t)~(same & a->known);
+
+    char body[256];
+    const char *service;
+    uint8_t commit;
+    uint8_t unsent = 0;
+    light_state_t target = *state;
+
+    if ((fields & HA_LIGHT_FIELD_POWER) && !state->is_on) {
+        /* Attributes cannot be set on a light that is being turned off */
+        if (!(changed & HA_LIGHT_FIELD_POWER)) {
+            return HA_REQUEST_INVALID;
+        }
+        unsent = changed & (uint8_t)~HA_LIGHT_FIELD_POWER;
+        changed = HA_LIGHT_FIELD_POWER;
+    } else if (changed == 0) {
+        return HA_REQUEST_INVALID;
+    }
+
+    int len = body_append(body, sizeof(body), 0, "{\"entity_id\":\"%s\"", entity_id);
+    service = light_service_body(body, sizeof(body), len, state, changed, &commit, &unsent, &target);
+    if (!service) {
+        fprintf(stderr, "HA: service call for %s too long\n", entity_id);
+        return HA_REQUEST_INVALID;
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), "/api/services/light/%s", service);
+
+    return submit_job(HA_JOB_SERVICE, path, body, entity, commit, unsent, &target, NULL, 0);
+}
+
+/**
+ * Queue one light service call for a group of lights
+ */
+ha_request_t ha_api_update_lights(const ha_light_group_t *group, const light_state_t *state, uint8_t fields)
+{
+    if (!initialized || !group || !state || group->count < 0 || group->count > HA_API_GROUP_MAX ||
+        (!group->area_id && group->count == 0) || fields == 0) {
+        return HA_REQUEST_INVALID;
+    }
+
+    char body[HA_API_BODY_MAX];
+    int len;
+
+    /* Members may differ from each other, so nothing is diffed away */
+    if (group->area_id) {
+        len = body_append(body, sizeof(body), 0, "{\"area_id\":\"%s\"", group->area_id);
+    } else {
+        len = body_append(body, sizeof(body), 0, "{\"entity_id\":[");
+        for (int i = 0; i < group->count; i++) {
+            const char *entity_id = entity_registry_get_id(group->entities[i]);
+            if (!entity_id) {
+                return HA_REQUEST_INVALID;
+            }
+            len = body_append(body, sizeof(body), len, "%s\"%s\"", i ? "," : "", entity_id);
+        }
+        len = body_append(body, sizeof(body), len, "]");
+    }
+
+    uint8_t changed = fields;
+    uint8_t unsent = 0;
+    if ((fields & HA_LIGHT_FIELD_POWER) && !state->is_on) {
+        unsent = fields & (uint8_t)~HA_LIGHT_FIELD_POWER;
+        changed = HA_LIGHT_FIELD_POWER;
+    }
+
+    uint8_t commit;
+    light_state_t target = *state;
+    const char *service = light_service_body(body, sizeof(body), len, state, changed, &commit, &unsent,
+                                             &target);
+    if (!service) {
+        fprintf(stderr, "HA: service call for %d lights too long\n", group->count);
+        return HA_REQUEST_INVALID;
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), "/api/services/light/%s", service);
+
+    return submit_job(HA_JOB_SERVICE, path, body, ENTITY_HANDLE_INVALID, commit, unsent, &target,
+                      group->entities, group->count);
+}
+
+/**
+ * Set light state in Home Assistant
+ */
+ha_request_t ha_api_set_light_state(entity_handle_t entity, const light_state_t *state)
+{
+    if (!state) {
+        return HA_REQUEST_INVALID;
+    }
+
+    uint8_t fields = HA_LIGHT_FIELD_ALL;
+    if (state->type != LIGHT_TYPE_COLOR) {
+        fields &= (uint8_t)~(HA_LIGHT_FIELD_COLOR | HA_LIGHT_FIELD_COLOR_TEMP);
+    }
+    return ha_api_update_light(entity, state, fields);
+}
+
+/**
+ * Turn light on/off
+ */
+ha_request_t ha_api_set_light_power(entity_handle_t entity, bool on)
+{
+    light_state_t state;
+    memset(&state, 0, sizeof(state));
+    state.is_on = on;
+    return ha_api_update_light(entity, &state, HA_LIGHT_FIELD_POWER);
+}
+
+/**
+ * Set light brightness
+ */
+ha_request_t ha_api_set_light_brightness(entity_handle_t entity, uint8_t brightness)
+{
+    light_state_t state;
+    memset(&state, 0, sizeof(state));
+    state.brightness = brightness;
+    return ha_api_update_light(entity, &state, HA_LIGHT_FIELD_BRIGHTNESS);
+}
+
+/**
+ * Set light color (RGB)
+ */
+ha_request_t ha_api_set_light_color(entity_handle_t entity, uint8_t red, uint8_t green, uint8_t blue)
+{
+    light_state_t state;
+    memset(&state, 0, sizeof(state));
+    state.red = red;
+    state.green = green;
+    state.blue = blue;
+    return ha_api_update_light(entity, &state, HA_LIGHT_FIELD_COLOR);
+}
+
+/**
+ * Set light color temperature
+ */
+ha_request_t ha_api_set_light_color_temp(entity_handle_t entity, uint16_t color_temp)
+{
+    light_state_t state;
+    memset(&state, 0, sizeof(state));
+    state.color_temp = color_temp;
+    return ha_api_update_light(entity, &state, HA_LIGHT_FIELD_COLOR_TEMP);
 }
@@ -1,70 +1,264 @@
 /**
  * @file ha_api.h
  * Home Assistant API integration
+ *
+ * All requests are queued to a background I/O thread and return immediately
+ * with a request handle. Results are delivered on the UI thread from
+ * ha_api_process() through the callback set with ha_api_set_result_cb().
+ * State changes pushed over the WebSocket API arrive the same way through
+ * the callback set with ha_api_set_state_cb().
  */
 
 #ifndef HA_API_H
 #define HA_API_H
 
 #include "light_control.h"
+#include "ha_http.h"
+#include "entity_registry.h"
 #include <stdbool.h>
+#include <stdint.h>
+
+/* Handle identifying a queued request */
+typedef uint32_t ha_request_t;
+
+/* Returned when a request could not be queued */
+#define HA_REQUEST_INVALID 0
+
+/* Capacity of the submission and completion queues (power of two) */
+#define HA_API_QUEUE_SIZE 64
+
+/* Persistent HTTP connections kept open to Home Assistant */
+#define HA_API_POOL_SIZE 2
+
+/* Requests pipelined on one connection before reading the responses */
+#define HA_API_PIPELINE_DEPTH 4
+
+/* Most lights in one multi-light service call */
+#define HA_API_GROUP_MAX 32
+
+/* Light attributes, used to select what ha_api_update_light sends */
+#define HA_LIGHT_FIELD_POWER      (1u << 0)
+#define HA_LIGHT_FIELD_BRIGHTNESS (1u << 1)
+#define HA_LIGHT_FIELD_COLOR      (1u << 2)
+#define HA_LIGHT_FIELD_COLOR_TEMP (1u << 3)
+
+/* Lights targeted by one multi-light service call */
+typedef struct {
+    const char *area_id;              /* Target an area, or NULL to list the entities */
+    const entity_handle_t *entities;  /* Lights the call affects (acknowledged on success) */
+    int count;                        /* At most HA_API_GROUP_MAX */
+} ha_light_group_t;
+
+/* Result of a completed request */
+typedef struct {
+    ha_request_t request;
+    entity_handle_t entity;      /* Entity the request targeted, ENTITY_HANDLE_INVALID for a group */
+    bool success;                /* true for a 2xx response */
+    int http_status;             /* HTTP status, or -1 on a transport error */
+    uint8_t unsent;              /* Requested HA_LIGHT_FIELD_* bits the call left out */
+    const light_state_t *state;  /* Parsed state for ha_api_get_light_state, else NULL */
+} ha_api_result_t;
+
+/**
+ * Callback invoked on the UI thread for every completed request
+ * @param result Request result, only valid during the call
+ * @param user_data User data given to ha_api_set_result_cb
+ */
+typedef void (*ha_api_result_cb_t)(const ha_api_result_t *result, void *user_data);
+
+/**
+ * Callback invoked on the UI thread for every pushed light state change
+ * @param state New state (handle identifies the light), only valid during the call.
+ *              Only entities interned in the entity registry are reported.
+ * @param fields HA_LIGHT_FIELD_* bits present in the push; attributes of a
+ *               light that is off are not reported
+ * @param user_data User data given to ha_api_set_state_cb
+ */
+typedef void (*ha_api_state_cb_t)(const light_state_t *state, uint8_t fields, void *user_data);
+
+/**
+ * Callback invoked on the UI thread when a background light refresh finished
+ * @param lights Lights in server order; handle is ENTITY_HANDLE_INVALID for
+ *               entities that are not interned in the entity registry
+ * @param fields HA_LIGHT_FIELD_* bits present for each light
+ * @param count Number of lights, or -1 if the request failed
+ * @param user_data User data given to ha_api_refresh_lights
+ */
+typedef void (*ha_api_lights_cb_t)(const light_state_t *lights, const uint8_t *fields, int count,
+                                   void *user_data);
 
 /**
- * Initialize Home Assistant API connection
+ * Initialize Home Assistant API connection and start the I/O thread
  * @param url Home Assistant URL
  * @param token Long-lived access token
  * @return true if successful
  */
 bool ha_api_init(const char *url, const char *token);
 
+/**
+ * Stop the I/O thread and drop any queued requests
+ */
+void ha_api_deinit(void);
+
+/**
+ * Check whether the API was initialized (requests can be queued)
+ * @return true between ha_api_init and ha_api_deinit
+ */
+bool ha_api_is_initialized(void);
+
+/**
+ * Check whether the request queue is full; calls queued now are dropped
+ * @return true until the I/O thread takes a queued request
+ */
+bool ha_api_queue_full(void);
+
+/**
+ * Set the callback receiving request results
+ * @param cb Callback, or NULL
+ * @param user_data User data passed to the callback
+ */
+void ha_api_set_result_cb(ha_api_result_cb_t cb, void *user_data);
+
+/**
+ * Get the statistics of one pooled keep-alive connection
+ * @param index Connection index, 0 to HA_API_POOL_SIZE - 1
+ * @param stats Output statistics (reuse count, reconnects, RTT histogram)
+ * @return false for an invalid index
+ */
+bool ha_api_get_connection_stats(int index, ha_http_stats_t *stats);
+
+/**
+ * Set the callback receiving pushed light state changes
+ * @param cb Callback, or NULL
+ * @param user_data User data passed to the callback
+ */
+void ha_api_set_state_cb(ha_api_state_cb_t cb, void *user_data);
+
+/**
+ * Open the WebSocket API, authenticate and subscribe to state_changed events.
+ * The connection is re-established automatically until ha_api_deinit().
+ * @return true if the subscription thread was started
+ */
+bool ha_api_subscribe_states(void);
+
+/**
+ * Deliver completed requests and state pushes. Call from the UI thread
+ * whenever the event fd is readable, or periodically.
+ */
+void ha_api_process(void);
+
+/**
+ * Get an eventfd that becomes readable when results or state pushes are
+ * waiting for ha_api_process(), so an event loop can sleep until then
+ * @return File descriptor, or -1 if not initialized
+ */
+int ha_api_get_event_fd(void);
+
+/**
+ * Load every light with a single GET /api/states (blocking)
+ *
+ * The response is split into entity objects while it streams in and each
+ * light.* entity is parsed straight into the next slot of lights; nothing
+ * is allocated and no document tree is built. Each light is interned in the
+ * entity registry and its handle stored in the light state.
+ * @param lights Output array
+ * @param max_lights Capacity of lights
+ * @return Number of lights loaded, or -1 on error
+ */
+int ha_api_load_lights(light_state_t *lights, int max_lights);
+
+/**
+ * Load every light like ha_api_load_lights, but on the I/O thread. The
+ * buffers belong to the I/O thread until the callback ran, and nothing is
+ * interned. Only one refresh can be pending at a time.
+ * @param lights Output array
+ * @param fields Output HA_LIGHT_FIELD_* bits, one per light
+ * @param max_lights Capacity of lights and fields
+ * @param cb Callback receiving the lights (instead of the result callback)
+ * @param user_data User data passed to the callback
+ * @return Request handle, or HA_REQUEST_INVALID
+ */
+ha_request_t ha_api_refresh_lights(light_state_t *lights, uint8_t *fields, int max_lights,
+                                   ha_api_lights_cb_t cb, void *user_data);
+
 /**
  * Get light state from Home Assistant
- * @param entity_id Light entity ID
- * @param state Output light state
- * @return true if successful
+ * @param entity Light entity handle
+ * @return Request handle (state is delivered in the result), or HA_REQUEST_INVALID
  */
-bool ha_api_get_light_state(const char *entity_id, light_state_t *state);
+ha_request_t ha_api_get_light_state(entity_handle_t entity);
 
 /**
- * Set light state in Home Assistant
- * @param entity_id Light entity ID
+ * Update selected light attributes with a single service call
+ *
+ * Only the fields that differ from the last state acknowledged by the server
+ * are sent, merged into one light/turn_on (or light/turn_off) call. When both
+ * the RGB color and the color temperature changed, the RGB color is sent; a
+ * turn_off carries no attributes. Fields left out are reported in the
+ * result's unsent bits and not recorded as acknowledged.
+ * @param entity Light entity handle
+ * @param state Requested state
+ * @param fields HA_LIGHT_FIELD_* bits of state to consider
+ * @return Request handle, or HA_REQUEST_INVALID if nothing changed or the
+ *         request could not be queued
+ */
+ha_request_t ha_api_update_light(entity_handle_t entity, const light_state_t *state, uint8_t fields);
+
+/**
+ * Update selected attributes of several lights with a single service call
+ *
+ * The call targets group->area_id when set, otherwise an entity_id list of
+ * the group's lights. Nothing is diffed: every light may be in a different
+ * state. On success the fields sent are recorded as acknowledged for every
+ * light in group->entities; the others are reported in the result's unsent bits.
+ * @param group Lights to change
+ * @param state Requested state
+ * @param fields HA_LIGHT_FIELD_* bits of state to send
+ * @return Request handle, or HA_REQUEST_INVALID if the request could not be queued
+ */
+ha_request_t ha_api_update_lights(const ha_light_group_t *group, const light_state_t *state, uint8_t fields);
+
+/**
+ * Set light state in Home Assistant (all fields, diffed)
+ * @param entity Light entity handle
  * @param state Light state to set
- * @return true if successful
+ * @return Request handle, or HA_REQUEST_INVALID if nothing changed or the
+ *         request could not be queued
  */
-bool ha_api_set_light_state(const char *entity_id, const light_state_t *state);
+ha_request_t ha_api_set_light_state(entity_handle_t entity, const light_state_t *state);
 
 /**
  * Turn light on/off
- * @param entity_id Light entity ID
+ * @param entity Light entity handle
  * @param on true to turn on, false to turn off
- * @return true if successful
+ * @return Request handle, or HA_REQUEST_INVALID
  */
-bool ha_api_set_light_power(const char *entity_id, bool on);
+ha_request_t ha_api_set_light_power(entity_handle_t entity, bool on);
 
 /**
  * Set light brightness
- * @param entity_id Light entity ID
+ * @param entity Light entity handle
  * @param brightness Brightness value (0-255)
- * @return true if successful
+ * @return Request handle, or HA_REQUEST_INVALID
  */
-bool ha_api_set_light_brightness(const char *entity_id, uint8_t brightness);
+ha_request_t ha_api_set_light_brightness(entity_handle_t entity, uint8_t brightness);
 
 /**
  * Set light color (RGB)
- * @param entity_id Light entity ID
+ * @param entity Light entity handle
  * @param red Red component (0-255)
  * @param green Green component (0-255)
  * @param blue Blue component (0-255)
- * @return true if successful
+ * @return Request handle, or HA_REQUEST_INVALID
  */
-bool ha_api_set_light_color(const char *entity_id, uint8_t red, uint8_t green, uint8_t blue);
+ha_request_t ha_api_set_light_color(entity_handle_t entity, uint8_t red, uint8_t green, uint8_t blue);
 
 /**
  * Set light color temperature
- * @param entity_id Light entity ID
+ * @param entity Light entity handle
  * @param color_temp Color temperature in Kelvin
- * @return true if successful
+ * @return Request handle, or HA_REQUEST_INVALID
  */
-bool ha_api_set_light_color_temp(const char *entity_id, uint16_t color_temp);
+ha_request_t ha_api_set_light_color_temp(entity_handle_t entity, uint16_t color_temp);
 
 #endif /* HA_API_H */
@@ -0,0 +1,515 @@
+/**
+ * @file ha_http.c
+ * Minimal blocking HTTP/1.1 client implementation
+ */
+
+#include "ha_http.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+/* Socket send/receive timeout */
+#define HA_HTTP_TIMEOUT_MS 5000
+
+/* Longest status or header line we accept */
+#define HA_HTTP_MAX_LINE 1024
+
+/**
+ * Parse a URL of the form http://host[:port][/prefix]
+ */
+bool ha_http_parse_url(const char *url, ha_http_endpoint_t *endpoint)
+{
+    if (!url || !endpoint) {
+        return false;
+    }
+
+    memset(endpoint, 0, sizeof(*endpoint));
+
+    if (strncmp(url, "http://", 7) != 0) {
+        fprintf(stderr, "Only http:// URLs are supported: %s\n", url);
+        return false;
+    }
+
+    const char *host = url + 7;
+    const char *host_end = host + strcspn(host, ":/");
+    size_t host_len = (size_t)(host_end - host);
+    if (host_len == 0 || host_len >= sizeof(endpoint->host)) {
+        return false;
+    }
+    memcpy(endpoint->host, host, host_len);
+
+    const char *path = host_end;
+    if (*host_end == ':') {
+        const char *port = host_end + 1;
+        size_t port_len = strcspn(port, "/");
+        if (port_len == 0 || port_len >= sizeof(endpoint->port)) {
+            return false;
+        }
+        memcpy(endpoint->port, port, port_len);
+        path = port + port_len;
+    } else {
+        strcpy(endpoint->port, "80");
+    }
+
+    /* Keep any prefix but drop the trailing slash */
+    size_t path_len = strlen(path);
+    while (path_len > 0 && path[path_len - 1] == '/') {
+        path_len--;
+    }
+    if (path_len >= sizeof(endpoint->base_path)) {
+        return false;
+    }
+    memcpy(endpoint->base_path, path, path_len);
+
+    return true;
+}
+
+/**
+ * Initialize a connection object
+ */
+void ha_http_conn_init(ha_http_conn_t *conn, const ha_http_endpoint_t *endpoint)
+{
+    memset(conn, 0, sizeof(*conn));
+    conn->endpoint = endpoint;
+    conn->fd = -1;
+}
+
+/**
+ * Close a connection
+ */
+void ha_http_conn_close(ha_http_conn_t *conn)
+{
+    if (conn->fd >= 0) {
+        close(conn->fd);
+        conn->fd = -1;
+    }
+    conn->recv_len = 0;
+    conn->recv_pos = 0;
+}
+
+/**
+ * Open the TCP connection to the endpoint
+ */
+bool ha_http_conn_open(ha_http_conn_t *conn)
+{
+    struct addrinfo hints;
+    struct addrinfo *res = NULL;
+
+    ha_http_conn_close(conn);
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    int err = getaddrinfo(conn->endpoint->host, conn->endpoint->port, &hints, &res);
+    if (err != 0) {
+        fprintf(stderr, "HTTP: cannot resolve %s: %s\n", conn->endpoint->host, gai_strerror(err));
+        return false;
+    }
+
+    struct timeval tv;
+    tv.tv_sec = HA_HTTP_TIMEOUT_MS / 1000;
+    tv.tv_usec = (HA_HTTP_TIMEOUT_MS % 1000) * 1000;
+
+    for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+        int fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+
+        /* SO_SNDTIMEO also bounds connect() on Linux */
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            conn->fd = fd;
+            break;
+        }
+        close(fd);
+    }
+
+    freeaddrinfo(res);
+
+    if (conn->fd < 0) {
+        fprintf(stderr, "HTTP: cannot connect to %s:%s\n", conn->endpoint->host, conn->endpoint->port);
+        return false;
+    }
+
+    conn->recv_len = 0;
+    conn->recv_pos = 0;
+    return true;
+}
+
+/**
+ * Send a whole buffer
+ */
+bool ha_http_conn_send(ha_http_conn_t *conn, const char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = send(conn->fd, data, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+/**
+ * Make sure the receive buffer holds unread data
+ * @return false on EOF or error
+ */
+static bool conn_fill(ha_http_conn_t *conn)
+{
+    if (conn->recv_pos < conn->recv_len) {
+        return true;
+    }
+
+    for (;;) {
+        ssize_t n = recv(conn->fd, conn->recv_buf, sizeof(conn->recv_buf), 0);
+        if (n > 0) {
+            conn->recv_len = (size_t)n;
+            conn->recv_pos = 0;
+            return true;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        return false;
+    }
+}
+
+/**
+ * Read one CRLF terminated line, without the line ending
+ */
+bool ha_http_conn_read_line(ha_http_conn_t *conn, char *line, size_t size)
+{
+    size_t len = 0;
+
+    for (;;) {
+        if (!conn_fill(conn)) {
+            return false;
+        }
+        char c = conn->recv_buf[conn->recv_pos++];
+        if (c == '\n') {
+            break;
+        }
+        if (len + 1 >= size) {
+            return false;
+        }
+        line[len++] = c;
+    }
+
+    if (len > 0 && line[len - 1] == '\r') {
+        len--;
+    }
+    line[len] = '\0';
+    return true;
+}
+
+/**
+ * Read exactly len body bytes and hand them to the callback
+ */
+static bool conn_read_body(ha_http_conn_t *conn, size_t len, ha_http_body_cb_t on_body, void *user_data)
+{
+    while (len > 0) {
+        if (!conn_fill(conn)) {
+            return false;
+        }
+        size_t avail = conn->recv_len - conn->recv_pos;
+        size_t n = avail < len ? avail : len;
+        if (on_body) {
+            on_body(conn->recv_buf + conn->recv_pos, n, user_data);
+        }
+        conn->recv_pos += n;
+        len -= n;
+    }
+    return true;
+}
+
+/**
+ * Copy exactly len bytes into buf
+ */
+static void copy_body(const char *data, size_t len, void *user_data)
+{
+    char **dst = (char **)user_data;
+    memcpy(*dst, data, len);
+    *dst += len;
+}
+
+/**
+ * Read exactly len bytes
+ */
+bool ha_http_conn_read(ha_http_conn_t *conn, void *buf, size_t len)
+{
+    char *dst = (char *)buf;
+    return conn_read_body(conn, len, copy_body, &dst);
+}
+
+/**
+ * Read a chunked transfer-encoded body
+ */
+static bool conn_read_chunked(ha_http_conn_t *conn, ha_http_body_cb_t on_body, void *user_data)
+{
+    char line[64];
+
+    for (;;) {
+        if (!ha_http_conn_read_line(conn, line, sizeof(line))) {
+            return false;
+        }
+
+        char *end = NULL;
+        unsigned long chunk = strtoul(line, &end, 16);
+        if (end == line) {
+            return false;
+        }
+
+        if (chunk == 0) {
+            /* Skip trailers up to the terminating empty line */
+            do {
+                if (!ha_http_conn_read_line(conn, line, sizeof(line))) {
+                    return false;
+                }
+            } while (line[0] != '\0');
+            return true;
+        }
+
+        if (!conn_read_body(conn, chunk, on_body, user_data) ||
+            !ha_http_conn_read_line(conn, line, sizeof(line))) {
+            return false;
+        }
+    }
+}
+
+/**
+ * Read a body delimited by connection close
+ */
+static void conn_read_to_eof(ha_http_conn_t *conn, ha_http_body_cb_t on_body, void *user_data)
+{
+    while (conn_fill(conn)) {
+        if (on_body) {
+            on_body(conn->recv_buf + conn->recv_pos, conn->recv_len - conn->recv_pos, user_data);
+        }
+        conn->recv_pos = conn->recv_len;
+    }
+}
+
+/**
+ * Case-insensitive search for a token in a header value
+ */
+static bool header_has_token(const char *value, const char *token)
+{
+    size_t len = strlen(token);
+
+    for (; *value; value++) {
+        if (strncasecmp(value, token, len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Send a request on a keep-alive connection, connecting on demand
+ */
+bool ha_http_send_request(ha_http_conn_t *conn, const char *method, const char *path,
+                          const char *token, const char *body)
+{
+    const ha_http_endpoint_t *ep = conn->endpoint;
+    size_t body_len = body ? strlen(body) : 0;
+    char header[1024];
+
+    int header_len = snprintf(header, sizeof(header),
+                              "%s %s%s HTTP/1.1\r\n"
+                              "Host: %s:%s\r\n"
+                              "%s%s%s"
+                              "Content-Type: application/json\r\n"
+                              "Content-Length: %zu\r\n"
+                              "\r\n",
+                              method, ep->base_path, path,
+                              ep->host, ep->port,
+                              token ? "Authorization: Bearer " : "",
+                              token ? token : "",
+                              token ? "\r\n" : "",
+                              body_len);
+    if (header_len < 0 || (size_t)header_len >= sizeof(header)) {
+        return false;
+    }
+
+    if (conn->fd >= 0) {
+        conn->stats.reused++;
+    } else {
+        if (conn->opens > 0) {
+            conn->stats.reconnects++;
+        }
+        conn->opens++;
+        conn->pipelining = false;  /* Unknown until the server answers */
+        if (!ha_http_conn_open(conn)) {
+            conn->stats.failures++;
+            return false;
+        }
+    }
+    conn->stats.requests++;
+
+    if (!ha_http_conn_send(conn, header, (size_t)header_len) ||
+        (body_len > 0 && !ha_http_conn_send(conn, body, body_len))) {
+        ha_http_conn_close(conn);
+        conn->stats.failures++;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Read the response to the oldest outstanding request
+ */
+int ha_http_read_response(ha_http_conn_t *conn, const char *method,
+                          ha_http_body_cb_t on_body, void *user_data)
+{
+    if (conn->fd < 0) {
+        conn->stats.failures++;
+        return -1;
+    }
+
+    /* Status line */
+    char line[HA_HTTP_MAX_LINE];
+    int major = 0;
+    int minor = 0;
+    int status = 0;
+    conn->responded = false;
+    if (!ha_http_conn_read_line(conn, line, sizeof(line)) ||
+        sscanf(line, "HTTP/%d.%d %d", &major, &minor, &status) != 3) {
+        ha_http_conn_close(conn);
+        conn->stats.failures++;
+        return -1;
+    }
+    conn->responded = true;
+
+    /* HTTP/1.1 defaults to keep-alive, HTTP/1.0 to close */
+    bool keep_alive = major > 1 || (major == 1 && minor >= 1);
+
+    /* Headers */
+    long content_length = -1;
+    bool chunked = false;
+    for (;;) {
+        if (!ha_http_conn_read_line(conn, line, sizeof(line))) {
+            ha_http_conn_close(conn);
+            conn->stats.failures++;
+            return -1;
+        }
+        if (line[0] == '\0') {
+            break;
+        }
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            content_length = strtol(line + 15, NULL, 10);
+        } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+            chunked = strstr(line + 18, "chunked") != NULL;
+        } else if (strncasecmp(line, "Connection:", 11) == 0) {
+            if (header_has_token(line + 11, "close")) {
+                keep_alive = false;
+            } else if (header_has_token(line + 11, "keep-alive")) {
+                keep_alive = true;
+            }
+        }
+    }
+
+    /* Body */
+    bool ok = true;
+    if (strcmp(method, "HEAD") == 0 || status == 204 || status == 304 || status / 100 == 1) {
+        /* No body */
+    } else if (chunked) {
+        ok = conn_read_chunked(conn, on_body, user_data);
+    } else if (content_length >= 0) {
+        ok = conn_read_body(conn, (size_t)content_length, on_body, user_data);
+    } else {
+        conn_read_to_eof(conn, on_body, user_data);
+        keep_alive = false;
+    }
+
+    if (!ok || !keep_alive) {
+        ha_http_conn_close(conn);
+    } else {
+        /* A persistent HTTP/1.1 connection may carry pipelined requests */
+        conn->pipelining = true;
+    }
+
+    if (!ok) {
+        conn->stats.failures++;
+        return -1;
+    }
+    return status;
+}
+
+/**
+ * Record a request round-trip time in the histogram
+ */
+void ha_http_conn_record_rtt(ha_http_conn_t *conn, uint32_t rtt_ms)
+{
+    static const uint32_t bounds[HA_HTTP_RTT_BUCKETS - 1] = HA_HTTP_RTT_BOUNDS_MS;
+    int bucket = 0;
+
+    while (bucket < HA_HTTP_RTT_BUCKETS - 1 && rtt_ms >= bounds[bucket]) {
+        bucket++;
+    }
+    conn->stats.rtt_hist[bucket]++;
+}
+
+/**
+ * Milliseconds from a monotonic clock
+ */
+uint32_t ha_http_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+/**
+ * Perform a blocking HTTP request
+ */
+int ha_http_request(ha_http_conn_t *conn, const char *method, const char *path,
+                    const char *token, const char *body,
+                    ha_http_body_cb_t on_body, void *user_data)
+{
+    /* A kept-alive connection may have been closed by the server while idle;
+     * retry once on a fresh connection in that case */
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = conn->fd >= 0;
+        uint32_t start = ha_http_now_ms();
+
+        if (!ha_http_send_request(conn, method, path, token, body)) {
+            if (reused) {
+                continue;
+            }
+            return -1;
+        }
+
+        /* Once the response started, on_body may hold part of it: the
+         * caller has to reset its sink before trying again */
+        int status = ha_http_read_response(conn, method, on_body, user_data);
+        if (status < 0 && reused && !conn->responded) {
+            continue;
+        }
+        if (status >= 0) {
+            ha_http_conn_record_rtt(conn, ha_http_now_ms() - start);
+        }
+        return status;
+    }
+    return -1;
+}
@@ -0,0 +1,158 @@
+/**
+ * @file ha_http.h
+ * Minimal blocking HTTP/1.1 client used by the Home Assistant I/O worker
+ *
+ * Connections are kept alive between requests and reopened transparently.
+ */
+
+#ifndef HA_HTTP_H
+#define HA_HTTP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Size of the per-connection receive buffer */
+#define HA_HTTP_RECV_BUF_SIZE 4096
+
+/* Parsed server endpoint (only plain http:// is supported) */
+typedef struct {
+    char host[128];
+    char port[8];
+    char base_path[64];  /* Path prefix from the URL, without trailing slash */
+} ha_http_endpoint_t;
+
+/* Round-trip time histogram: bucket i counts RTTs below bound i, the last
+ * bucket everything above the largest bound */
+#define HA_HTTP_RTT_BUCKETS 10
+#define HA_HTTP_RTT_BOUNDS_MS {1, 2, 5, 10, 20, 50, 100, 250, 500}
+
+/* Per-connection statistics */
+typedef struct {
+    uint32_t requests;     /* Requests sent */
+    uint32_t reused;       /* Requests sent on an already open connection */
+    uint32_t reconnects;   /* Connections opened after the first one */
+    uint32_t failures;     /* Requests that failed at the transport level */
+    uint32_t rtt_hist[HA_HTTP_RTT_BUCKETS];
+} ha_http_stats_t;
+
+/* A persistent (keep-alive) connection to the endpoint, reopened on demand */
+typedef struct {
+    const ha_http_endpoint_t *endpoint;
+    int fd;
+    bool pipelining;       /* Server answered with a persistent HTTP/1.1 response */
+    bool responded;        /* Status line of the last response read was received */
+    uint32_t opens;
+    ha_http_stats_t stats;
+    char recv_buf[HA_HTTP_RECV_BUF_SIZE];
+    size_t recv_len;
+    size_t recv_pos;
+} ha_http_conn_t;
+
+/**
+ * Callback receiving response body data as it arrives
+ * @param data Body bytes (not NUL terminated)
+ * @param len Number of bytes
+ * @param user_data User data passed to ha_http_request
+ */
+typedef void (*ha_http_body_cb_t)(const char *data, size_t len, void *user_data);
+
+/**
+ * Parse a URL of the form http://host[:port][/prefix]
+ * @param url URL string
+ * @param endpoint Output endpoint
+ * @return true if successful
+ */
+bool ha_http_parse_url(const char *url, ha_http_endpoint_t *endpoint);
+
+/**
+ * Initialize a connection object (does not connect yet)
+ * @param conn Connection to initialize
+ * @param endpoint Endpoint to connect to, must outlive the connection
+ */
+void ha_http_conn_init(ha_http_conn_t *conn, const ha_http_endpoint_t *endpoint);
+
+/**
+ * Close a connection
+ * @param conn Connection to close
+ */
+void ha_http_conn_close(ha_http_conn_t *conn);
+
+/**
+ * Open the TCP connection (closing any previous one)
+ * @param conn Connection to open
+ * @return true if connected
+ */
+bool ha_http_conn_open(ha_http_conn_t *conn);
+
+/**
+ * Send a whole buffer on an open connection
+ * @return false on a transport error
+ */
+bool ha_http_conn_send(ha_http_conn_t *conn, const char *data, size_t len);
+
+/**
+ * Read one line (CRLF or LF terminated) without the line ending
+ * @return false on EOF, error or a line longer than size - 1
+ */
+bool ha_http_conn_read_line(ha_http_conn_t *conn, char *line, size_t size);
+
+/**
+ * Read exactly len bytes from an open connection
+ * @return false on EOF or error
+ */
+bool ha_http_conn_read(ha_http_conn_t *conn, void *buf, size_t len);
+
+/**
+ * Send a request without waiting for the response. Several requests may be
+ * sent back to back (pipelined) and their responses read in order.
+ * @param conn Connection to use, connected on demand
+ * @param method "GET" or "POST"
+ * @param path Request path relative to the endpoint base path
+ * @param token Bearer token, or NULL
+ * @param body JSON request body, or NULL
+ * @return false on a transport error (the connection is closed)
+ */
+bool ha_http_send_request(ha_http_conn_t *conn, const char *method, const char *path,
+                          const char *token, const char *body);
+
+/**
+ * Read the response to the oldest request sent on the connection
+ * @param conn Connection
+ * @param method Method of that request
+ * @param on_body Callback for the response body, or NULL to discard it
+ * @param user_data User data for on_body
+ * @return HTTP status code, or -1 on a transport error (the connection is closed)
+ */
+int ha_http_read_response(ha_http_conn_t *conn, const char *method,
+                          ha_http_body_cb_t on_body, void *user_data);
+
+/**
+ * Add a round-trip time sample to the connection statistics
+ */
+void ha_http_conn_record_rtt(ha_http_conn_t *conn, uint32_t rtt_ms);
+
+/**
+ * Milliseconds from a monotonic clock
+ */
+uint32_t ha_http_now_ms(void);
+
+/**
+ * Perform a blocking HTTP request, retrying once if a kept-alive
+ * connection turns out to have been closed by the server. A response that
+ * failed after its status line is not retried: on_body may have seen part
+ * of it.
+ * @param conn Connection to use, connected on demand
+ * @param method "GET" or "POST"
+ * @param path Request path relative to the endpoint base path
+ * @param token Bearer token, or NULL
+ * @param body JSON request body, or NULL
+ * @param on_body Callback for the response body, or NULL to discard it
+ * @param user_data User data for on_body
+ * @return HTTP status code, or -1 on a transport error
+ */
+int ha_http_request(ha_http_conn_t *conn, const char *method, const char *path,
+                    const char *token, const char *body,
+                    ha_http_body_cb_t on_body, void *user_data);
+
+#endif /* HA_HTTP_H */
@@ -0,0 +1,298 @@
+/**
+ * @file ha_json.c
+ * Allocation-free pull tokenizer implementation
+ */
+
+#include "ha_json.h"
+#include <string.h>
+
+/**
+ * Skip whitespace and value separators
+ */
+static void skip_separators(ha_json_lexer_t *lex)
+{
+    while (lex->pos < lex->end) {
+        char c = *lex->pos;
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',') {
+            lex->pos++;
+        } else {
+            break;
+        }
+    }
+}
+
+/**
+ * Check a literal keyword such as "true"
+ */
+static bool match_literal(ha_json_lexer_t *lex, const char *word)
+{
+    size_t len = strlen(word);
+    if ((size_t)(lex->end - lex->pos) < len || memcmp(lex->pos, word, len) != 0) {
+        return false;
+    }
+    lex->pos += len;
+    return true;
+}
+
+/**
+ * Initialize a tokenizer over a buffer
+ */
+void ha_json_init(ha_json_lexer_t *lex, const char *json, size_t len)
+{
+    lex->pos = json;
+    lex->end = json + len;
+    lex->depth = 0;
+}
+
+/**
+ * Read the next token
+ */
+ha_json_type_t ha_json_next(ha_json_lexer_t *lex, ha_json_token_t *tok)
+{
+    skip_separators(lex);
+
+    tok->start = lex->pos;
+    tok->len = 0;
+    tok->depth = lex->depth;
+
+    if (lex->pos >= lex->end) {
+        tok->type = HA_JSON_END;
+        return tok->type;
+    }
+
+    char c = *lex->pos;
+    switch (c) {
+    case '{':
+    case '[':
+        lex->pos++;
+        lex->depth++;
+        tok->len = 1;
+        tok->type = c == '{' ? HA_JSON_OBJECT_BEGIN : HA_JSON_ARRAY_BEGIN;
+        return tok->type;
+
+    case '}':
+    case ']':
+        lex->pos++;
+        lex->depth--;
+        tok->depth = lex->depth;
+        tok->len = 1;
+        tok->type = lex->depth < 0 ? HA_JSON_ERROR :
+                    (c == '}' ? HA_JSON_OBJECT_END : HA_JSON_ARRAY_END);
+        return tok->type;
+
+    case '"': {
+        const char *p = ++lex->pos;
+        while (p < lex->end && *p != '"') {
+            p += (*p == '\\') ? 2 : 1;
+        }
+        if (p >= lex->end) {
+            tok->type = HA_JSON_ERROR;
+            return tok->type;
+        }
+        tok->start = lex->pos;
+        tok->len = (size_t)(p - lex->pos);
+        lex->pos = p + 1;
+
+        /* A string followed by ':' is an object member name */
+        while (lex->pos < lex->end && (*lex->pos == ' ' || *lex->pos == '\t' ||
+                                       *lex->pos == '\n' || *lex->pos == '\r')) {
+            lex->pos++;
+        }
+        if (lex->pos < lex->end && *lex->pos == ':') {
+            lex->pos++;
+            tok->type = HA_JSON_KEY;
+        } else {
+            tok->type = HA_JSON_STRING;
+        }
+        return tok->type;
+    }
+
+    case 't':
+        tok->type = match_literal(lex, "true") ? HA_JSON_TRUE : HA_JSON_ERROR;
+        return tok->type;
+
+    case 'f':
+        tok->type = match_literal(lex, "false") ? HA_JSON_FALSE : HA_JSON_ERROR;
+        return tok->type;
+
+    case 'n':
+        tok->type = match_literal(lex, "null") ? HA_JSON_NULL : HA_JSON_ERROR;
+        return tok->type;
+
+    default:
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            const char *p = lex->pos;
+            while (p < lex->end && strchr("+-.eE0123456789", *p)) {
+                p++;
+            }
+            tok->len = (size_t)(p - lex->pos);
+            lex->pos = p;
+            tok->type = HA_JSON_NUMBER;
+            return tok->type;
+        }
+        tok->type = HA_JSON_ERROR;
+        return tok->type;
+    }
+}
+
+/**
+ * Skip the value that follows, including any nested containers
+ */
+bool ha_json_skip_value(ha_json_lexer_t *lex)
+{
+    ha_json_token_t tok;
+    int base = lex->depth;
+
+    do {
+        switch (ha_json_next(lex, &tok)) {
+        case HA_JSON_END:
+        case HA_JSON_ERROR:
+            return false;
+        default:
+            break;
+        }
+    } while (lex->depth > base || tok.type == HA_JSON_KEY);
+
+    return true;
+}
+
+/**
+ * Compare a string or key token with a literal
+ */
+bool ha_json_token_eq(const ha_json_token_t *tok, const char *str)
+{
+    size_t len = strlen(str);
+    return tok->len == len && memcmp(tok->start, str, len) == 0;
+}
+
+/**
+ * Check whether a string token starts with a prefix
+ */
+bool ha_json_token_has_prefix(const ha_json_token_t *tok, const char *prefix)
+{
+    size_t len = strlen(prefix);
+    return tok->len >= len && memcmp(tok->start, prefix, len) == 0;
+}
+
+/**
+ * Parse a number token as an integer
+ */
+long ha_json_token_to_long(const ha_json_token_t *tok)
+{
+    const char *p = tok->start;
+    const char *end = tok->start + tok->len;
+    bool negative = false;
+    long value = 0;
+
+    if (p < end && *p == '-') {
+        negative = true;
+        p++;
+    }
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+
+    return negative ? -value : value;
+}
+
+/**
+ * Parse four hex digits
+ */
+static bool parse_hex4(const char *p, const char *end, uint32_t *out)
+{
+    uint32_t v = 0;
+    if (end - p < 4) {
+        return false;
+    }
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= (uint32_t)(c - '0');
+        else if (c >= 'a' && c <= 'f') v |= (uint32_t)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') v |= (uint32_t)(c - 'A' + 10);
+        else return false;
+    }
+    *out = v;
+    return true;
+}
+
+/**
+ * Copy a string token into a buffer, decoding escapes to UTF-8
+ */
+size_t ha_json_token_copy(const ha_json_token_t *tok, char *buf, size_t size)
+{
+    const char *p = tok->start;
+    const char *end = tok->start + tok->len;
+    size_t n = 0;
+
+    if (size == 0) {
+        return 0;
+    }
+
+    while (p < end) {
+        char out[4];
+        size_t out_len = 1;
+
+        if (*p != '\\') {
+            out[0] = *p++;
+        } else if (p + 1 < end) {
+            char e = p[1];
+            p += 2;
+            switch (e) {
+            case 'b': out[0] = '\b'; break;
+            case 'f': out[0] = '\f'; break;
+            case 'n': out[0] = '\n'; break;
+            case 'r': out[0] = '\r'; break;
+            case 't': out[0] = '\t'; break;
+            case 'u': {
+                uint32_t cp;
+                if (!parse_hex4(p, end, &cp)) {
+                    out[0] = '?';
+                    break;
+                }
+                p += 4;
+                /* Combine surrogate pairs */
+                uint32_t lo;
+                if (cp >= 0xD800 && cp <= 0xDBFF && end - p >= 6 && p[0] == '\\' && p[1] == 'u' &&
+                    parse_hex4(p + 2, end, &lo) && lo >= 0xDC00 && lo <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    p += 6;
+                }
+                if (cp < 0x80) {
+                    out[0] = (char)cp;
+                } else if (cp < 0x800) {
+                    out[0] = (char)(0xC0 | (cp >> 6));
+                    out[1] = (char)(0x80 | (cp & 0x3F));
+                    out_len = 2;
+                } else if (cp < 0x10000) {
+                    out[0] = (char)(0xE0 | (cp >> 12));
+                    out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    out[2] = (char)(0x80 | (cp & 0x3F));
+                    out_len = 3;
+                } else {
+                    out[0] = (char)(0xF0 | (cp >> 18));
+                    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+                    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    out[3] = (char)(0x80 | (cp & 0x3F));
+                    out_len = 4;
+                }
+                break;
+            }
+            default: out[0] = e; break;  /* \" \\ \/ */
+            }
+        } else {
+            break;
+        }
+
+        /* Never split a multi-byte sequence */
+        if (n + out_len >= size) {
+            break;
+        }
+        memcpy(buf + n, out, out_len);
+        n += out_len;
+    }
+
+    buf[n] = '\0';
+    return n;
+}
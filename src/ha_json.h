@@ -0,0 +1,91 @@
+/**
+ * @file ha_json.h
+ * Allocation-free pull tokenizer for Home Assistant JSON payloads
+ */
+
+#ifndef HA_JSON_H
+#define HA_JSON_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Token types */
+typedef enum {
+    HA_JSON_END,          /* End of input */
+    HA_JSON_ERROR,        /* Malformed input */
+    HA_JSON_OBJECT_BEGIN,
+    HA_JSON_OBJECT_END,
+    HA_JSON_ARRAY_BEGIN,
+    HA_JSON_ARRAY_END,
+    HA_JSON_KEY,          /* Object member name */
+    HA_JSON_STRING,
+    HA_JSON_NUMBER,
+    HA_JSON_TRUE,
+    HA_JSON_FALSE,
+    HA_JSON_NULL
+} ha_json_type_t;
+
+/* A token pointing into the input buffer */
+typedef struct {
+    ha_json_type_t type;
+    const char *start;  /* For strings/keys: contents without quotes, still escaped */
+    size_t len;
+    int depth;          /* Nesting depth the token lives at (top level value is 0) */
+} ha_json_token_t;
+
+/* Tokenizer state */
+typedef struct {
+    const char *pos;
+    const char *end;
+    int depth;
+} ha_json_lexer_t;
+
+/**
+ * Initialize a tokenizer over a buffer
+ * @param lex Tokenizer state
+ * @param json Input buffer (need not be NUL terminated)
+ * @param len Input length in bytes
+ */
+void ha_json_init(ha_json_lexer_t *lex, const char *json, size_t len);
+
+/**
+ * Read the next token
+ * @param lex Tokenizer state
+ * @param tok Output token
+ * @return Token type (also stored in tok->type)
+ */
+ha_json_type_t ha_json_next(ha_json_lexer_t *lex, ha_json_token_t *tok);
+
+/**
+ * Skip the value that follows, including any nested containers
+ * @param lex Tokenizer state positioned before a value
+ * @return false on malformed input
+ */
+bool ha_json_skip_value(ha_json_lexer_t *lex);
+
+/**
+ * Compare a string or key token with a NUL terminated literal
+ */
+bool ha_json_token_eq(const ha_json_token_t *tok, const char *str);
+
+/**
+ * Check whether a string token starts with a prefix
+ */
+bool ha_json_token_has_prefix(const ha_json_token_t *tok, const char *prefix);
+
+/**
+ * Parse a number token as an integer (fractional part is truncated)
+ */
+long ha_json_token_to_long(const ha_json_token_t *tok);
+
+/**
+ * Copy a string token into a buffer, decoding escapes to UTF-8
+ * @param tok String or key token
+ * @param buf Output buffer, always NUL terminated
+ * @param size Buffer size
+ * @return Number of bytes written, excluding the terminator
+ */
+size_t ha_json_token_copy(const ha_json_token_t *tok, char *buf, size_t size);
+
+#endif /* HA_JSON_H */
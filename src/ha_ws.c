@@ -0,0 +1,320 @@
+/**
+ * @file ha_ws.c
+ * Minimal WebSocket (RFC 6455) client implementation
+ */
+
+#include "ha_ws.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+/* Frame opcodes */
+#define WS_OP_CONTINUATION 0x0
+#define WS_OP_TEXT         0x1
+#define WS_OP_BINARY       0x2
+#define WS_OP_CLOSE        0x8
+#define WS_OP_PING         0x9
+#define WS_OP_PONG         0xA
+
+/**
+ * Fill a buffer with random bytes (masking keys and the handshake nonce)
+ */
+static void random_bytes(uint8_t *out, size_t len)
+{
+    static uint32_t seed = 0;
+    int fd = open("/dev/urandom", O_RDONLY);
+
+    if (fd >= 0) {
+        ssize_t n = read(fd, out, len);
+        close(fd);
+        if (n == (ssize_t)len) {
+            return;
+        }
+    }
+
+    /* Fall back to a xorshift generator */
+    if (seed == 0) {
+        seed = (uint32_t)time(NULL) ^ ((uint32_t)getpid() << 16) ^ 0x9E3779B9u;
+    }
+    for (size_t i = 0; i < len; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        out[i] = (uint8_t)seed;
+    }
+}
+
+/**
+ * Base64 encode (used for Sec-WebSocket-Key)
+ */
+static void base64_encode(const uint8_t *in, size_t len, char *out)
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t i;
+
+    for (i = 0; i + 2 < len; i += 3) {
+        uint32_t v = ((uint32_t)in[i] << 16) | ((uint32_t)in[i + 1] << 8) | in[i + 2];
+        *out++ = alphabet[(v >> 18) & 0x3F];
+        *out++ = alphabet[(v >> 12) & 0x3F];
+        *out++ = alphabet[(v >> 6) & 0x3F];
+        *out++ = alphabet[v & 0x3F];
+    }
+    if (i < len) {
+        uint32_t v = (uint32_t)in[i] << 16;
+        if (i + 1 < len) {
+            v |= (uint32_t)in[i + 1] << 8;
+        }
+        *out++ = alphabet[(v >> 18) & 0x3F];
+        *out++ = alphabet[(v >> 12) & 0x3F];
+        *out++ = (i + 1 < len) ? alphabet[(v >> 6) & 0x3F] : '=';
+        *out++ = '=';
+    }
+    *out = '\0';
+}
+
+/**
+ * Send one (unfragmented, masked) frame
+ */
+static bool send_frame(ha_ws_conn_t *ws, int opcode, const char *data, size_t len)
+{
+    uint8_t header[14];
+    size_t header_len = 0;
+    uint8_t mask[4];
+
+    header[header_len++] = (uint8_t)(0x80 | opcode);
+    if (len < 126) {
+        header[header_len++] = (uint8_t)(0x80 | len);
+    } else if (len <= 0xFFFF) {
+        header[header_len++] = 0x80 | 126;
+        header[header_len++] = (uint8_t)(len >> 8);
+        header[header_len++] = (uint8_t)len;
+    } else {
+        header[header_len++] = 0x80 | 127;
+        for (int i = 7; i >= 0; i--) {
+            header[header_len++] = (uint8_t)((uint64_t)len >> (i * 8));
+        }
+    }
+
+    /* Client frames must be masked */
+    random_bytes(mask, sizeof(mask));
+    memcpy(header + header_len, mask, sizeof(mask));
+    header_len += sizeof(mask);
+
+    if (!ha_http_conn_send(&ws->http, (const char *)header, header_len)) {
+        return false;
+    }
+
+    char chunk[512];
+    size_t offset = 0;
+    while (offset < len) {
+        size_t n = len - offset < sizeof(chunk) ? len - offset : sizeof(chunk);
+        for (size_t i = 0; i < n; i++) {
+            chunk[i] = (char)(data[offset + i] ^ mask[(offset + i) & 3]);
+        }
+        if (!ha_http_conn_send(&ws->http, chunk, n)) {
+            return false;
+        }
+        offset += n;
+    }
+    return true;
+}
+
+/**
+ * Open the TCP connection and perform the WebSocket upgrade
+ */
+bool ha_ws_connect(ha_ws_conn_t *ws, const ha_http_endpoint_t *endpoint, const char *path)
+{
+    ha_http_conn_init(&ws->http, endpoint);
+    if (!ha_http_conn_open(&ws->http)) {
+        return false;
+    }
+
+    uint8_t nonce[16];
+    char key[32];
+    random_bytes(nonce, sizeof(nonce));
+    base64_encode(nonce, sizeof(nonce), key);
+
+    char request[512];
+    int len = snprintf(request, sizeof(request),
+                       "GET %s%s HTTP/1.1\r\n"
+                       "Host: %s:%s\r\n"
+                       "Upgrade: websocket\r\n"
+                       "Connection: Upgrade\r\n"
+                       "Sec-WebSocket-Key: %s\r\n"
+                       "Sec-WebSocket-Version: 13\r\n"
+                       "\r\n",
+                       endpoint->base_path, path, endpoint->host, endpoint->port, key);
+    if (len < 0 || (size_t)len >= sizeof(request) ||
+        !ha_http_conn_send(&ws->http, request, (size_t)len)) {
+        ha_ws_close(ws);
+        return false;
+    }
+
+    /* Only the status is checked; Sec-WebSocket-Accept is not verified */
+    char line[512];
+    int status = 0;
+    if (!ha_http_conn_read_line(&ws->http, line, sizeof(line)) ||
+        sscanf(line, "HTTP/%*d.%*d %d", &status) != 1 || status != 101) {
+        fprintf(stderr, "WebSocket: upgrade rejected (status %d)\n", status);
+        ha_ws_close(ws);
+        return false;
+    }
+    do {
+        if (!ha_http_conn_read_line(&ws->http, line, sizeof(line))) {
+            ha_ws_close(ws);
+            return false;
+        }
+    } while (line[0] != '\0');
+
+    /* The stream stays open indefinitely; rely on TCP keepalive instead of a timeout */
+    struct timeval tv = {0, 0};
+    int one = 1;
+    setsockopt(ws->http.fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(ws->http.fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+
+    return true;
+}
+
+/**
+ * Send a text message
+ */
+bool ha_ws_send_text(ha_ws_conn_t *ws, const char *text, size_t len)
+{
+    return send_frame(ws, WS_OP_TEXT, text, len);
+}
+
+/**
+ * Read and discard len payload bytes
+ */
+static bool discard(ha_ws_conn_t *ws, uint64_t len)
+{
+    char scratch[256];
+
+    while (len > 0) {
+        size_t n = len < sizeof(scratch) ? (size_t)len : sizeof(scratch);
+        if (!ha_http_conn_read(&ws->http, scratch, n)) {
+            return false;
+        }
+        len -= n;
+    }
+    return true;
+}
+
+/**
+ * Receive the next complete message
+ */
+bool ha_ws_recv(ha_ws_conn_t *ws, char *buf, size_t size, size_t *len)
+{
+    size_t total = 0;
+    bool overflow = false;
+
+    for (;;) {
+        uint8_t header[2];
+        if (!ha_http_conn_read(&ws->http, header, sizeof(header))) {
+            return false;
+        }
+
+        bool fin = (header[0] & 0x80) != 0;
+        int opcode = header[0] & 0x0F;
+        bool masked = (header[1] & 0x80) != 0;
+        uint64_t payload_len = header[1] & 0x7F;
+
+        if (payload_len == 126) {
+            uint8_t ext[2];
+            if (!ha_http_conn_read(&ws->http, ext, sizeof(ext))) {
+                return false;
+            }
+            payload_len = ((uint64_t)ext[0] << 8) | ext[1];
+        } else if (payload_len == 127) {
+            uint8_t ext[8];
+            if (!ha_http_conn_read(&ws->http, ext, sizeof(ext))) {
+                return false;
+            }
+            payload_len = 0;
+            for (int i = 0; i < 8; i++) {
+                payload_len = (payload_len << 8) | ext[i];
+            }
+        }
+
+        uint8_t mask[4] = {0};
+        if (masked && !ha_http_conn_read(&ws->http, mask, sizeof(mask))) {
+            return false;
+        }
+
+        /* Control frames may arrive between fragments */
+        if (opcode >= WS_OP_CLOSE) {
+            char control[125];
+            if (payload_len > sizeof(control) ||
+                !ha_http_conn_read(&ws->http, control, (size_t)payload_len)) {
+                return false;
+            }
+            for (size_t i = 0; masked && i < payload_len; i++) {
+                control[i] ^= (char)mask[i & 3];
+            }
+            if (opcode == WS_OP_CLOSE) {
+                send_frame(ws, WS_OP_CLOSE, control, payload_len >= 2 ? 2 : 0);
+                return false;
+            }
+            if (opcode == WS_OP_PING && !send_frame(ws, WS_OP_PONG, control, (size_t)payload_len)) {
+                return false;
+            }
+            continue;
+        }
+
+        if (opcode != WS_OP_CONTINUATION && opcode != WS_OP_TEXT && opcode != WS_OP_BINARY) {
+            return false;
+        }
+
+        if (overflow || payload_len > size - total) {
+            overflow = true;
+            if (!discard(ws, payload_len)) {
+                return false;
+            }
+        } else {
+            if (!ha_http_conn_read(&ws->http, buf + total, (size_t)payload_len)) {
+                return false;
+            }
+            for (size_t i = 0; masked && i < payload_len; i++) {
+                buf[total + i] ^= (char)mask[i & 3];
+            }
+            total += (size_t)payload_len;
+        }
+
+        if (fin) {
+            if (overflow) {
+                fprintf(stderr, "WebSocket: dropping message larger than %zu bytes\n", size);
+                total = 0;
+                overflow = false;
+                continue;
+            }
+            *len = total;
+            return true;
+        }
+    }
+}
+
+/**
+ * Wake up a thread blocked in ha_ws_recv
+ */
+void ha_ws_interrupt(ha_ws_conn_t *ws)
+{
+    int fd = __atomic_load_n(&ws->http.fd, __ATOMIC_ACQUIRE);
+    if (fd >= 0) {
+        shutdown(fd, SHUT_RDWR);
+    }
+}
+
+/**
+ * Close the connection
+ */
+void ha_ws_close(ha_ws_conn_t *ws)
+{
+    ha_http_conn_close(&ws->http);
+}
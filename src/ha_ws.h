@@ -0,0 +1,54 @@
+/**
+ * @file ha_ws.h
+ * Minimal WebSocket (RFC 6455) client used for Home Assistant state pushes
+ */
+
+#ifndef HA_WS_H
+#define HA_WS_H
+
+#include "ha_http.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* WebSocket connection on top of a plain HTTP connection */
+typedef struct {
+    ha_http_conn_t http;
+} ha_ws_conn_t;
+
+/**
+ * Open the TCP connection and perform the WebSocket upgrade
+ * @param ws Connection object
+ * @param endpoint Endpoint to connect to, must outlive the connection
+ * @param path Request path relative to the endpoint base path
+ * @return true if the server accepted the upgrade
+ */
+bool ha_ws_connect(ha_ws_conn_t *ws, const ha_http_endpoint_t *endpoint, const char *path);
+
+/**
+ * Send a text message
+ * @return false on a transport error
+ */
+bool ha_ws_send_text(ha_ws_conn_t *ws, const char *text, size_t len);
+
+/**
+ * Receive the next complete text or binary message. Pings are answered and
+ * fragmented messages reassembled; messages that do not fit in buf are skipped.
+ * @param ws Connection
+ * @param buf Output buffer
+ * @param size Buffer size
+ * @param len Output message length
+ * @return false when the connection was closed or failed
+ */
+bool ha_ws_recv(ha_ws_conn_t *ws, char *buf, size_t size, size_t *len);
+
+/**
+ * Wake up a thread blocked in ha_ws_recv (safe to call from another thread)
+ */
+void ha_ws_interrupt(ha_ws_conn_t *ws);
+
+/**
+ * Close the connection
+ */
+void ha_ws_close(ha_ws_conn_t *ws);
+
+#endif /* HA_WS_H */
@@ -0,0 +1,192 @@
+/**
+ * @file headless_display.c
+ * Offscreen display and scripted pointer implementation
+ */
+
+#include "headless_display.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static lv_display_t *display = NULL;
+static uint8_t *framebuffer = NULL;
+static size_t framebuffer_size = 0;
+static uint8_t *band_buffers[2] = {NULL, NULL};  /* Partial mode draw buffers */
+static lv_display_render_mode_t render_mode = LV_DISPLAY_RENDER_MODE_DIRECT;
+static headless_display_stats_t stats;
+static uint32_t pending_pixels = 0;
+
+/* Scripted pointer state */
+static lv_point_t pointer_pos = {0, 0};
+static bool pointer_pressed = false;
+
+/**
+ * Flush callback: in partial mode copy the band into the framebuffer (the
+ * transfer a panel driver would do), otherwise it is already there
+ */
+static void headless_flush_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map)
+{
+    if (render_mode == LV_DISPLAY_RENDER_MODE_PARTIAL) {
+        lv_color_format_t cf = lv_display_get_color_format(disp);
+        uint32_t px_size = lv_color_format_get_size(cf);
+        uint32_t fb_stride = lv_draw_buf_width_to_stride((uint32_t)lv_display_get_horizontal_resolution(disp), cf);
+        uint32_t band_stride = lv_draw_buf_width_to_stride((uint32_t)lv_area_get_width(area), cf);
+        size_t row_bytes = (size_t)lv_area_get_width(area) * px_size;
+
+        for (int32_t y = area->y1; y <= area->y2; y++) {
+            memcpy(framebuffer + (size_t)y * fb_stride + (size_t)area->x1 * px_size,
+                   px_map + (size_t)(y - area->y1) * band_stride, row_bytes);
+        }
+    }
+
+    stats.flushes++;
+    pending_pixels += (uint32_t)lv_area_get_size(area);
+
+    if (lv_display_flush_is_last(disp)) {
+        stats.frames++;
+        stats.pixels += pending_pixels;
+        stats.frame_pixels = pending_pixels;
+        pending_pixels = 0;
+    }
+
+    lv_display_flush_ready(disp);
+}
+
+/**
+ * Create an offscreen display
+ */
+lv_display_t *headless_display_create(int32_t hor_res, int32_t ver_res)
+{
+    display_config_t config = {.mode = LV_DISPLAY_RENDER_MODE_DIRECT};
+    return headless_display_create_with_config(hor_res, ver_res, &config);
+}
+
+/**
+ * Create an offscreen display rendering in the given mode
+ */
+lv_display_t *headless_display_create_with_config(int32_t hor_res, int32_t ver_res,
+                                                  const display_config_t *config)
+{
+    if (display) {
+        return display;
+    }
+
+    display = lv_display_create(hor_res, ver_res);
+    if (!display) {
+        return NULL;
+    }
+
+    framebuffer_size = lv_draw_buf_width_to_stride((uint32_t)hor_res, lv_display_get_color_format(display)) *
+                       (size_t)ver_res;
+    framebuffer = malloc(framebuffer_size);
+    if (!framebuffer) {
+        printf("Error: could not allocate a %zu byte framebuffer\n", framebuffer_size);
+        lv_display_delete(display);
+        display = NULL;
+        return NULL;
+    }
+    memset(framebuffer, 0, framebuffer_size);
+
+    render_mode = config->mode;
+    if (config->mode == LV_DISPLAY_RENDER_MODE_PARTIAL) {
+        /* LVGL renders bands, the flush callback assembles the framebuffer */
+        uint32_t band_size = display_config_buffer_size(config, display);
+        for (uint32_t i = 0; i < config->buffers && i < 2; i++) {
+            band_buffers[i] = malloc(band_size);
+            if (!band_buffers[i]) {
+                printf("Error: could not allocate a %u byte draw buffer\n", (unsigned)band_size);
+                headless_display_delete();
+                return NULL;
+            }
+        }
+        lv_display_set_buffers(display, band_buffers[0], band_buffers[1], band_size,
+                               LV_DISPLAY_RENDER_MODE_PARTIAL);
+    } else {
+        lv_display_set_buffers(display, framebuffer, NULL, (uint32_t)framebuffer_size, config->mode);
+    }
+    lv_display_set_flush_cb(display, headless_flush_cb);
+
+    memset(&stats, 0, sizeof(stats));
+    pending_pixels = 0;
+    return display;
+}
+
+/**
+ * Delete the offscreen display
+ */
+void headless_display_delete(void)
+{
+    if (display) {
+        lv_display_delete(display);
+        display = NULL;
+    }
+    free(framebuffer);
+    framebuffer = NULL;
+    framebuffer_size = 0;
+    for (int i = 0; i < 2; i++) {
+        free(band_buffers[i]);
+        band_buffers[i] = NULL;
+    }
+}
+
+/**
+ * Get the framebuffer contents
+ */
+const uint8_t *headless_display_get_framebuffer(size_t *size)
+{
+    if (size) {
+        *size = framebuffer_size;
+    }
+    return framebuffer;
+}
+
+/**
+ * Get the rendering statistics
+ */
+void headless_display_get_stats(headless_display_stats_t *out)
+{
+    *out = stats;
+}
+
+/**
+ * Reset the rendering statistics
+ */
+void headless_display_reset_stats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+/**
+ * Pointer read callback
+ */
+static void headless_pointer_read_cb(lv_indev_t *indev, lv_indev_data_t *data)
+{
+    (void)indev;
+
+    data->point = pointer_pos;
+    data->state = pointer_pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+}
+
+/**
+ * Create the scripted pointer
+ */
+lv_indev_t *headless_pointer_create(void)
+{
+    lv_indev_t *indev = lv_indev_create();
+    lv_indev_set_type(indev, LV_INDEV_TYPE_POINTER);
+    lv_indev_set_read_cb(indev, headless_pointer_read_cb);
+    if (display) {
+        lv_indev_set_display(indev, display);
+    }
+    return indev;
+}
+
+/**
+ * Set the scripted pointer state
+ */
+void headless_pointer_set(int32_t x, int32_t y, bool pressed)
+{
+    pointer_pos.x = x;
+    pointer_pos.y = y;
+    pointer_pressed = pressed;
+}
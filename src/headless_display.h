@@ -0,0 +1,83 @@
+/**
+ * @file headless_display.h
+ * Offscreen display and scripted pointer for running the UI without a window
+ *
+ * By default the display renders into a full-size memory framebuffer (direct
+ * mode), so only invalidated areas are redrawn, exactly as on a real panel.
+ * Partial and full render modes can be selected to compare their cost.
+ * Flushes are counted to report how much was rendered.
+ */
+
+#ifndef HEADLESS_DISPLAY_H
+#define HEADLESS_DISPLAY_H
+
+#include "lvgl/lvgl.h"
+#include "display_config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Rendering statistics */
+typedef struct {
+    uint32_t frames;        /* Completed frames (last flush of a refresh) */
+    uint32_t flushes;       /* Flushed areas */
+    uint64_t pixels;        /* Pixels rendered over all frames */
+    uint32_t frame_pixels;  /* Pixels rendered in the last completed frame */
+} headless_display_stats_t;
+
+/**
+ * Create an offscreen display with a memory framebuffer
+ * @param hor_res Horizontal resolution
+ * @param ver_res Vertical resolution
+ * @return Display, or NULL if the framebuffer could not be allocated
+ */
+lv_display_t *headless_display_create(int32_t hor_res, int32_t ver_res);
+
+/**
+ * Create an offscreen display rendering in the given mode. Partial mode
+ * renders into band buffers and copies each band into the framebuffer.
+ * @param hor_res Horizontal resolution
+ * @param ver_res Vertical resolution
+ * @param config Render mode and buffer sizes
+ * @return Display, or NULL if a buffer could not be allocated
+ */
+lv_display_t *headless_display_create_with_config(int32_t hor_res, int32_t ver_res,
+                                                  const display_config_t *config);
+
+/**
+ * Free the framebuffer and delete the display
+ */
+void headless_display_delete(void);
+
+/**
+ * Get the framebuffer contents
+ * @param size Output size of the framebuffer in bytes, or NULL
+ * @return Framebuffer, or NULL if no display was created
+ */
+const uint8_t *headless_display_get_framebuffer(size_t *size);
+
+/**
+ * Get the rendering statistics
+ * @param stats Output statistics
+ */
+void headless_display_get_stats(headless_display_stats_t *stats);
+
+/**
+ * Reset the rendering statistics
+ */
+void headless_display_reset_stats(void);
+
+/**
+ * Create a pointer input device driven by headless_pointer_set
+ * @return Input device
+ */
+lv_indev_t *headless_pointer_create(void);
+
+/**
+ * Set the position and button state reported by the scripted pointer
+ * @param x X coordinate
+ * @param y Y coordinate
+ * @param pressed true while the button is held
+ */
+void headless_pointer_set(int32_t x, int32_t y, bool pressed);
+
+#endif /* HEADLESS_DISPLAY_H */
@@ -0,0 +1,25 @@
+/**
+ * @file kelvin_lut.c
+ * Kelvin to RGB lookup implementation
+ */
+
+#include "kelvin_lut.h"
+#include "kelvin_lut_table.h"
+
+/**
+ * Get the RGB color of white light at a color temperature
+ */
+void kelvin_lut_rgb(uint32_t kelvin, uint8_t *red, uint8_t *green, uint8_t *blue)
+{
+    if (kelvin < KELVIN_LUT_MIN) {
+        kelvin = KELVIN_LUT_MIN;
+    } else if (kelvin > KELVIN_LUT_MAX) {
+        kelvin = KELVIN_LUT_MAX;
+    }
+
+    /* Nearest entry */
+    const uint8_t *rgb = kelvin_lut_table[(kelvin - KELVIN_LUT_MIN + KELVIN_LUT_STEP / 2) / KELVIN_LUT_STEP];
+    *red = rgb[0];
+    *green = rgb[1];
+    *blue = rgb[2];
+}
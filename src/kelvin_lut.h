@@ -0,0 +1,33 @@
+/**
+ * @file kelvin_lut.h
+ * Kelvin to RGB lookup for color temperature previews
+ *
+ * The table is generated ahead of time by tools/kelvin_lut_gen.c, so a
+ * lookup is an index computation and a load: no floating point and no libm
+ * on the panel.
+ */
+
+#ifndef KELVIN_LUT_H
+#define KELVIN_LUT_H
+
+#include <stdint.h>
+
+/* Covered range, the range of the color temperature slider */
+#define KELVIN_LUT_MIN 2000
+#define KELVIN_LUT_MAX 6500
+
+/* Kelvin between table entries */
+#define KELVIN_LUT_STEP 10
+
+#define KELVIN_LUT_SIZE ((KELVIN_LUT_MAX - KELVIN_LUT_MIN) / KELVIN_LUT_STEP + 1)
+
+/**
+ * Get the RGB color of white light at a color temperature
+ * @param kelvin Color temperature, clamped to KELVIN_LUT_MIN..KELVIN_LUT_MAX
+ * @param red Output red component (0-255)
+ * @param green Output green component (0-255)
+ * @param blue Output blue component (0-255)
+ */
+void kelvin_lut_rgb(uint32_t kelvin, uint8_t *red, uint8_t *green, uint8_t *blue);
+
+#endif /* KELVIN_LUT_H */
@@ -0,0 +1,459 @@
+/**
+ * @file kelvin_lut_table.h
+ * Kelvin to RGB table, generated by tools/kelvin_lut_gen.c - do not edit
+ */
+
+/* 2000 K to 6500 K in 10 K steps */
+static const uint8_t kelvin_lut_table[KELVIN_LUT_SIZE][3] = {
+    {255, 137,  14},  /* 2000 K */
+    {255, 137,  15},  /* 2010 K */
+    {255, 138,  17},  /* 2020 K */
+    {255, 138,  18},  /* 2030 K */
+    {255, 139,  19},  /* 2040 K */
+    {255, 139,  21},  /* 2050 K */
+    {255, 140,  22},  /* 2060 K */
+    {255, 140,  23},  /* 2070 K */
+    {255, 141,  25},  /* 2080 K */
+    {255, 141,  26},  /* 2090 K */
+    {255, 142,  27},  /* 2100 K */
+    {255, 142,  28},  /* 2110 K */
+    {255, 143,  30},  /* 2120 K */
+    {255, 143,  31},  /* 2130 K */
+    {255, 144,  32},  /* 2140 K */
+    {255, 144,  33},  /* 2150 K */
+    {255, 145,  34},  /* 2160 K */
+    {255, 145,  36},  /* 2170 K */
+    {255, 145,  37},  /* 2180 K */
+    {255, 146,  38},  /* 2190 K */
+    {255, 146,  39},  /* 2200 K */
+    {255, 147,  40},  /* 2210 K */
+    {255, 147,  41},  /* 2220 K */
+    {255, 148,  43},  /* 2230 K */
+    {255, 148,  44},  /* 2240 K */
+    {255, 149,  45},  /* 2250 K */
+    {255, 149,  46},  /* 2260 K */
+    {255, 149,  47},  /* 2270 K */
+    {255, 150,  48},  /* 2280 K */
+    {255, 150,  49},  /* 2290 K */
+    {255, 151,  50},  /* 2300 K */
+    {255, 151,  51},  /* 2310 K */
+    {255, 152,  52},  /* 2320 K */
+    {255, 152,  53},  /* 2330 K */
+    {255, 152,  54},  /* 2340 K */
+    {255, 153,  55},  /* 2350 K */
+    {255, 153,  56},  /* 2360 K */
+    {255, 154,  58},  /* 2370 K */
+    {255, 154,  59},  /* 2380 K */
+    {255, 155,  60},  /* 2390 K */
+    {255, 155,  61},  /* 2400 K */
+    {255, 155,  61},  /* 2410 K */
+    {255, 156,  62},  /* 2420 K */
+    {255, 156,  63},  /* 2430 K */
+    {255, 157,  64},  /* 2440 K */
+    {255, 157,  65},  /* 2450 K */
+    {255, 157,  66},  /* 2460 K */
+    {255, 158,  67},  /* 2470 K */
+    {255, 158,  68},  /* 2480 K */
+    {255, 159,  69},  /* 2490 K */
+    {255, 159,  70},  /* 2500 K */
+    {255, 159,  71},  /* 2510 K */
+    {255, 160,  72},  /* 2520 K */
+    {255, 160,  73},  /* 2530 K */
+    {255, 161,  74},  /* 2540 K */
+    {255, 161,  75},  /* 2550 K */
+    {255, 161,  76},  /* 2560 K */
+    {255, 162,  76},  /* 2570 K */
+    {255, 162,  77},  /* 2580 K */
+    {255, 163,  78},  /* 2590 K */
+    {255, 163,  79},  /* 2600 K */
+    {255, 163,  80},  /* 2610 K */
+    {255, 164,  81},  /* 2620 K */
+    {255, 164,  82},  /* 2630 K */
+    {255, 164,  82},  /* 2640 K */
+    {255, 165,  83},  /* 2650 K */
+    {255, 165,  84},  /* 2660 K */
+    {255, 166,  85},  /* 2670 K */
+    {255, 166,  86},  /* 2680 K */
+    {255, 166,  87},  /* 2690 K */
+    {255, 167,  87},  /* 2700 K */
+    {255, 167,  88},  /* 2710 K */
+    {255, 167,  89},  /* 2720 K */
+    {255, 168,  90},  /* 2730 K */
+    {255, 168,  91},  /* 2740 K */
+    {255, 169,  91},  /* 2750 K */
+    {255, 169,  92},  /* 2760 K */
+    {255, 169,  93},  /* 2770 K */
+    {255, 170,  94},  /* 2780 K */
+    {255, 170,  95},  /* 2790 K */
+    {255, 170,  95},  /* 2800 K */
+    {255, 171,  96},  /* 2810 K */
+    {255, 171,  97},  /* 2820 K */
+    {255, 171,  98},  /* 2830 K */
+    {255, 172,  98},  /* 2840 K */
+    {255, 172,  99},  /* 2850 K */
+    {255, 172, 100},  /* 2860 K */
+    {255, 173, 101},  /* 2870 K */
+    {255, 173, 101},  /* 2880 K */
+    {255, 173, 102},  /* 2890 K */
+    {255, 174, 103},  /* 2900 K */
+    {255, 174, 104},  /* 2910 K */
+    {255, 175, 104},  /* 2920 K */
+    {255, 175, 105},  /* 2930 K */
+    {255, 175, 106},  /* 2940 K */
+    {255, 176, 106},  /* 2950 K */
+    {255, 176, 107},  /* 2960 K */
+    {255, 176, 108},  /* 2970 K */
+    {255, 177, 109},  /* 2980 K */
+    {255, 177, 109},  /* 2990 K */
+    {255, 177, 110},  /* 3000 K */
+    {255, 178, 111},  /* 3010 K */
+    {255, 178, 111},  /* 3020 K */
+    {255, 178, 112},  /* 3030 K */
+    {255, 179, 113},  /* 3040 K */
+    {255, 179, 113},  /* 3050 K */
+    {255, 179, 114},  /* 3060 K */
+    {255, 179, 115},  /* 3070 K */
+    {255, 180, 115},  /* 3080 K */
+    {255, 180, 116},  /* 3090 K */
+    {255, 180, 117},  /* 3100 K */
+    {255, 181, 117},  /* 3110 K */
+    {255, 181, 118},  /* 3120 K */
+    {255, 181, 119},  /* 3130 K */
+    {255, 182, 119},  /* 3140 K */
+    {255, 182, 120},  /* 3150 K */
+    {255, 182, 121},  /* 3160 K */
+    {255, 183, 121},  /* 3170 K */
+    {255, 183, 122},  /* 3180 K */
+    {255, 183, 122},  /* 3190 K */
+    {255, 184, 123},  /* 3200 K */
+    {255, 184, 124},  /* 3210 K */
+    {255, 184, 124},  /* 3220 K */
+    {255, 185, 125},  /* 3230 K */
+    {255, 185, 126},  /* 3240 K */
+    {255, 185, 126},  /* 3250 K */
+    {255, 185, 127},  /* 3260 K */
+    {255, 186, 127},  /* 3270 K */
+    {255, 186, 128},  /* 3280 K */
+    {255, 186, 129},  /* 3290 K */
+    {255, 187, 129},  /* 3300 K */
+    {255, 187, 130},  /* 3310 K */
+    {255, 187, 130},  /* 3320 K */
+    {255, 188, 131},  /* 3330 K */
+    {255, 188, 132},  /* 3340 K */
+    {255, 188, 132},  /* 3350 K */
+    {255, 188, 133},  /* 3360 K */
+    {255, 189, 133},  /* 3370 K */
+    {255, 189, 134},  /* 3380 K */
+    {255, 189, 135},  /* 3390 K */
+    {255, 190, 135},  /* 3400 K */
+    {255, 190, 136},  /* 3410 K */
+    {255, 190, 136},  /* 3420 K */
+    {255, 191, 137},  /* 3430 K */
+    {255, 191, 137},  /* 3440 K */
+    {255, 191, 138},  /* 3450 K */
+    {255, 191, 139},  /* 3460 K */
+    {255, 192, 139},  /* 3470 K */
+    {255, 192, 140},  /* 3480 K */
+    {255, 192, 140},  /* 3490 K */
+    {255, 193, 141},  /* 3500 K */
+    {255, 193, 141},  /* 3510 K */
+    {255, 193, 142},  /* 3520 K */
+    {255, 193, 142},  /* 3530 K */
+    {255, 194, 143},  /* 3540 K */
+    {255, 194, 144},  /* 3550 K */
+    {255, 194, 144},  /* 3560 K */
+    {255, 195, 145},  /* 3570 K */
+    {255, 195, 145},  /* 3580 K */
+    {255, 195, 146},  /* 3590 K */
+    {255, 195, 146},  /* 3600 K */
+    {255, 196, 147},  /* 3610 K */
+    {255, 196, 147},  /* 3620 K */
+    {255, 196, 148},  /* 3630 K */
+    {255, 196, 148},  /* 3640 K */
+    {255, 197, 149},  /* 3650 K */
+    {255, 197, 149},  /* 3660 K */
+    {255, 197, 150},  /* 3670 K */
+    {255, 198, 150},  /* 3680 K */
+    {255, 198, 151},  /* 3690 K */
+    {255, 198, 151},  /* 3700 K */
+    {255, 198, 152},  /* 3710 K */
+    {255, 199, 153},  /* 3720 K */
+    {255, 199, 153},  /* 3730 K */
+    {255, 199, 154},  /* 3740 K */
+    {255, 199, 154},  /* 3750 K */
+    {255, 200, 155},  /* 3760 K */
+    {255, 200, 155},  /* 3770 K */
+    {255, 200, 156},  /* 3780 K */
+    {255, 200, 156},  /* 3790 K */
+    {255, 201, 157},  /* 3800 K */
+    {255, 201, 157},  /* 3810 K */
+    {255, 201, 158},  /* 3820 K */
+    {255, 201, 158},  /* 3830 K */
+    {255, 202, 158},  /* 3840 K */
+    {255, 202, 159},  /* 3850 K */
+    {255, 202, 159},  /* 3860 K */
+    {255, 203, 160},  /* 3870 K */
+    {255, 203, 160},  /* 3880 K */
+    {255, 203, 161},  /* 3890 K */
+    {255, 203, 161},  /* 3900 K */
+    {255, 204, 162},  /* 3910 K */
+    {255, 204, 162},  /* 3920 K */
+    {255, 204, 163},  /* 3930 K */
+    {255, 204, 163},  /* 3940 K */
+    {255, 205, 164},  /* 3950 K */
+    {255, 205, 164},  /* 3960 K */
+    {255, 205, 165},  /* 3970 K */
+    {255, 205, 165},  /* 3980 K */
+    {255, 206, 166},  /* 3990 K */
+    {255, 206, 166},  /* 4000 K */
+    {255, 206, 167},  /* 4010 K */
+    {255, 206, 167},  /* 4020 K */
+    {255, 207, 167},  /* 4030 K */
+    {255, 207, 168},  /* 4040 K */
+    {255, 207, 168},  /* 4050 K */
+    {255, 207, 169},  /* 4060 K */
+    {255, 208, 169},  /* 4070 K */
+    {255, 208, 170},  /* 4080 K */
+    {255, 208, 170},  /* 4090 K */
+    {255, 208, 171},  /* 4100 K */
+    {255, 209, 171},  /* 4110 K */
+    {255, 209, 172},  /* 4120 K */
+    {255, 209, 172},  /* 4130 K */
+    {255, 209, 172},  /* 4140 K */
+    {255, 209, 173},  /* 4150 K */
+    {255, 210, 173},  /* 4160 K */
+    {255, 210, 174},  /* 4170 K */
+    {255, 210, 174},  /* 4180 K */
+    {255, 210, 175},  /* 4190 K */
+    {255, 211, 175},  /* 4200 K */
+    {255, 211, 175},  /* 4210 K */
+    {255, 211, 176},  /* 4220 K */
+    {255, 211, 176},  /* 4230 K */
+    {255, 212, 177},  /* 4240 K */
+    {255, 212, 177},  /* 4250 K */
+    {255, 212, 178},  /* 4260 K */
+    {255, 212, 178},  /* 4270 K */
+    {255, 213, 178},  /* 4280 K */
+    {255, 213, 179},  /* 4290 K */
+    {255, 213, 179},  /* 4300 K */
+    {255, 213, 180},  /* 4310 K */
+    {255, 213, 180},  /* 4320 K */
+    {255, 214, 181},  /* 4330 K */
+    {255, 214, 181},  /* 4340 K */
+    {255, 214, 181},  /* 4350 K */
+    {255, 214, 182},  /* 4360 K */
+    {255, 215, 182},  /* 4370 K */
+    {255, 215, 183},  /* 4380 K */
+    {255, 215, 183},  /* 4390 K */
+    {255, 215, 183},  /* 4400 K */
+    {255, 216, 184},  /* 4410 K */
+    {255, 216, 184},  /* 4420 K */
+    {255, 216, 185},  /* 4430 K */
+    {255, 216, 185},  /* 4440 K */
+    {255, 216, 185},  /* 4450 K */
+    {255, 217, 186},  /* 4460 K */
+    {255, 217, 186},  /* 4470 K */
+    {255, 217, 187},  /* 4480 K */
+    {255, 217, 187},  /* 4490 K */
+    {255, 218, 187},  /* 4500 K */
+    {255, 218, 188},  /* 4510 K */
+    {255, 218, 188},  /* 4520 K */
+    {255, 218, 189},  /* 4530 K */
+    {255, 218, 189},  /* 4540 K */
+    {255, 219, 189},  /* 4550 K */
+    {255, 219, 190},  /* 4560 K */
+    {255, 219, 190},  /* 4570 K */
+    {255, 219, 191},  /* 4580 K */
+    {255, 220, 191},  /* 4590 K */
+    {255, 220, 191},  /* 4600 K */
+    {255, 220, 192},  /* 4610 K */
+    {255, 220, 192},  /* 4620 K */
+    {255, 220, 192},  /* 4630 K */
+    {255, 221, 193},  /* 4640 K */
+    {255, 221, 193},  /* 4650 K */
+    {255, 221, 194},  /* 4660 K */
+    {255, 221, 194},  /* 4670 K */
+    {255, 221, 194},  /* 4680 K */
+    {255, 222, 195},  /* 4690 K */
+    {255, 222, 195},  /* 4700 K */
+    {255, 222, 196},  /* 4710 K */
+    {255, 222, 196},  /* 4720 K */
+    {255, 222, 196},  /* 4730 K */
+    {255, 223, 197},  /* 4740 K */
+    {255, 223, 197},  /* 4750 K */
+    {255, 223, 197},  /* 4760 K */
+    {255, 223, 198},  /* 4770 K */
+    {255, 224, 198},  /* 4780 K */
+    {255, 224, 198},  /* 4790 K */
+    {255, 224, 199},  /* 4800 K */
+    {255, 224, 199},  /* 4810 K */
+    {255, 224, 200},  /* 4820 K */
+    {255, 225, 200},  /* 4830 K */
+    {255, 225, 200},  /* 4840 K */
+    {255, 225, 201},  /* 4850 K */
+    {255, 225, 201},  /* 4860 K */
+    {255, 225, 201},  /* 4870 K */
+    {255, 226, 202},  /* 4880 K */
+    {255, 226, 202},  /* 4890 K */
+    {255, 226, 202},  /* 4900 K */
+    {255, 226, 203},  /* 4910 K */
+    {255, 226, 203},  /* 4920 K */
+    {255, 227, 203},  /* 4930 K */
+    {255, 227, 204},  /* 4940 K */
+    {255, 227, 204},  /* 4950 K */
+    {255, 227, 205},  /* 4960 K */
+    {255, 227, 205},  /* 4970 K */
+    {255, 228, 205},  /* 4980 K */
+    {255, 228, 206},  /* 4990 K */
+    {255, 228, 206},  /* 5000 K */
+    {255, 228, 206},  /* 5010 K */
+    {255, 228, 207},  /* 5020 K */
+    {255, 229, 207},  /* 5030 K */
+    {255, 229, 207},  /* 5040 K */
+    {255, 229, 208},  /* 5050 K */
+    {255, 229, 208},  /* 5060 K */
+    {255, 229, 208},  /* 5070 K */
+    {255, 230, 209},  /* 5080 K */
+    {255, 230, 209},  /* 5090 K */
+    {255, 230, 209},  /* 5100 K */
+    {255, 230, 210},  /* 5110 K */
+    {255, 230, 210},  /* 5120 K */
+    {255, 231, 210},  /* 5130 K */
+    {255, 231, 211},  /* 5140 K */
+    {255, 231, 211},  /* 5150 K */
+    {255, 231, 211},  /* 5160 K */
+    {255, 231, 212},  /* 5170 K */
+    {255, 232, 212},  /* 5180 K */
+    {255, 232, 212},  /* 5190 K */
+    {255, 232, 213},  /* 5200 K */
+    {255, 232, 213},  /* 5210 K */
+    {255, 232, 213},  /* 5220 K */
+    {255, 232, 214},  /* 5230 K */
+    {255, 233, 214},  /* 5240 K */
+    {255, 233, 214},  /* 5250 K */
+    {255, 233, 215},  /* 5260 K */
+    {255, 233, 215},  /* 5270 K */
+    {255, 233, 215},  /* 5280 K */
+    {255, 234, 216},  /* 5290 K */
+    {255, 234, 216},  /* 5300 K */
+    {255, 234, 216},  /* 5310 K */
+    {255, 234, 217},  /* 5320 K */
+    {255, 234, 217},  /* 5330 K */
+    {255, 235, 217},  /* 5340 K */
+    {255, 235, 218},  /* 5350 K */
+    {255, 235, 218},  /* 5360 K */
+    {255, 235, 218},  /* 5370 K */
+    {255, 235, 219},  /* 5380 K */
+    {255, 235, 219},  /* 5390 K */
+    {255, 236, 219},  /* 5400 K */
+    {255, 236, 219},  /* 5410 K */
+    {255, 236, 220},  /* 5420 K */
+    {255, 236, 220},  /* 5430 K */
+    {255, 236, 220},  /* 5440 K */
+    {255, 237, 221},  /* 5450 K */
+    {255, 237, 221},  /* 5460 K */
+    {255, 237, 221},  /* 5470 K */
+    {255, 237, 222},  /* 5480 K */
+    {255, 237, 222},  /* 5490 K */
+    {255, 237, 222},  /* 5500 K */
+    {255, 238, 223},  /* 5510 K */
+    {255, 238, 223},  /* 5520 K */
+    {255, 238, 223},  /* 5530 K */
+    {255, 238, 223},  /* 5540 K */
+    {255, 238, 224},  /* 5550 K */
+    {255, 239, 224},  /* 5560 K */
+    {255, 239, 224},  /* 5570 K */
+    {255, 239, 225},  /* 5580 K */
+    {255, 239, 225},  /* 5590 K */
+    {255, 239, 225},  /* 5600 K */
+    {255, 239, 226},  /* 5610 K */
+    {255, 240, 226},  /* 5620 K */
+    {255, 240, 226},  /* 5630 K */
+    {255, 240, 226},  /* 5640 K */
+    {255, 240, 227},  /* 5650 K */
+    {255, 240, 227},  /* 5660 K */
+    {255, 241, 227},  /* 5670 K */
+    {255, 241, 228},  /* 5680 K */
+    {255, 241, 228},  /* 5690 K */
+    {255, 241, 228},  /* 5700 K */
+    {255, 241, 229},  /* 5710 K */
+    {255, 241, 229},  /* 5720 K */
+    {255, 242, 229},  /* 5730 K */
+    {255, 242, 229},  /* 5740 K */
+    {255, 242, 230},  /* 5750 K */
+    {255, 242, 230},  /* 5760 K */
+    {255, 242, 230},  /* 5770 K */
+    {255, 242, 231},  /* 5780 K */
+    {255, 243, 231},  /* 5790 K */
+    {255, 243, 231},  /* 5800 K */
+    {255, 243, 231},  /* 5810 K */
+    {255, 243, 232},  /* 5820 K */
+    {255, 243, 232},  /* 5830 K */
+    {255, 243, 232},  /* 5840 K */
+    {255, 244, 233},  /* 5850 K */
+    {255, 244, 233},  /* 5860 K */
+    {255, 244, 233},  /* 5870 K */
+    {255, 244, 233},  /* 5880 K */
+    {255, 244, 234},  /* 5890 K */
+    {255, 244, 234},  /* 5900 K */
+    {255, 245, 234},  /* 5910 K */
+    {255, 245, 235},  /* 5920 K */
+    {255, 245, 235},  /* 5930 K */
+    {255, 245, 235},  /* 5940 K */
+    {255, 245, 235},  /* 5950 K */
+    {255, 245, 236},  /* 5960 K */
+    {255, 246, 236},  /* 5970 K */
+    {255, 246, 236},  /* 5980 K */
+    {255, 246, 237},  /* 5990 K */
+    {255, 246, 237},  /* 6000 K */
+    {255, 246, 237},  /* 6010 K */
+    {255, 246, 237},  /* 6020 K */
+    {255, 247, 238},  /* 6030 K */
+    {255, 247, 238},  /* 6040 K */
+    {255, 247, 238},  /* 6050 K */
+    {255, 247, 238},  /* 6060 K */
+    {255, 247, 239},  /* 6070 K */
+    {255, 247, 239},  /* 6080 K */
+    {255, 248, 239},  /* 6090 K */
+    {255, 248, 240},  /* 6100 K */
+    {255, 248, 240},  /* 6110 K */
+    {255, 248, 240},  /* 6120 K */
+    {255, 248, 240},  /* 6130 K */
+    {255, 248, 241},  /* 6140 K */
+    {255, 249, 241},  /* 6150 K */
+    {255, 249, 241},  /* 6160 K */
+    {255, 249, 241},  /* 6170 K */
+    {255, 249, 242},  /* 6180 K */
+    {255, 249, 242},  /* 6190 K */
+    {255, 249, 242},  /* 6200 K */
+    {255, 250, 243},  /* 6210 K */
+    {255, 250, 243},  /* 6220 K */
+    {255, 250, 243},  /* 6230 K */
+    {255, 250, 243},  /* 6240 K */
+    {255, 250, 244},  /* 6250 K */
+    {255, 250, 244},  /* 6260 K */
+    {255, 251, 244},  /* 6270 K */
+    {255, 251, 244},  /* 6280 K */
+    {255, 251, 245},  /* 6290 K */
+    {255, 251, 245},  /* 6300 K */
+    {255, 251, 245},  /* 6310 K */
+    {255, 251, 245},  /* 6320 K */
+    {255, 251, 246},  /* 6330 K */
+    {255, 252, 246},  /* 6340 K */
+    {255, 252, 246},  /* 6350 K */
+    {255, 252, 246},  /* 6360 K */
+    {255, 252, 247},  /* 6370 K */
+    {255, 252, 247},  /* 6380 K */
+    {255, 252, 247},  /* 6390 K */
+    {255, 253, 248},  /* 6400 K */
+    {255, 253, 248},  /* 6410 K */
+    {255, 253, 248},  /* 6420 K */
+    {255, 253, 248},  /* 6430 K */
+    {255, 253, 249},  /* 6440 K */
+    {255, 253, 249},  /* 6450 K */
+    {255, 253, 249},  /* 6460 K */
+    {255, 254, 249},  /* 6470 K */
+    {255, 254, 250},  /* 6480 K */
+    {255, 254, 250},  /* 6490 K */
+    {255, 254, 250},  /* 6500 K */
+};
@@ -0,0 +1,551 @@
+/**
+ * @file light_coalescer.c
+ * Per-entity coalescing of light commands implementation
+ */
+
+#include "light_coalescer.h"
+#include "ha_api.h"
+#include "lvgl/lvgl.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Attribute values of one light */
+typedef struct {
+    bool on;
+    uint8_t brightness;
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+    uint16_t color_temp;
+} light_values_t;
+
+/* Per-entity command state */
+struct light_coalescer_entry {
+    entity_handle_t entity;
+    uint8_t pending;          /* HA_LIGHT_FIELD_* bits waiting to be sent */
+    bool flush_requested;     /* Send as soon as nothing is in flight */
+    ha_request_t in_flight;   /* HA_REQUEST_INVALID when idle */
+    uint8_t in_flight_fields; /* Fields sent with in_flight */
+    uint8_t pushed;           /* In-flight fields the server pushed meanwhile */
+    light_values_t local;     /* What the UI shows, including unconfirmed changes */
+    light_values_t confirmed; /* Last values confirmed by the server */
+};
+
+/* Multi-light command in flight */
+typedef struct {
+    ha_request_t request;     /* HA_REQUEST_INVALID when the slot is free */
+    uint8_t fields;
+    int count;
+    entity_handle_t entities[HA_API_GROUP_MAX];
+} light_coalescer_group_t;
+
+/* Indexed by entity handle; active[] lists the handles in use */
+static light_coalescer_entry_t entries[ENTITY_REGISTRY_MAX];
+static bool entry_used[ENTITY_REGISTRY_MAX];
+static entity_handle_t active[ENTITY_REGISTRY_MAX];
+static int num_active = 0;
+static lv_timer_t *flush_timer = NULL;
+static uint32_t suppressed_count = 0;
+static uint32_t rollback_count = 0;
+static light_coalescer_group_t groups[LIGHT_COALESCER_MAX_GROUPS];
+static light_coalescer_view_cb_t view_cb = NULL;
+static void *view_cb_user_data = NULL;
+static bool offline = false;             /* No server: local values are final */
+
+/**
+ * Copy selected fields between value sets
+ */
+static void values_copy(light_values_t *dst, const light_values_t *src, uint8_t fields)
+{
+    if (fields & HA_LIGHT_FIELD_POWER) {
+        dst->on = src->on;
+    }
+    if (fields & HA_LIGHT_FIELD_BRIGHTNESS) {
+        dst->brightness = src->brightness;
+    }
+    if (fields & HA_LIGHT_FIELD_COLOR) {
+        dst->red = src->red;
+        dst->green = src->green;
+        dst->blue = src->blue;
+    }
+    if (fields & HA_LIGHT_FIELD_COLOR_TEMP) {
+        dst->color_temp = src->color_temp;
+    }
+}
+
+/**
+ * Get the selected fields that differ between two value sets
+ */
+static uint8_t values_diff(const light_values_t *a, const light_values_t *b, uint8_t fields)
+{
+    uint8_t diff = 0;
+
+    if (a->on != b->on) {
+        diff |= HA_LIGHT_FIELD_POWER;
+    }
+    if (a->brightness != b->brightness) {
+        diff |= HA_LIGHT_FIELD_BRIGHTNESS;
+    }
+    if (a->red != b->red || a->green != b->green || a->blue != b->blue) {
+        diff |= HA_LIGHT_FIELD_COLOR;
+    }
+    if (a->color_temp != b->color_temp) {
+        diff |= HA_LIGHT_FIELD_COLOR_TEMP;
+    }
+    return diff & fields;
+}
+
+/**
+ * Fill the attributes of a light state from a value set
+ */
+static void values_to_state(const light_values_t *values, light_state_t *state)
+{
+    state->is_on = values->on;
+    state->brightness = values->brightness;
+    state->red = values->red;
+    state->green = values->green;
+    state->blue = values->blue;
+    state->color_temp = values->color_temp;
+}
+
+/**
+ * Read the attributes of a light state into a value set
+ */
+static void values_from_state(light_values_t *values, const light_state_t *state, uint8_t fields)
+{
+    light_values_t src;
+    src.on = state->is_on;
+    src.brightness = state->brightness;
+    src.red = state->red;
+    src.green = state->green;
+    src.blue = state->blue;
+    src.color_temp = state->color_temp;
+    values_copy(values, &src, fields);
+}
+
+/**
+ * Replace local values and put them on screen through the view callback
+ * @return Fields whose shown value changed
+ */
+static uint8_t entry_show(light_coalescer_entry_t *entry, const light_values_t *values, uint8_t fields)
+{
+    uint8_t changed = values_diff(&entry->local, values, fields);
+    if (changed == 0) {
+        return 0;
+    }
+
+    values_copy(&entry->local, values, changed);
+    if (view_cb) {
+        light_state_t state;
+        memset(&state, 0, sizeof(state));
+        state.handle = entry->entity;
+        values_to_state(&entry->local, &state);
+        view_cb(&state, changed, view_cb_user_data);
+    }
+    return changed;
+}
+
+/**
+ * Show the server's values instead of the local ones for some fields
+ * @return Fields whose shown value changed
+ */
+static uint8_t entry_revert(light_coalescer_entry_t *entry, uint8_t fields)
+{
+    return entry_show(entry, &entry->confirmed, fields);
+}
+
+/**
+ * Send all pending attributes of an entry as one merged call, if it is idle
+ */
+static void entry_send(light_coalescer_entry_t *entry)
+{
+    if (entry->in_flight != HA_REQUEST_INVALID || entry->pending == 0) {
+        return;
+    }
+
+    /* The I/O thread drains a full queue shortly: keep the fields pending
+     * and let the flush timer retry */
+    if (!offline && ha_api_queue_full()) {
+        if (flush_timer) {
+            lv_timer_resume(flush_timer);
+        }
+        return;
+    }
+
+    light_state_t state;
+    memset(&state, 0, sizeof(state));
+    values_to_state(&entry->local, &state);
+
+    /* Every attribute merged into this call saves a separate one */
+    for (uint8_t bits = entry->pending; bits & (bits - 1); bits &= (uint8_t)(bits - 1)) {
+        suppressed_count++;
+    }
+
+    uint8_t fields = entry->pending;
+    entry->pending = 0;
+    entry->flush_requested = false;
+
+    /* Offline with the sample lights: local values are all there is */
+    if (offline) {
+        values_copy(&entry->confirmed, &entry->local, fields);
+        return;
+    }
+
+    entry->in_flight = ha_api_update_light(entry->entity, &state, fields);
+    entry->in_flight_fields = fields;
+    entry->pushed = 0;
+
+    /* Not sent: either the server already has these values (nothing to
+     * revert) or the call cannot be built */
+    if (entry->in_flight == HA_REQUEST_INVALID) {
+        entry->in_flight_fields = 0;
+        if (entry_revert(entry, fields)) {
+            rollback_count++;
+        }
+    }
+}
+
+/**
+ * Mark an attribute pending, counting the value it replaces
+ */
+static void entry_mark(light_coalescer_entry_t *entry, uint8_t attr)
+{
+    if (entry->pending & attr) {
+        suppressed_count++;
+    }
+    entry->pending |= attr;
+    if (flush_timer) {
+        lv_timer_resume(flush_timer);
+    }
+}
+
+/**
+ * Fields whose shown value the server has not confirmed yet
+ */
+static uint8_t entry_unsettled(const light_coalescer_entry_t *entry)
+{
+    uint8_t unsettled = entry->pending;
+    if (entry->in_flight != HA_REQUEST_INVALID) {
+        unsettled |= entry->in_flight_fields;
+    }
+    return unsettled;
+}
+
+/**
+ * Flush timer callback
+ */
+static void flush_timer_cb(lv_timer_t *timer)
+{
+    bool pending = false;
+
+    for (int i = 0; i < num_active; i++) {
+        light_coalescer_entry_t *entry = &entries[active[i]];
+        entry_send(entry);
+        pending = pending || entry->pending != 0;
+    }
+
+    /* Nothing left to send: stop waking the main loop until the next change */
+    if (!pending) {
+        lv_timer_pause(timer);
+    }
+}
+
+/**
+ * Confirm or roll back the members of a completed multi-light command
+ * @param unsent Fields the call left out, shown as the server has them
+ */
+static void group_finish(light_coalescer_group_t *group, bool success, uint8_t unsent)
+{
+    bool reverted = false;
+
+    for (int i = 0; i < group->count; i++) {
+        light_coalescer_entry_t *entry = light_coalescer_get(group->entities[i]);
+        if (!entry) continue;
+
+        /* Members changed individually since then keep their own value */
+        uint8_t settled = group->fields & (uint8_t)~entry_unsettled(entry);
+        if (success) {
+            values_copy(&entry->confirmed, &entry->local, settled & (uint8_t)~unsent);
+            entry_revert(entry, settled & unsent);
+        } else if (entry_revert(entry, settled)) {
+            reverted = true;
+        }
+    }
+
+    if (reverted) {
+        rollback_count++;
+    }
+    group->request = HA_REQUEST_INVALID;
+}
+
+/**
+ * Request completion callback: confirm or roll back the fields it carried
+ */
+static void result_cb(const ha_api_result_t *result, void *user_data)
+{
+    (void)user_data;
+
+    if (result->entity == ENTITY_HANDLE_INVALID) {
+        for (int g = 0; g < LIGHT_COALESCER_MAX_GROUPS; g++) {
+            if (groups[g].request == result->request && result->request != HA_REQUEST_INVALID) {
+                if (!result->success) {
+                    fprintf(stderr, "Light command for %d lights failed (status %d), reverting\n",
+                            groups[g].count, result->http_status);
+                }
+                group_finish(&groups[g], result->success, result->unsent);
+                break;
+            }
+        }
+        return;
+    }
+
+    if (result->entity >= ENTITY_REGISTRY_MAX || !entry_used[result->entity]) {
+        return;
+    }
+
+    light_coalescer_entry_t *entry = &entries[result->entity];
+    if (entry->in_flight != result->request) {
+        return;
+    }
+
+    /* Fields changed again since the request was sent wait for the next one */
+    uint8_t settled = entry->in_flight_fields & (uint8_t)~entry->pending;
+    if (result->success) {
+        /* A push that arrived meanwhile is the server's latest word, and
+         * fields the call left out still have the server's old value */
+        uint8_t stale = entry->pushed | result->unsent;
+        values_copy(&entry->confirmed, &entry->local, settled & (uint8_t)~stale);
+        entry_revert(entry, settled & stale);
+    } else {
+        fprintf(stderr, "Light command for %s failed (status %d), reverting\n",
+                entity_registry_get_id(entry->entity), result->http_status);
+        if (entry_revert(entry, settled)) {
+            rollback_count++;
+        }
+    }
+
+    entry->in_flight = HA_REQUEST_INVALID;
+    entry->in_flight_fields = 0;
+    entry->pushed = 0;
+    if (entry->flush_requested) {
+        entry_send(entry);
+    }
+}
+
+/**
+ * Initialize the coalescer
+ */
+void light_coalescer_init(uint32_t period_ms)
+{
+    if (!flush_timer) {
+        flush_timer = lv_timer_create(flush_timer_cb, period_ms, NULL);
+    } else {
+        lv_timer_set_period(flush_timer, period_ms);
+    }
+
+    ha_api_set_result_cb(result_cb, NULL);
+}
+
+/**
+ * Change the flush cadence
+ */
+void light_coalescer_set_period(uint32_t period_ms)
+{
+    if (flush_timer) {
+        lv_timer_set_period(flush_timer, period_ms);
+    }
+}
+
+/**
+ * Get (or create) the command state for an entity
+ */
+light_coalescer_entry_t *light_coalescer_get(entity_handle_t entity)
+{
+    if (entity >= ENTITY_REGISTRY_MAX) {
+        return NULL;
+    }
+
+    light_coalescer_entry_t *entry = &entries[entity];
+    if (!entry_used[entity]) {
+        memset(entry, 0, sizeof(*entry));
+        entry->entity = entity;
+        entry_used[entity] = true;
+        active[num_active++] = entity;
+    }
+    return entry;
+}
+
+/**
+ * Queue a power change
+ */
+void light_coalescer_set_power(light_coalescer_entry_t *entry, bool on)
+{
+    if (!entry) return;
+
+    entry->local.on = on;
+    entry_mark(entry, HA_LIGHT_FIELD_POWER);
+    light_coalescer_flush(entry);
+}
+
+/**
+ * Queue a brightness change
+ */
+void light_coalescer_set_brightness(light_coalescer_entry_t *entry, uint8_t brightness)
+{
+    if (!entry) return;
+
+    entry->local.brightness = brightness;
+    entry_mark(entry, HA_LIGHT_FIELD_BRIGHTNESS);
+}
+
+/**
+ * Queue an RGB color change
+ */
+void light_coalescer_set_color(light_coalescer_entry_t *entry, uint8_t red, uint8_t green, uint8_t blue)
+{
+    if (!entry) return;
+
+    entry->local.red = red;
+    entry->local.green = green;
+    entry->local.blue = blue;
+    entry_mark(entry, HA_LIGHT_FIELD_COLOR);
+}
+
+/**
+ * Queue a color temperature change
+ */
+void light_coalescer_set_color_temp(light_coalescer_entry_t *entry, uint16_t color_temp)
+{
+    if (!entry) return;
+
+    entry->local.color_temp = color_temp;
+    entry_mark(entry, HA_LIGHT_FIELD_COLOR_TEMP);
+}
+
+/**
+ * Apply a change to several lights and send it as one service call
+ */
+ha_request_t light_coalescer_set_group(const ha_light_group_t *group, const light_state_t *state, uint8_t fields)
+{
+    if (!group || !state || group->count <= 0 || group->count > HA_API_GROUP_MAX) {
+        return HA_REQUEST_INVALID;
+    }
+
+    light_values_t values;
+    values_from_state(&values, state, HA_LIGHT_FIELD_POWER | HA_LIGHT_FIELD_BRIGHTNESS |
+                                      HA_LIGHT_FIELD_COLOR | HA_LIGHT_FIELD_COLOR_TEMP);
+
+    /* Show the change on every member right away */
+    for (int i = 0; i < group->count; i++) {
+        light_coalescer_entry_t *entry = light_coalescer_get(group->entities[i]);
+        if (!entry) continue;
+
+        /* The group call supersedes queued values of the same fields, and
+         * the member's own request in flight no longer decides them */
+        for (uint8_t bits = entry->pending & fields; bits; bits &= (uint8_t)(bits - 1)) {
+            suppressed_count++;
+        }
+        entry->pending &= (uint8_t)~fields;
+        entry->in_flight_fields &= (uint8_t)~fields;
+
+        entry_show(entry, &values, fields);
+    }
+
+    /* No room for the call: each member sends the change on its own once
+     * the queue drains */
+    if (!offline && ha_api_queue_full()) {
+        for (int i = 0; i < group->count; i++) {
+            light_coalescer_entry_t *entry = light_coalescer_get(group->entities[i]);
+            if (entry) {
+                entry_mark(entry, fields);
+            }
+        }
+        return HA_REQUEST_INVALID;
+    }
+
+    ha_request_t request = offline ? HA_REQUEST_INVALID : ha_api_update_lights(group, state, fields);
+    if (request == HA_REQUEST_INVALID) {
+        light_coalescer_group_t failed;
+        failed.fields = fields;
+        failed.count = group->count;
+        memcpy(failed.entities, group->entities, (size_t)group->count * sizeof(group->entities[0]));
+        group_finish(&failed, offline, 0);
+        return HA_REQUEST_INVALID;
+    }
+
+    /* Without a free slot the result is ignored; pushes still correct the UI */
+    for (int g = 0; g < LIGHT_COALESCER_MAX_GROUPS; g++) {
+        if (groups[g].request == HA_REQUEST_INVALID) {
+            groups[g].request = request;
+            groups[g].fields = fields;
+            groups[g].count = group->count;
+            memcpy(groups[g].entities, group->entities, (size_t)group->count * sizeof(group->entities[0]));
+            break;
+        }
+    }
+    return request;
+}
+
+/**
+ * Send pending values now or when the in-flight request completes
+ */
+void light_coalescer_flush(light_coalescer_entry_t *entry)
+{
+    if (!entry || entry->pending == 0) return;
+
+    entry->flush_requested = true;
+    entry_send(entry);
+}
+
+/**
+ * Record state reported by the server
+ */
+uint8_t light_coalescer_reconcile(entity_handle_t entity, const light_state_t *state, uint8_t fields)
+{
+    light_coalescer_entry_t *entry = light_coalescer_get(entity);
+    if (!entry) return fields;
+
+    values_from_state(&entry->confirmed, state, fields);
+
+    /* Unconfirmed local changes stay on screen until their request completes */
+    uint8_t unsettled = entry_unsettled(entry);
+    uint8_t shown = fields & (uint8_t)~unsettled;
+    values_from_state(&entry->local, state, shown);
+    if (entry->in_flight != HA_REQUEST_INVALID) {
+        entry->pushed |= fields & entry->in_flight_fields;
+    }
+    return shown;
+}
+
+/**
+ * Keep local changes without sending them
+ */
+void light_coalescer_set_offline(bool is_offline)
+{
+    offline = is_offline;
+}
+
+/**
+ * Set the callback that puts server values back on screen
+ */
+void light_coalescer_set_view_cb(light_coalescer_view_cb_t cb, void *user_data)
+{
+    view_cb = cb;
+    view_cb_user_data = user_data;
+}
+
+/**
+ * Number of calls that were superseded before being sent
+ */
+uint32_t light_coalescer_get_suppressed_count(void)
+{
+    return suppressed_count;
+}
+
+/**
+ * Number of optimistic changes that were rolled back
+ */
+uint32_t light_coalescer_get_rollback_count(void)
+{
+    return rollback_count;
+}
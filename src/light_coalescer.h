@@ -0,0 +1,139 @@
+/**
+ * @file light_coalescer.h
+ * Per-entity coalescing of light commands sent to Home Assistant
+ *
+ * Slider drags produce a value change per pixel. The coalescer keeps only the
+ * latest pending value of each attribute (last write wins), flushes them on a
+ * fixed cadence or when the user releases the slider, and never keeps more
+ * than one request in flight per entity.
+ *
+ * Changes are optimistic: the UI shows them right away and the coalescer
+ * remembers the last state the server confirmed. The request handle of the
+ * command in flight orders it against later local changes. A successful
+ * response confirms the fields it carried, a failed one (or a call that
+ * cannot be built) rolls them back to the confirmed values through the
+ * view callback. While the request queue is full, changes stay pending and
+ * are retried on the next flush. Pushed state never overwrites a change that is still
+ * pending or in flight.
+ */
+
+#ifndef LIGHT_COALESCER_H
+#define LIGHT_COALESCER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "entity_registry.h"
+#include "light_control.h"
+#include "ha_api.h"
+
+/* Default flush cadence (10 Hz) */
+#define LIGHT_COALESCER_DEFAULT_PERIOD_MS 100
+
+/* Multi-light commands tracked in flight for confirmation or rollback */
+#define LIGHT_COALESCER_MAX_GROUPS 8
+
+/* Opaque per-entity command state */
+typedef struct light_coalescer_entry light_coalescer_entry_t;
+
+/**
+ * Callback that puts server values back on screen after a rollback, or when
+ * the server reported different values while a request was in flight
+ * @param state Values to show (handle identifies the light), only valid during the call
+ * @param fields HA_LIGHT_FIELD_* bits of state to show
+ * @param user_data User data given to light_coalescer_set_view_cb
+ */
+typedef void (*light_coalescer_view_cb_t)(const light_state_t *state, uint8_t fields, void *user_data);
+
+/**
+ * Initialize the coalescer and start its flush timer
+ * @param period_ms Flush cadence in milliseconds
+ */
+void light_coalescer_init(uint32_t period_ms);
+
+/**
+ * Change the flush cadence
+ * @param period_ms Flush cadence in milliseconds
+ */
+void light_coalescer_set_period(uint32_t period_ms);
+
+/**
+ * Get (or create) the command state for an entity
+ * @param entity Light entity handle
+ * @return Entry, or NULL for an invalid handle
+ */
+light_coalescer_entry_t *light_coalescer_get(entity_handle_t entity);
+
+/**
+ * Queue a power change; sent without waiting for the next flush tick
+ */
+void light_coalescer_set_power(light_coalescer_entry_t *entry, bool on);
+
+/**
+ * Queue a brightness change
+ */
+void light_coalescer_set_brightness(light_coalescer_entry_t *entry, uint8_t brightness);
+
+/**
+ * Queue an RGB color change
+ */
+void light_coalescer_set_color(light_coalescer_entry_t *entry, uint8_t red, uint8_t green, uint8_t blue);
+
+/**
+ * Queue a color temperature change
+ */
+void light_coalescer_set_color_temp(light_coalescer_entry_t *entry, uint16_t color_temp);
+
+/**
+ * Apply a change to several lights at once and send it as one service call.
+ * Every member shows the change immediately (through the view callback);
+ * a failed call rolls the members back. If the request queue is full, each
+ * member sends the change on its own once it drains.
+ * @param group Lights to change, at most HA_API_GROUP_MAX
+ * @param state Requested values
+ * @param fields HA_LIGHT_FIELD_* bits of state to apply
+ * @return Request handle, or HA_REQUEST_INVALID if it could not be queued
+ */
+ha_request_t light_coalescer_set_group(const ha_light_group_t *group, const light_state_t *state, uint8_t fields);
+
+/**
+ * Send pending values now (e.g. on slider release), or as soon as the
+ * request currently in flight completes
+ */
+void light_coalescer_flush(light_coalescer_entry_t *entry);
+
+/**
+ * Record state reported by the server (initial load or a push)
+ * @param entity Light entity handle
+ * @param state Reported state
+ * @param fields HA_LIGHT_FIELD_* bits present in state
+ * @return The fields of state the UI should show; fields with a local
+ *         change that is not confirmed yet are left out
+ */
+uint8_t light_coalescer_reconcile(entity_handle_t entity, const light_state_t *state, uint8_t fields);
+
+/**
+ * Keep local changes without sending them, for lights no server knows
+ * (the sample lights shown when Home Assistant cannot be reached)
+ * @param is_offline true to confirm changes locally, false to send them
+ */
+void light_coalescer_set_offline(bool is_offline);
+
+/**
+ * Set the callback that puts server values back on screen
+ * @param cb Callback, or NULL
+ * @param user_data User data passed to the callback
+ */
+void light_coalescer_set_view_cb(light_coalescer_view_cb_t cb, void *user_data);
+
+/**
+ * Number of calls that were superseded before being sent
+ */
+uint32_t light_coalescer_get_suppressed_count(void);
+
+/**
+ * Number of optimistic changes rolled back because their request failed
+ * or could not be built
+ */
+uint32_t light_coalescer_get_rollback_count(void);
+
+#endif /* LIGHT_COALESCER_H */
@@ -4,24 +4,95 @@
  */
 
 #include "light_control.h"
-#include "ha_api.h"
+#include "light_coalescer.h"
+#include "kelvin_lut.h"
+#include "color_wheel.h"
+#include "theme.h"
+#include "mem_stats.h"
+#include "trace.h"
 #include <stdio.h>
 #include <string.h>
 
+/* Fields of a card that changed since it was last rendered */
+#define CARD_FIELD_POWER      (1u << 0)
+#define CARD_FIELD_BRIGHTNESS (1u << 1)
+#define CARD_FIELD_COLOR      (1u << 2)
+#define CARD_FIELD_COLOR_TEMP (1u << 3)
+
+/* Widget updates (each one invalidates an area) per field */
+#define CARD_WIDGETS_POWER      3  /* Switch, status text, status color */
+#define CARD_WIDGETS_BRIGHTNESS 2  /* Slider, percentage label */
+#define CARD_WIDGETS_COLOR      2  /* Wheel marker, preview */
+#define CARD_WIDGETS_COLOR_TEMP 1  /* Slider */
+
+/* Collapsed color controls are deleted after this long */
+#define CARD_COLOR_RELEASE_MS 30000
+
+/* Top of the color controls, below the brightness row */
+#define CARD_COLOR_PANEL_Y 140
+
+/* Values currently rendered by a card's widgets */
+typedef struct {
+    bool is_on;
+    uint8_t brightness;
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+    uint16_t color_temp;
+} light_card_shown_t;
+
 /* Structure to store light card data */
 typedef struct {
     light_state_t *light;
+    light_coalescer_entry_t *commands;
+    light_type_t type;
+    lv_obj_t *title_label;
     lv_obj_t *switch_btn;
     lv_obj_t *brightness_slider;
     lv_obj_t *brightness_label;
-    lv_obj_t *red_slider;
-    lv_obj_t *green_slider;
-    lv_obj_t *blue_slider;
+    lv_obj_t *expand_btn;       /* Color cards only */
+    lv_obj_t *expand_label;
+    lv_obj_t *color_panel;      /* Color controls, NULL until first expanded */
+    lv_timer_t *release_timer;  /* Pending deletion of the collapsed color panel */
+    bool expanded;
+    lv_obj_t *color_wheel;
     lv_obj_t *color_preview;
     lv_obj_t *temp_slider;
     lv_obj_t *status_label;
+    light_card_shown_t shown;
+    bool pooled;
+    int32_t heap_bytes;         /* Charged to MEM_STATS_CARDS */
+    int32_t color_heap_bytes;   /* Charged to MEM_STATS_COLOR while the panel exists */
 } light_card_data_t;
 
+/* Widget updates avoided by light_control_update_card */
+static uint32_t skipped_updates = 0;
+
+/* Notified when the user expands or collapses a card */
+static light_control_expand_cb_t expand_cb = NULL;
+static void *expand_cb_user_data = NULL;
+
+/* Notified when the user switches a light */
+static light_control_power_cb_t power_cb = NULL;
+static void *power_cb_user_data = NULL;
+
+/* Released cards, ready to be rebound */
+static lv_obj_t *card_pool[LIGHT_TYPE_COUNT][LIGHT_CONTROL_POOL_SIZE];
+static int card_pool_count[LIGHT_TYPE_COUNT];
+
+/**
+ * Remove a card from the pool (it is being deleted with its parent)
+ */
+static void card_pool_remove(lv_obj_t *card, light_type_t type)
+{
+    for (int i = 0; i < card_pool_count[type]; i++) {
+        if (card_pool[type][i] == card) {
+            card_pool[type][i] = card_pool[type][--card_pool_count[type]];
+            return;
+        }
+    }
+}
+
 /**
  * Cleanup handler for light card
  */
@@ -33,15 +104,55 @@ static void light_card_cleanup(lv_event_t *e)
         lv_obj_t *card = lv_event_get_target(e);
         light_card_data_t *card_data = (light_card_data_t *)lv_obj_get_user_data(card);
         if (card_data) {
+            if (card_data->pooled) {
+                card_pool_remove(card, card_data->type);
+            }
+            if (card_data->release_timer) {
+                lv_timer_delete(card_data->release_timer);
+            }
+            if (card_data->color_panel) {
+                mem_stats_charge(MEM_STATS_COLOR, -card_data->color_heap_bytes);
+            }
+            mem_stats_charge(MEM_STATS_CARDS, -card_data->heap_bytes);
             lv_free(card_data);
             lv_obj_set_user_data(card, NULL);
         }
     }
 }
 
+/**
+ * Show the power state in the status label
+ */
+static void set_status(light_card_data_t *card_data, bool is_on)
+{
+    lv_label_set_text(card_data->status_label, is_on ? "ON" : "OFF");
+    theme_set_status(card_data->status_label, is_on);
+}
+
+/**
+ * Show the brightness as a percentage
+ */
+static void set_brightness_label(light_card_data_t *card_data, uint8_t brightness)
+{
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%d%%", (int)(brightness * 100 / 255));
+    lv_label_set_text(card_data->brightness_label, buf);
+}
+
+/**
+ * Show the white of a color temperature in the color preview
+ */
+static void set_preview_kelvin(light_card_data_t *card_data, uint16_t color_temp)
+{
+    uint8_t red, green, blue;
+    kelvin_lut_rgb(color_temp, &red, &green, &blue);
+    lv_obj_set_style_bg_color(card_data->color_preview, lv_color_make(red, green, blue), 0);
+}
+
 /* Event handler for power switch */
 static void switch_event_handler(lv_event_t *e)
 {
+    TRACE_FUNC();
     lv_event_code_t code = lv_event_get_code(e);
     lv_obj_t *sw = lv_event_get_target(e);
     
@@ -49,17 +160,22 @@ static void switch_event_handler(lv_event_t *e)
         light_card_data_t *card_data = (light_card_data_t *)lv_event_get_user_data(e);
         bool is_on = lv_obj_has_state(sw, LV_STATE_CHECKED);
         
+        if (power_cb && card_data->light->is_on != is_on) {
+            power_cb(card_data->light, is_on, power_cb_user_data);
+        }
         card_data->light->is_on = is_on;
-        ha_api_set_light_power(card_data->light->entity_id, is_on);
+        card_data->shown.is_on = is_on;
+        light_coalescer_set_power(card_data->commands, is_on);
         
         /* Update status label */
-        lv_label_set_text(card_data->status_label, is_on ? "ON" : "OFF");
+        set_status(card_data, is_on);
     }
 }
 
 /* Event handler for brightness slider */
 static void brightness_event_handler(lv_event_t *e)
 {
+    TRACE_FUNC();
     lv_event_code_t code = lv_event_get_code(e);
     lv_obj_t *slider = lv_event_get_target(e);
     
@@ -68,27 +184,29 @@ static void brightness_event_handler(lv_event_t *e)
         int32_t value = lv_slider_get_value(slider);
         
         card_data->light->brightness = (uint8_t)value;
+        card_data->shown.brightness = (uint8_t)value;
         
         /* Update brightness label */
-        char buf[16];
-        snprintf(buf, sizeof(buf), "%d%%", (int)(value * 100 / 255));
-        lv_label_set_text(card_data->brightness_label, buf);
+        set_brightness_label(card_data, (uint8_t)value);
         
-        ha_api_set_light_brightness(card_data->light->entity_id, (uint8_t)value);
+        light_coalescer_set_brightness(card_data->commands, (uint8_t)value);
     }
 }
 
-/* Event handler for color sliders (color lights only) */
-static void color_slider_event_handler(lv_event_t *e)
+/* Event handler for the color wheel (color lights only) */
+static void color_wheel_event_handler(lv_event_t *e)
 {
+    TRACE_FUNC();
     lv_event_code_t code = lv_event_get_code(e);
     
     if (code == LV_EVENT_VALUE_CHANGED) {
         light_card_data_t *card_data = (light_card_data_t *)lv_event_get_user_data(e);
         
-        card_data->light->red = (uint8_t)lv_slider_get_value(card_data->red_slider);
-        card_data->light->green = (uint8_t)lv_slider_get_value(card_data->green_slider);
-        card_data->light->blue = (uint8_t)lv_slider_get_value(card_data->blue_slider);
+        color_wheel_get_rgb(card_data->color_wheel, &card_data->light->red,
+                            &card_data->light->green, &card_data->light->blue);
+        card_data->shown.red = card_data->light->red;
+        card_data->shown.green = card_data->light->green;
+        card_data->shown.blue = card_data->light->blue;
         
         /* Update color preview */
         lv_color_t preview_color = lv_color_make(card_data->light->red, 
@@ -96,16 +214,17 @@ static void color_slider_event_handler(lv_event_t *e)
                                                   card_data->light->blue);
         lv_obj_set_style_bg_color(card_data->color_preview, preview_color, 0);
         
-        ha_api_set_light_color(card_data->light->entity_id, 
-                              card_data->light->red,
-                              card_data->light->green,
-                              card_data->light->blue);
+        light_coalescer_set_color(card_data->commands,
+                                  card_data->light->red,
+                                  card_data->light->green,
+                                  card_data->light->blue);
     }
 }
 
 /* Event handler for color temperature slider (color lights only) */
 static void temp_event_handler(lv_event_t *e)
 {
+    TRACE_FUNC();
     lv_event_code_t code = lv_event_get_code(e);
     lv_obj_t *slider = lv_event_get_target(e);
     
@@ -114,7 +233,164 @@ static void temp_event_handler(lv_event_t *e)
         int32_t value = lv_slider_get_value(slider);
         
         card_data->light->color_temp = (uint16_t)value;
-        ha_api_set_light_color_temp(card_data->light->entity_id, (uint16_t)value);
+        card_data->shown.color_temp = (uint16_t)value;
+        
+        /* Preview the white the light is being set to */
+        set_preview_kelvin(card_data, (uint16_t)value);
+        
+        light_coalescer_set_color_temp(card_data->commands, (uint16_t)value);
+    }
+}
+
+/* Event handler for slider and wheel release: send the final value right away */
+static void slider_released_handler(lv_event_t *e)
+{
+    TRACE_FUNC();
+    lv_event_code_t code = lv_event_get_code(e);
+    
+    if (code == LV_EVENT_RELEASED) {
+        light_card_data_t *card_data = (light_card_data_t *)lv_event_get_user_data(e);
+        light_coalescer_flush(card_data->commands);
+    }
+}
+
+/**
+ * Build the color controls of a color card from the light's current state
+ */
+static bool color_panel_create(lv_obj_t *card, light_card_data_t *card_data)
+{
+    TRACE_FUNC();
+    light_state_t *light = card_data->light;
+    size_t heap_before = mem_stats_used();
+    
+    lv_obj_t *panel = lv_obj_create(card);
+    if (!panel) {
+        mem_stats_failure("color controls");
+        return false;
+    }
+    lv_obj_remove_style_all(panel);
+    lv_obj_set_size(panel, LV_PCT(100), LV_SIZE_CONTENT);
+    lv_obj_align(panel, LV_ALIGN_TOP_LEFT, 0, CARD_COLOR_PANEL_Y);
+    lv_obj_clear_flag(panel, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_clear_flag(panel, LV_OBJ_FLAG_SCROLLABLE);
+    /* Slider knobs reach past the panel's edges */
+    lv_obj_add_flag(panel, LV_OBJ_FLAG_OVERFLOW_VISIBLE);
+    
+    /* Color Control Title */
+    lv_obj_t *rgb_title = lv_label_create(panel);
+    lv_label_set_text(rgb_title, "Color:");
+    lv_obj_align(rgb_title, LV_ALIGN_TOP_LEFT, 0, 0);
+    
+    /* Color preview box */
+    card_data->color_preview = lv_obj_create(panel);
+    lv_obj_set_size(card_data->color_preview, 60, 60);
+    lv_obj_align(card_data->color_preview, LV_ALIGN_TOP_RIGHT, 0, 25);
+    lv_color_t preview_color = lv_color_make(light->red, light->green, light->blue);
+    lv_obj_set_style_bg_color(card_data->color_preview, preview_color, 0);
+    theme_add(card_data->color_preview, THEME_PREVIEW, 0);
+    
+    /* Hue/saturation wheel, the disc image is shared by all cards */
+    card_data->color_wheel = color_wheel_create(panel);
+    if (card_data->color_wheel) {
+        lv_obj_align(card_data->color_wheel, LV_ALIGN_TOP_LEFT, 0, 25);
+        color_wheel_set_rgb(card_data->color_wheel, light->red, light->green, light->blue);
+        lv_obj_add_event_cb(card_data->color_wheel, color_wheel_event_handler, LV_EVENT_VALUE_CHANGED, card_data);
+        lv_obj_add_event_cb(card_data->color_wheel, slider_released_handler, LV_EVENT_RELEASED, card_data);
+    }
+    
+    /* Color temperature slider */
+    lv_obj_t *temp_title = lv_label_create(panel);
+    lv_label_set_text(temp_title, "Temperature (K):");
+    lv_obj_align(temp_title, LV_ALIGN_TOP_LEFT, 0, 155);
+    
+    card_data->temp_slider = lv_slider_create(panel);
+    lv_obj_set_width(card_data->temp_slider, 250);
+    theme_add(card_data->temp_slider, THEME_SLIDER_INDICATOR, LV_PART_INDICATOR);
+    lv_obj_align(card_data->temp_slider, LV_ALIGN_TOP_LEFT, 0, 180);
+    lv_slider_set_range(card_data->temp_slider, 2000, 6500); /* Common CCT range */
+    lv_slider_set_value(card_data->temp_slider, light->color_temp, LV_ANIM_OFF);
+    lv_obj_add_event_cb(card_data->temp_slider, temp_event_handler, LV_EVENT_VALUE_CHANGED, card_data);
+    lv_obj_add_event_cb(card_data->temp_slider, slider_released_handler, LV_EVENT_RELEASED, card_data);
+    
+    card_data->color_panel = panel;
+    card_data->color_heap_bytes = (int32_t)(mem_stats_used() - heap_before);
+    mem_stats_charge(MEM_STATS_COLOR, card_data->color_heap_bytes);
+    card_data->shown.red = light->red;
+    card_data->shown.green = light->green;
+    card_data->shown.blue = light->blue;
+    card_data->shown.color_temp = light->color_temp;
+    return true;
+}
+
+/**
+ * Delete the color controls of a card that stayed collapsed
+ */
+static void color_panel_release_cb(lv_timer_t *timer)
+{
+    light_card_data_t *card_data = (light_card_data_t *)lv_timer_get_user_data(timer);
+    
+    /* One-shot: the timer deletes itself after this call */
+    card_data->release_timer = NULL;
+    if (card_data->color_panel && !card_data->expanded) {
+        lv_obj_delete(card_data->color_panel);
+        mem_stats_charge(MEM_STATS_COLOR, -card_data->color_heap_bytes);
+        card_data->color_panel = NULL;
+        card_data->color_wheel = NULL;
+        card_data->color_preview = NULL;
+        card_data->temp_slider = NULL;
+    }
+}
+
+/**
+ * Show or hide the color controls, building them on first use
+ */
+static void card_set_expanded(lv_obj_t *card, light_card_data_t *card_data, bool expanded)
+{
+    if (!card_data->expand_btn || card_data->expanded == expanded) {
+        return;
+    }
+    
+    if (expanded) {
+        if (card_data->release_timer) {
+            lv_timer_delete(card_data->release_timer);
+            card_data->release_timer = NULL;
+        }
+        if (!card_data->color_panel) {
+            if (!color_panel_create(card, card_data)) {
+                return;
+            }
+        } else {
+            /* Kept (and kept up to date) since the last collapse */
+            lv_obj_clear_flag(card_data->color_panel, LV_OBJ_FLAG_HIDDEN);
+        }
+    } else if (card_data->color_panel) {
+        lv_obj_add_flag(card_data->color_panel, LV_OBJ_FLAG_HIDDEN);
+        if (!card_data->release_timer) {
+            card_data->release_timer = lv_timer_create(color_panel_release_cb, CARD_COLOR_RELEASE_MS, card_data);
+            if (card_data->release_timer) {
+                lv_timer_set_repeat_count(card_data->release_timer, 1);
+            }
+        }
+    }
+    
+    card_data->expanded = expanded;
+    lv_label_set_text(card_data->expand_label, expanded ? "Color " LV_SYMBOL_UP : "Color " LV_SYMBOL_DOWN);
+}
+
+/* Event handler for the expand button (color lights only) */
+static void expand_event_handler(lv_event_t *e)
+{
+    TRACE_FUNC();
+    lv_event_code_t code = lv_event_get_code(e);
+    
+    if (code == LV_EVENT_CLICKED) {
+        lv_obj_t *card = (lv_obj_t *)lv_event_get_user_data(e);
+        light_card_data_t *card_data = (light_card_data_t *)lv_obj_get_user_data(card);
+        
+        card_set_expanded(card, card_data, !card_data->expanded);
+        if (expand_cb) {
+            expand_cb(card, card_data->light, card_data->expanded, expand_cb_user_data);
+        }
     }
 }
 
@@ -123,35 +399,44 @@ static void temp_event_handler(lv_event_t *e)
  */
 lv_obj_t* light_control_create_card(lv_obj_t *parent, light_state_t *light)
 {
+    TRACE_FUNC();
+    size_t heap_before = mem_stats_used();
+    
     /* Create card container */
     lv_obj_t *card = lv_obj_create(parent);
-    lv_obj_set_size(card, 300, LV_SIZE_CONTENT);
-    lv_obj_set_style_pad_all(card, 15, 0);
-    lv_obj_set_style_bg_color(card, lv_color_hex(0x2C2C2C), 0);
-    lv_obj_set_style_border_color(card, lv_color_hex(0x404040), 0);
-    lv_obj_set_style_border_width(card, 2, 0);
-    lv_obj_set_style_radius(card, 10, 0);
+    lv_obj_set_size(card, LIGHT_CARD_WIDTH, LV_SIZE_CONTENT);
+    theme_add(card, THEME_CARD, 0);
     
     /* Allocate card data */
     light_card_data_t *card_data = (light_card_data_t *)lv_malloc(sizeof(light_card_data_t));
+    if (!card_data) {
+        mem_stats_failure("light card");
+        lv_obj_delete(card);
+        return NULL;
+    }
     memset(card_data, 0, sizeof(light_card_data_t));
     card_data->light = light;
+    card_data->commands = light_coalescer_get(light->handle);
+    card_data->type = light->type;
+    card_data->shown.is_on = light->is_on;
+    card_data->shown.brightness = light->brightness;
+    card_data->shown.red = light->red;
+    card_data->shown.green = light->green;
+    card_data->shown.blue = light->blue;
+    card_data->shown.color_temp = light->color_temp;
     lv_obj_set_user_data(card, card_data);
     
     /* Add cleanup handler to free memory when card is deleted */
     lv_obj_add_event_cb(card, light_card_cleanup, LV_EVENT_DELETE, NULL);
     
     /* Create title label */
-    lv_obj_t *title_label = lv_label_create(card);
-    lv_label_set_text(title_label, light->name);
-    lv_obj_set_style_text_font(title_label, &lv_font_montserrat_20, 0);
-    lv_obj_set_style_text_color(title_label, lv_color_white(), 0);
+    card_data->title_label = lv_label_create(card);
+    lv_label_set_text(card_data->title_label, light->name);
+    theme_add(card_data->title_label, THEME_CARD_TITLE, 0);
     
     /* Create status label */
     card_data->status_label = lv_label_create(card);
-    lv_label_set_text(card_data->status_label, light->is_on ? "ON" : "OFF");
-    lv_obj_set_style_text_color(card_data->status_label, 
-                                light->is_on ? lv_color_hex(0x00FF00) : lv_color_hex(0xFF0000), 0);
+    set_status(card_data, light->is_on);
     lv_obj_align(card_data->status_label, LV_ALIGN_TOP_RIGHT, 0, 0);
     
     /* Create power switch */
@@ -165,140 +450,186 @@ lv_obj_t* light_control_create_card(lv_obj_t *parent, light_state_t *light)
     /* Create brightness slider */
     lv_obj_t *brightness_title = lv_label_create(card);
     lv_label_set_text(brightness_title, "Brightness:");
-    lv_obj_set_style_text_color(brightness_title, lv_color_white(), 0);
     lv_obj_align(brightness_title, LV_ALIGN_TOP_LEFT, 0, 75);
     
     card_data->brightness_slider = lv_slider_create(card);
     lv_obj_set_width(card_data->brightness_slider, 200);
+    theme_add(card_data->brightness_slider, THEME_SLIDER_INDICATOR, LV_PART_INDICATOR);
     lv_obj_align(card_data->brightness_slider, LV_ALIGN_TOP_LEFT, 0, 100);
     lv_slider_set_range(card_data->brightness_slider, 0, 255);
     lv_slider_set_value(card_data->brightness_slider, light->brightness, LV_ANIM_OFF);
     lv_obj_add_event_cb(card_data->brightness_slider, brightness_event_handler, LV_EVENT_VALUE_CHANGED, card_data);
+    lv_obj_add_event_cb(card_data->brightness_slider, slider_released_handler, LV_EVENT_RELEASED, card_data);
     
     card_data->brightness_label = lv_label_create(card);
-    char buf[16];
-    snprintf(buf, sizeof(buf), "%d%%", (int)(light->brightness * 100 / 255));
-    lv_label_set_text(card_data->brightness_label, buf);
-    lv_obj_set_style_text_color(card_data->brightness_label, lv_color_white(), 0);
+    set_brightness_label(card_data, light->brightness);
     lv_obj_align(card_data->brightness_label, LV_ALIGN_TOP_RIGHT, 0, 100);
     
-    /* For color lights, add RGB sliders and temperature control */
+    /* Color lights start compact: the color controls are built when the
+     * card is first expanded */
     if (light->type == LIGHT_TYPE_COLOR) {
-        /* RGB Control Title */
-        lv_obj_t *rgb_title = lv_label_create(card);
-        lv_label_set_text(rgb_title, "RGB Color:");
-        lv_obj_set_style_text_color(rgb_title, lv_color_white(), 0);
-        lv_obj_align(rgb_title, LV_ALIGN_TOP_LEFT, 0, 140);
+        card_data->expand_btn = lv_button_create(card);
+        lv_obj_set_height(card_data->expand_btn, 32);
+        lv_obj_align(card_data->expand_btn, LV_ALIGN_TOP_RIGHT, 0, 30);
+        lv_obj_add_event_cb(card_data->expand_btn, expand_event_handler, LV_EVENT_CLICKED, card);
         
-        /* Color preview box */
-        card_data->color_preview = lv_obj_create(card);
-        lv_obj_set_size(card_data->color_preview, 60, 60);
-        lv_obj_align(card_data->color_preview, LV_ALIGN_TOP_RIGHT, 0, 165);
-        lv_color_t preview_color = lv_color_make(light->red, light->green, light->blue);
-        lv_obj_set_style_bg_color(card_data->color_preview, preview_color, 0);
-        lv_obj_set_style_border_width(card_data->color_preview, 2, 0);
-        lv_obj_set_style_border_color(card_data->color_preview, lv_color_white(), 0);
-        
-        /* Red slider */
-        lv_obj_t *red_label = lv_label_create(card);
-        lv_label_set_text(red_label, "Red:");
-        lv_obj_set_style_text_color(red_label, lv_color_make(255, 100, 100), 0);
-        lv_obj_align(red_label, LV_ALIGN_TOP_LEFT, 0, 165);
-        
-        card_data->red_slider = lv_slider_create(card);
-        lv_obj_set_width(card_data->red_slider, 180);
-        lv_obj_align(card_data->red_slider, LV_ALIGN_TOP_LEFT, 50, 165);
-        lv_slider_set_range(card_data->red_slider, 0, 255);
-        lv_slider_set_value(card_data->red_slider, light->red, LV_ANIM_OFF);
-        lv_obj_set_style_bg_color(card_data->red_slider, lv_color_make(100, 0, 0), LV_PART_INDICATOR);
-        lv_obj_add_event_cb(card_data->red_slider, color_slider_event_handler, LV_EVENT_VALUE_CHANGED, card_data);
-        
-        /* Green slider */
-        lv_obj_t *green_label = lv_label_create(card);
-        lv_label_set_text(green_label, "Green:");
-        lv_obj_set_style_text_color(green_label, lv_color_make(100, 255, 100), 0);
-        lv_obj_align(green_label, LV_ALIGN_TOP_LEFT, 0, 200);
-        
-        card_data->green_slider = lv_slider_create(card);
-        lv_obj_set_width(card_data->green_slider, 180);
-        lv_obj_align(card_data->green_slider, LV_ALIGN_TOP_LEFT, 50, 200);
-        lv_slider_set_range(card_data->green_slider, 0, 255);
-        lv_slider_set_value(card_data->green_slider, light->green, LV_ANIM_OFF);
-        lv_obj_set_style_bg_color(card_data->green_slider, lv_color_make(0, 100, 0), LV_PART_INDICATOR);
-        lv_obj_add_event_cb(card_data->green_slider, color_slider_event_handler, LV_EVENT_VALUE_CHANGED, card_data);
-        
-        /* Blue slider */
-        lv_obj_t *blue_label = lv_label_create(card);
-        lv_label_set_text(blue_label, "Blue:");
-        lv_obj_set_style_text_color(blue_label, lv_color_make(100, 100, 255), 0);
-        lv_obj_align(blue_label, LV_ALIGN_TOP_LEFT, 0, 235);
-        
-        card_data->blue_slider = lv_slider_create(card);
-        lv_obj_set_width(card_data->blue_slider, 180);
-        lv_obj_align(card_data->blue_slider, LV_ALIGN_TOP_LEFT, 50, 235);
-        lv_slider_set_range(card_data->blue_slider, 0, 255);
-        lv_slider_set_value(card_data->blue_slider, light->blue, LV_ANIM_OFF);
-        lv_obj_set_style_bg_color(card_data->blue_slider, lv_color_make(0, 0, 100), LV_PART_INDICATOR);
-        lv_obj_add_event_cb(card_data->blue_slider, color_slider_event_handler, LV_EVENT_VALUE_CHANGED, card_data);
-        
-        /* Color temperature slider */
-        lv_obj_t *temp_title = lv_label_create(card);
-        lv_label_set_text(temp_title, "Temperature (K):");
-        lv_obj_set_style_text_color(temp_title, lv_color_white(), 0);
-        lv_obj_align(temp_title, LV_ALIGN_TOP_LEFT, 0, 275);
-        
-        card_data->temp_slider = lv_slider_create(card);
-        lv_obj_set_width(card_data->temp_slider, 250);
-        lv_obj_align(card_data->temp_slider, LV_ALIGN_TOP_LEFT, 0, 300);
-        lv_slider_set_range(card_data->temp_slider, 2000, 6500); /* Common CCT range */
-        lv_slider_set_value(card_data->temp_slider, light->color_temp, LV_ANIM_OFF);
-        lv_obj_add_event_cb(card_data->temp_slider, temp_event_handler, LV_EVENT_VALUE_CHANGED, card_data);
+        card_data->expand_label = lv_label_create(card_data->expand_btn);
+        lv_label_set_text(card_data->expand_label, "Color " LV_SYMBOL_DOWN);
+        lv_obj_center(card_data->expand_label);
     }
     
+    card_data->heap_bytes = (int32_t)(mem_stats_used() - heap_before);
+    mem_stats_charge(MEM_STATS_CARDS, card_data->heap_bytes);
     return card;
 }
 
+/**
+ * Get a card for a light, from the pool when possible
+ */
+lv_obj_t* light_control_acquire_card(lv_obj_t *parent, light_state_t *light)
+{
+    TRACE_FUNC();
+    light_type_t type = light->type;
+    
+    if (card_pool_count[type] == 0) {
+        return light_control_create_card(parent, light);
+    }
+    
+    lv_obj_t *card = card_pool[type][--card_pool_count[type]];
+    light_card_data_t *card_data = (light_card_data_t *)lv_obj_get_user_data(card);
+    card_data->pooled = false;
+    
+    if (lv_obj_get_parent(card) != parent) {
+        lv_obj_set_parent(card, parent);
+    }
+    /* Keep the creation order for flex layouts */
+    lv_obj_move_foreground(card);
+    
+    light_control_bind_card(card, light);
+    lv_obj_clear_flag(card, LV_OBJ_FLAG_HIDDEN);
+    return card;
+}
+
+/**
+ * Return a card to the pool
+ */
+void light_control_release_card(lv_obj_t *card)
+{
+    light_card_data_t *card_data = (light_card_data_t *)lv_obj_get_user_data(card);
+    if (!card_data || card_data->pooled) return;
+    
+    if (card_pool_count[card_data->type] >= LIGHT_CONTROL_POOL_SIZE) {
+        lv_obj_delete(card);
+        return;
+    }
+    
+    lv_obj_add_flag(card, LV_OBJ_FLAG_HIDDEN);
+    card_data->pooled = true;
+    card_pool[card_data->type][card_pool_count[card_data->type]++] = card;
+}
+
+/**
+ * Rebind an existing card to another light of the same type
+ */
+bool light_control_bind_card(lv_obj_t *card, light_state_t *light)
+{
+    TRACE_FUNC();
+    light_card_data_t *card_data = (light_card_data_t *)lv_obj_get_user_data(card);
+    if (!card_data || card_data->type != light->type) return false;
+    
+    if (card_data->light != light) {
+        /* Expansion belongs to the light, a rebound card starts compact */
+        card_set_expanded(card, card_data, false);
+        card_data->light = light;
+        card_data->commands = light_coalescer_get(light->handle);
+    }
+    /* The name may also change in place (configuration reload) */
+    if (strcmp(lv_label_get_text(card_data->title_label), light->name) != 0) {
+        lv_label_set_text(card_data->title_label, light->name);
+    }
+
+    /* Render the new light's values (copies onto itself) */
+    light_control_update_card(card, light);
+    return true;
+}
+
 /**
  * Update a light control card with new state
  */
 void light_control_update_card(lv_obj_t *card, light_state_t *light)
 {
+    TRACE_FUNC();
     light_card_data_t *card_data = (light_card_data_t *)lv_obj_get_user_data(card);
     if (!card_data) return;
     
-    /* Update power switch */
-    if (light->is_on) {
-        lv_obj_add_state(card_data->switch_btn, LV_STATE_CHECKED);
-    } else {
-        lv_obj_clear_state(card_data->switch_btn, LV_STATE_CHECKED);
+    light_card_shown_t *shown = &card_data->shown;
+    uint8_t dirty = 0;
+    
+    if (light->is_on != shown->is_on) dirty |= CARD_FIELD_POWER;
+    if (light->brightness != shown->brightness) dirty |= CARD_FIELD_BRIGHTNESS;
+    if (light->red != shown->red || light->green != shown->green || light->blue != shown->blue) {
+        dirty |= CARD_FIELD_COLOR;
     }
+    if (light->color_temp != shown->color_temp) dirty |= CARD_FIELD_COLOR_TEMP;
     
-    /* Update status label */
-    lv_label_set_text(card_data->status_label, light->is_on ? "ON" : "OFF");
-    lv_obj_set_style_text_color(card_data->status_label,
-                                light->is_on ? lv_color_hex(0x00FF00) : lv_color_hex(0xFF0000), 0);
+    /* Color widgets only exist on expanded (or recently collapsed) color cards */
+    if (!card_data->temp_slider) {
+        dirty &= (uint8_t)~(CARD_FIELD_COLOR | CARD_FIELD_COLOR_TEMP);
+    }
+    
+    /* Update power switch and status label */
+    if (dirty & CARD_FIELD_POWER) {
+        if (light->is_on) {
+            lv_obj_add_state(card_data->switch_btn, LV_STATE_CHECKED);
+        } else {
+            lv_obj_clear_state(card_data->switch_btn, LV_STATE_CHECKED);
+        }
+        set_status(card_data, light->is_on);
+    } else {
+        skipped_updates += CARD_WIDGETS_POWER;
+    }
     
     /* Update brightness */
-    lv_slider_set_value(card_data->brightness_slider, light->brightness, LV_ANIM_OFF);
-    char buf[16];
-    snprintf(buf, sizeof(buf), "%d%%", (int)(light->brightness * 100 / 255));
-    lv_label_set_text(card_data->brightness_label, buf);
+    if (dirty & CARD_FIELD_BRIGHTNESS) {
+        lv_slider_set_value(card_data->brightness_slider, light->brightness, LV_ANIM_OFF);
+        set_brightness_label(card_data, light->brightness);
+    } else {
+        skipped_updates += CARD_WIDGETS_BRIGHTNESS;
+    }
     
-    /* Update color controls if it's a color light */
-    if (light->type == LIGHT_TYPE_COLOR && card_data->red_slider) {
-        lv_slider_set_value(card_data->red_slider, light->red, LV_ANIM_OFF);
-        lv_slider_set_value(card_data->green_slider, light->green, LV_ANIM_OFF);
-        lv_slider_set_value(card_data->blue_slider, light->blue, LV_ANIM_OFF);
-        
-        /* Update color preview */
-        lv_color_t preview_color = lv_color_make(light->red, light->green, light->blue);
-        lv_obj_set_style_bg_color(card_data->color_preview, preview_color, 0);
+    /* Update color controls if they are built */
+    if (card_data->temp_slider) {
+        if (dirty & CARD_FIELD_COLOR) {
+            if (card_data->color_wheel) {
+                color_wheel_set_rgb(card_data->color_wheel, light->red, light->green, light->blue);
+            }
+            
+            /* Update color preview */
+            lv_color_t preview_color = lv_color_make(light->red, light->green, light->blue);
+            lv_obj_set_style_bg_color(card_data->color_preview, preview_color, 0);
+        } else {
+            skipped_updates += CARD_WIDGETS_COLOR;
+        }
         
-        if (card_data->temp_slider) {
+        if (dirty & CARD_FIELD_COLOR_TEMP) {
             lv_slider_set_value(card_data->temp_slider, light->color_temp, LV_ANIM_OFF);
+            
+            /* An RGB color set at the same time takes precedence */
+            if (!(dirty & CARD_FIELD_COLOR)) {
+                set_preview_kelvin(card_data, light->color_temp);
+            }
+        } else {
+            skipped_updates += CARD_WIDGETS_COLOR_TEMP;
         }
     }
     
+    shown->is_on = light->is_on;
+    shown->brightness = light->brightness;
+    shown->red = light->red;
+    shown->green = light->green;
+    shown->blue = light->blue;
+    shown->color_temp = light->color_temp;
+    
     /* Update the stored light state fields individually to preserve the pointer */
     card_data->light->is_on = light->is_on;
     card_data->light->brightness = light->brightness;
@@ -307,3 +638,49 @@ void light_control_update_card(lv_obj_t *card, light_state_t *light)
     card_data->light->blue = light->blue;
     card_data->light->color_temp = light->color_temp;
 }
+
+/**
+ * Number of widget updates skipped because the value was already shown
+ */
+uint32_t light_control_get_skipped_updates(void)
+{
+    return skipped_updates;
+}
+
+/**
+ * Expand or collapse the color controls of a card
+ */
+void light_control_set_expanded(lv_obj_t *card, bool expanded)
+{
+    light_card_data_t *card_data = (light_card_data_t *)lv_obj_get_user_data(card);
+    if (!card_data) return;
+    
+    card_set_expanded(card, card_data, expanded);
+}
+
+/**
+ * Check whether a card shows its color controls
+ */
+bool light_control_is_expanded(lv_obj_t *card)
+{
+    light_card_data_t *card_data = (light_card_data_t *)lv_obj_get_user_data(card);
+    return card_data && card_data->expanded;
+}
+
+/**
+ * Set the callback notified when the user expands or collapses a card
+ */
+void light_control_set_expand_cb(light_control_expand_cb_t cb, void *user_data)
+{
+    expand_cb = cb;
+    expand_cb_user_data = user_data;
+}
+
+/**
+ * Set the callback notified when the user switches a light on or off
+ */
+void light_control_set_power_cb(light_control_power_cb_t cb, void *user_data)
+{
+    power_cb = cb;
+    power_cb_user_data = user_data;
+}
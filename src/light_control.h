@@ -7,18 +7,29 @@
 #define LIGHT_CONTROL_H
 
 #include "lvgl/lvgl.h"
+#include "entity_registry.h"
 #include <stdbool.h>
 
 /* Light types */
 typedef enum {
     LIGHT_TYPE_SWITCH,  /* Simple on/off with brightness */
-    LIGHT_TYPE_COLOR    /* RGB with CCT support */
+    LIGHT_TYPE_COLOR,   /* RGB with CCT support */
+    LIGHT_TYPE_COUNT
 } light_type_t;
 
+/* Released cards kept for reuse, per light type */
+#define LIGHT_CONTROL_POOL_SIZE 64
+
+/* Card geometry, used when cards are positioned by the dashboard */
+#define LIGHT_CARD_WIDTH 300
+#define LIGHT_CARD_HEIGHT_SWITCH 160  /* Also collapsed color cards */
+#define LIGHT_CARD_HEIGHT_COLOR 380   /* Expanded color cards */
+
 /* Light state structure */
 typedef struct {
     char name[64];
     char entity_id[64];
+    entity_handle_t handle;  /* Interned entity_id, set by whoever owns the state */
     light_type_t type;
     bool is_on;
     uint8_t brightness;  /* 0-255 */
@@ -29,7 +40,26 @@ typedef struct {
 } light_state_t;
 
 /**
- * Create a light control card
+ * Expand callback, called after the user expanded or collapsed a card
+ * @param card Light card object
+ * @param light Light shown by the card
+ * @param expanded true if the color controls are now shown
+ * @param user_data User data given to light_control_set_expand_cb
+ */
+typedef void (*light_control_expand_cb_t)(lv_obj_t *card, light_state_t *light, bool expanded, void *user_data);
+
+/**
+ * Power callback, called when the user switches a card's light, before the
+ * light's state changes
+ * @param light Light shown by the card, still holding the previous state
+ * @param is_on New power state
+ * @param user_data User data given to light_control_set_power_cb
+ */
+typedef void (*light_control_power_cb_t)(light_state_t *light, bool is_on, void *user_data);
+
+/**
+ * Create a light control card. Color cards start collapsed, their color
+ * controls are built when the card is first expanded.
  * @param parent Parent object
  * @param light Light state data
  * @return Created light card object
@@ -37,10 +67,71 @@ typedef struct {
 lv_obj_t* light_control_create_card(lv_obj_t *parent, light_state_t *light);
 
 /**
- * Update a light control card with new state
+ * Get a card for a light, reusing a released card of the same type when
+ * one is available instead of building a new widget tree
+ * @param parent Parent object
+ * @param light Light state data, must outlive the binding
+ * @return Card object, or NULL if it could not be created
+ */
+lv_obj_t* light_control_acquire_card(lv_obj_t *parent, light_state_t *light);
+
+/**
+ * Hide a card and return it to the pool (deleted if the pool is full)
+ * @param card Card obtained from light_control_acquire_card
+ */
+void light_control_release_card(lv_obj_t *card);
+
+/**
+ * Rebind an existing card to another light of the same type
+ * @param card Light card object
+ * @param light Light state data, must outlive the binding
+ * @return false if the card was built for a different light type
+ */
+bool light_control_bind_card(lv_obj_t *card, light_state_t *light);
+
+/**
+ * Update a light control card with new state. Only widgets whose value
+ * differs from what the card currently shows are touched.
  * @param card Light card object
  * @param light New light state
  */
 void light_control_update_card(lv_obj_t *card, light_state_t *light);
 
+/**
+ * Expand or collapse the color controls of a color card (no effect on
+ * switch cards). Controls of a collapsed card are deleted after a while.
+ * @param card Light card object
+ * @param expanded true to show the color controls
+ */
+void light_control_set_expanded(lv_obj_t *card, bool expanded);
+
+/**
+ * Check whether a card shows its color controls
+ * @param card Light card object
+ * @return true if expanded
+ */
+bool light_control_is_expanded(lv_obj_t *card);
+
+/**
+ * Set the callback notified when the user expands or collapses a card
+ * @param cb Callback, NULL to disable
+ * @param user_data Passed to the callback
+ */
+void light_control_set_expand_cb(light_control_expand_cb_t cb, void *user_data);
+
+/**
+ * Set the callback notified when the user switches a light on or off
+ * @param cb Callback, NULL to disable
+ * @param user_data Passed to the callback
+ */
+void light_control_set_power_cb(light_control_power_cb_t cb, void *user_data);
+
+/**
+ * Get the number of widget updates light_control_update_card skipped
+ * because the card already showed the value (each one would have
+ * invalidated an area and caused a redraw)
+ * @return Skipped widget updates since startup
+ */
+uint32_t light_control_get_skipped_updates(void);
+
 #endif /* LIGHT_CONTROL_H */
@@ -0,0 +1,209 @@
+/**
+ * @file light_snapshot.c
+ * Binary snapshot of the light list implementation
+ */
+
+#include "light_snapshot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* "HALS" read as a host-order integer; a file from a machine of the other
+ * byte order fails the check */
+#define LIGHT_SNAPSHOT_MAGIC 0x534C4148u
+
+/* File header */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t count;
+    uint32_t checksum;   /* FNV-1a of the records */
+} light_snapshot_header_t;
+
+/* One light; only what the first frame needs */
+typedef struct {
+    char name[64];
+    char entity_id[64];
+    uint8_t type;
+    uint8_t is_on;
+    uint8_t brightness;
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+    uint16_t color_temp;
+} light_snapshot_record_t;
+
+/**
+ * FNV-1a hash of a byte range
+ */
+static uint32_t snapshot_checksum(const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Load lights from a snapshot
+ */
+int light_snapshot_load(const char *path, light_state_t *lights, int max_lights)
+{
+    if (!path || !lights || max_lights <= 0) {
+        return -1;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno != ENOENT) {
+            fprintf(stderr, "Snapshot: cannot open %s: %s\n", path, strerror(errno));
+        }
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(light_snapshot_header_t)) {
+        close(fd);
+        fprintf(stderr, "Snapshot: %s is truncated\n", path);
+        return -1;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+
+    const light_snapshot_header_t *header = (const light_snapshot_header_t *)map;
+    const light_snapshot_record_t *records = (const light_snapshot_record_t *)(header + 1);
+    size_t records_size = size - sizeof(*header);
+    int count = -1;
+
+    if (header->magic != LIGHT_SNAPSHOT_MAGIC || header->version != LIGHT_SNAPSHOT_VERSION ||
+        header->record_size != sizeof(light_snapshot_record_t) ||
+        records_size != (size_t)header->count * sizeof(light_snapshot_record_t)) {
+        fprintf(stderr, "Snapshot: %s has an unknown format, ignoring it\n", path);
+    } else if (snapshot_checksum(records, records_size) != header->checksum) {
+        fprintf(stderr, "Snapshot: %s is corrupt, ignoring it\n", path);
+    } else {
+        count = header->count < (uint32_t)max_lights ? (int)header->count : max_lights;
+        for (int i = 0; i < count; i++) {
+            const light_snapshot_record_t *r = &records[i];
+            light_state_t *light = &lights[i];
+
+            memset(light, 0, sizeof(*light));
+            memcpy(light->name, r->name, sizeof(light->name) - 1);
+            memcpy(light->entity_id, r->entity_id, sizeof(light->entity_id) - 1);
+            light->handle = ENTITY_HANDLE_INVALID;
+            light->type = r->type < LIGHT_TYPE_COUNT ? (light_type_t)r->type : LIGHT_TYPE_SWITCH;
+            light->is_on = r->is_on != 0;
+            light->brightness = r->brightness;
+            light->red = r->red;
+            light->green = r->green;
+            light->blue = r->blue;
+            light->color_temp = r->color_temp;
+        }
+    }
+
+    munmap(map, size);
+    return count;
+}
+
+/**
+ * Write a whole buffer, retrying short writes
+ */
+static bool write_all(int fd, const void *data, size_t len)
+{
+    const char *p = (const char *)data;
+
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+/**
+ * Atomically replace a snapshot
+ */
+bool light_snapshot_save(const char *path, const light_state_t *lights, int count)
+{
+    if (!path || !lights || count < 0) {
+        return false;
+    }
+
+    size_t records_size = (size_t)count * sizeof(light_snapshot_record_t);
+    light_snapshot_record_t *records = (light_snapshot_record_t *)calloc(1, records_size ? records_size : 1);
+    if (!records) {
+        fprintf(stderr, "Snapshot: out of memory\n");
+        return false;
+    }
+
+    /* Zeroed padding and string tails keep the checksum reproducible */
+    for (int i = 0; i < count; i++) {
+        light_snapshot_record_t *r = &records[i];
+        const light_state_t *light = &lights[i];
+
+        memcpy(r->name, light->name, sizeof(r->name));
+        memcpy(r->entity_id, light->entity_id, sizeof(r->entity_id));
+        r->name[sizeof(r->name) - 1] = '\0';
+        r->entity_id[sizeof(r->entity_id) - 1] = '\0';
+        r->type = (uint8_t)light->type;
+        r->is_on = light->is_on ? 1 : 0;
+        r->brightness = light->brightness;
+        r->red = light->red;
+        r->green = light->green;
+        r->blue = light->blue;
+        r->color_temp = light->color_temp;
+    }
+
+    light_snapshot_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = LIGHT_SNAPSHOT_MAGIC;
+    header.version = LIGHT_SNAPSHOT_VERSION;
+    header.record_size = sizeof(light_snapshot_record_t);
+    header.count = (uint32_t)count;
+    header.checksum = snapshot_checksum(records, records_size);
+
+    char tmp_path[512];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    bool ok = false;
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd >= 0) {
+        ok = write_all(fd, &header, sizeof(header)) &&
+             write_all(fd, records, records_size) &&
+             fsync(fd) == 0;
+        ok = close(fd) == 0 && ok;
+        ok = ok && rename(tmp_path, path) == 0;
+    }
+    if (!ok) {
+        int err = errno;
+        if (fd >= 0) {
+            unlink(tmp_path);
+        }
+        fprintf(stderr, "Snapshot: cannot write %s: %s\n", path, strerror(err));
+    }
+
+    free(records);
+    return ok;
+}
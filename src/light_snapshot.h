@@ -0,0 +1,38 @@
+/**
+ * @file light_snapshot.h
+ * Binary snapshot of the light list for warm startup
+ *
+ * The file is a fixed header followed by one fixed-size record per light,
+ * in host byte order. It is mapped read-only at startup so the first frame
+ * can be built without waiting for Home Assistant, and rewritten through a
+ * temporary file and rename() so a crash never leaves a torn snapshot.
+ */
+
+#ifndef LIGHT_SNAPSHOT_H
+#define LIGHT_SNAPSHOT_H
+
+#include "light_control.h"
+#include <stdbool.h>
+
+/* Bumped whenever the record layout changes; other versions are ignored */
+#define LIGHT_SNAPSHOT_VERSION 1
+
+/**
+ * Load lights from a snapshot
+ * @param path Snapshot file
+ * @param lights Output array (handles are left invalid)
+ * @param max_lights Size of lights
+ * @return Number of lights loaded, or -1 if the file is missing or invalid
+ */
+int light_snapshot_load(const char *path, light_state_t *lights, int max_lights);
+
+/**
+ * Atomically replace a snapshot
+ * @param path Snapshot file
+ * @param lights Lights to store
+ * @param count Number of lights
+ * @return true if the snapshot was written
+ */
+bool light_snapshot_save(const char *path, const light_state_t *lights, int count);
+
+#endif /* LIGHT_SNAPSHOT_H */
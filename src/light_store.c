@@ -0,0 +1,281 @@
+/**
+ * @file light_store.c
+ * Struct-of-arrays light state store implementation
+ */
+
+#include "light_store.h"
+#include "ha_api.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Average name plus entity ID length budgeted per light */
+#define LIGHT_STORE_NAME_BYTES 48
+
+/**
+ * Copy a string into the arena
+ * @return Offset, or UINT32_MAX if the arena is full
+ */
+static uint32_t store_string(light_store_t *store, const char *text)
+{
+    size_t len = strlen(text) + 1;
+    if (store->names_used + len > store->names_size) {
+        return UINT32_MAX;
+    }
+
+    uint32_t offset = (uint32_t)store->names_used;
+    memcpy(store->names + offset, text, len);
+    store->names_used += len;
+    return offset;
+}
+
+/**
+ * Allocate a store
+ */
+bool light_store_init(light_store_t *store, int capacity)
+{
+    size_t n = capacity > 0 ? (size_t)capacity : 0;
+
+    memset(store, 0, sizeof(*store));
+    store->capacity = capacity;
+    store->handle = malloc(n * sizeof(*store->handle));
+    store->type = malloc(n);
+    store->is_on = malloc(n);
+    store->brightness = malloc(n);
+    store->red = malloc(n);
+    store->green = malloc(n);
+    store->blue = malloc(n);
+    store->color_temp = malloc(n * sizeof(*store->color_temp));
+    store->name = malloc(n * sizeof(*store->name));
+    store->entity_id = malloc(n * sizeof(*store->entity_id));
+    store->names_size = n * LIGHT_STORE_NAME_BYTES;
+    store->names = malloc(store->names_size);
+
+    if (!store->handle || !store->type || !store->is_on || !store->brightness ||
+        !store->red || !store->green || !store->blue || !store->color_temp ||
+        !store->name || !store->entity_id || !store->names) {
+        printf("Error: out of memory for a %d light store\n", capacity);
+        light_store_free(store);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Free a store's arrays
+ */
+void light_store_free(light_store_t *store)
+{
+    free(store->handle);
+    free(store->type);
+    free(store->is_on);
+    free(store->brightness);
+    free(store->red);
+    free(store->green);
+    free(store->blue);
+    free(store->color_temp);
+    free(store->name);
+    free(store->entity_id);
+    free(store->names);
+    memset(store, 0, sizeof(*store));
+}
+
+/**
+ * Remove all lights
+ */
+void light_store_clear(light_store_t *store)
+{
+    store->count = 0;
+    store->names_used = 0;
+}
+
+/**
+ * Append a light
+ */
+int light_store_add(light_store_t *store, const light_state_t *light)
+{
+    if (store->count >= store->capacity) {
+        return -1;
+    }
+
+    size_t names_used = store->names_used;
+    uint32_t name = store_string(store, light->name);
+    uint32_t entity_id = store_string(store, light->entity_id);
+    if (name == UINT32_MAX || entity_id == UINT32_MAX) {
+        store->names_used = names_used;
+        return -1;
+    }
+
+    int i = store->count++;
+    store->handle[i] = light->handle;
+    store->type[i] = (uint8_t)light->type;
+    store->name[i] = name;
+    store->entity_id[i] = entity_id;
+    light_store_set(store, i, light, HA_LIGHT_FIELD_POWER | HA_LIGHT_FIELD_BRIGHTNESS |
+                                     HA_LIGHT_FIELD_COLOR | HA_LIGHT_FIELD_COLOR_TEMP);
+    return i;
+}
+
+/**
+ * Copy one light out of the store
+ */
+void light_store_get(const light_store_t *store, int index, light_state_t *light)
+{
+    memset(light, 0, sizeof(*light));
+    snprintf(light->name, sizeof(light->name), "%s", store->names + store->name[index]);
+    snprintf(light->entity_id, sizeof(light->entity_id), "%s", store->names + store->entity_id[index]);
+    light->handle = store->handle[index];
+    light->type = (light_type_t)store->type[index];
+    light->is_on = store->is_on[index] != 0;
+    light->brightness = store->brightness[index];
+    light->red = store->red[index];
+    light->green = store->green[index];
+    light->blue = store->blue[index];
+    light->color_temp = store->color_temp[index];
+}
+
+/**
+ * Overwrite the hot fields of one light
+ */
+void light_store_set(light_store_t *store, int index, const light_state_t *light, uint8_t fields)
+{
+    if (fields & HA_LIGHT_FIELD_POWER) {
+        store->is_on[index] = light->is_on ? 1 : 0;
+    }
+    if (fields & HA_LIGHT_FIELD_BRIGHTNESS) {
+        store->brightness[index] = light->brightness;
+    }
+    if (fields & HA_LIGHT_FIELD_COLOR) {
+        store->red[index] = light->red;
+        store->green[index] = light->green;
+        store->blue[index] = light->blue;
+    }
+    if (fields & HA_LIGHT_FIELD_COLOR_TEMP) {
+        store->color_temp[index] = light->color_temp;
+    }
+}
+
+/**
+ * Name of a light
+ */
+const char *light_store_get_name(const light_store_t *store, int index)
+{
+    return store->names + store->name[index];
+}
+
+/**
+ * Entity ID of a light
+ */
+const char *light_store_get_entity_id(const light_store_t *store, int index)
+{
+    return store->names + store->entity_id[index];
+}
+
+/**
+ * Turn every light off
+ */
+int light_store_all_off(light_store_t *store)
+{
+    const uint8_t *on = store->is_on;
+    int was_on = 0;
+
+    for (int i = 0; i < store->count; i++) {
+        was_on += on[i];
+    }
+    memset(store->is_on, 0, (size_t)store->count);
+    return was_on;
+}
+
+/*
+ * Bulk kernels. Each one walks a single field array; restrict on the
+ * parameters and branch-free bodies let the compiler vectorize them.
+ */
+
+/**
+ * out[i] |= bit where a[i] != b[i]
+ */
+static void diff_u8(const uint8_t *restrict a, const uint8_t *restrict b,
+                    uint8_t *restrict out, int count, uint8_t bit)
+{
+    for (int i = 0; i < count; i++) {
+        out[i] |= (uint8_t)((a[i] != b[i]) * bit);
+    }
+}
+
+/**
+ * out[i] |= bit where a[i] != b[i], 16-bit fields
+ */
+static void diff_u16(const uint16_t *restrict a, const uint16_t *restrict b,
+                     uint8_t *restrict out, int count, uint8_t bit)
+{
+    for (int i = 0; i < count; i++) {
+        out[i] |= (uint8_t)((a[i] != b[i]) * bit);
+    }
+}
+
+/**
+ * dst[i] = value where members[i] is set
+ */
+static void select_u8(uint8_t *restrict dst, const uint8_t *restrict members, uint8_t value, int count)
+{
+    for (int i = 0; i < count; i++) {
+        uint8_t mask = (uint8_t)-(members[i] != 0);
+        dst[i] = (uint8_t)((dst[i] & (uint8_t)~mask) | (value & mask));
+    }
+}
+
+/**
+ * dst[i] = value where members[i] is set, 16-bit fields
+ */
+static void select_u16(uint16_t *restrict dst, const uint8_t *restrict members, uint16_t value, int count)
+{
+    for (int i = 0; i < count; i++) {
+        uint16_t mask = (uint16_t)-(members[i] != 0);
+        dst[i] = (uint16_t)((dst[i] & (uint16_t)~mask) | (value & mask));
+    }
+}
+
+/**
+ * Compare with a snapshot of the same lights
+ */
+int light_store_diff(const light_store_t *store, const light_store_t *snapshot, uint8_t *fields)
+{
+    int count = store->count < snapshot->count ? store->count : snapshot->count;
+    int changed = 0;
+
+    memset(fields, 0, (size_t)count);
+    diff_u8(store->is_on, snapshot->is_on, fields, count, HA_LIGHT_FIELD_POWER);
+    diff_u8(store->brightness, snapshot->brightness, fields, count, HA_LIGHT_FIELD_BRIGHTNESS);
+    diff_u8(store->red, snapshot->red, fields, count, HA_LIGHT_FIELD_COLOR);
+    diff_u8(store->green, snapshot->green, fields, count, HA_LIGHT_FIELD_COLOR);
+    diff_u8(store->blue, snapshot->blue, fields, count, HA_LIGHT_FIELD_COLOR);
+    diff_u16(store->color_temp, snapshot->color_temp, fields, count, HA_LIGHT_FIELD_COLOR_TEMP);
+
+    for (int i = 0; i < count; i++) {
+        changed += fields[i] != 0;
+    }
+    return changed;
+}
+
+/**
+ * Apply a scene to the selected lights
+ */
+void light_store_apply_scene(light_store_t *store, const uint8_t *members, const light_scene_t *scene)
+{
+    int count = store->count;
+
+    if (scene->fields & HA_LIGHT_FIELD_POWER) {
+        select_u8(store->is_on, members, scene->is_on ? 1 : 0, count);
+    }
+    if (scene->fields & HA_LIGHT_FIELD_BRIGHTNESS) {
+        select_u8(store->brightness, members, scene->brightness, count);
+    }
+    if (scene->fields & HA_LIGHT_FIELD_COLOR) {
+        select_u8(store->red, members, scene->red, count);
+        select_u8(store->green, members, scene->green, count);
+        select_u8(store->blue, members, scene->blue, count);
+    }
+    if (scene->fields & HA_LIGHT_FIELD_COLOR_TEMP) {
+        select_u16(store->color_temp, members, scene->color_temp, count);
+    }
+}
@@ -0,0 +1,118 @@
+/**
+ * @file light_store.h
+ * Struct-of-arrays light state store for bulk operations
+ *
+ * Hot fields (power, brightness, color, color temperature) live in separate
+ * packed arrays and the names in one string arena, so scans over many
+ * lights only touch the bytes they need and compile to tight, vectorizable
+ * loops. light_state_t remains the per-card view; light_store_get and
+ * light_store_set convert between the two.
+ */
+
+#ifndef LIGHT_STORE_H
+#define LIGHT_STORE_H
+
+#include "light_control.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Light state store */
+typedef struct {
+    int count;
+    int capacity;
+    entity_handle_t *handle;
+    uint8_t *type;          /* light_type_t */
+    uint8_t *is_on;         /* 0 or 1 */
+    uint8_t *brightness;
+    uint8_t *red;
+    uint8_t *green;
+    uint8_t *blue;
+    uint16_t *color_temp;
+    uint32_t *name;         /* Offsets into names */
+    uint32_t *entity_id;    /* Offsets into names */
+    char *names;
+    size_t names_used;
+    size_t names_size;
+} light_store_t;
+
+/* Values a scene sets on its member lights */
+typedef struct {
+    uint8_t fields;         /* HA_LIGHT_FIELD_* bits to apply */
+    bool is_on;
+    uint8_t brightness;
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+    uint16_t color_temp;
+} light_scene_t;
+
+/**
+ * Allocate a store
+ * @param store Store to initialize
+ * @param capacity Maximum number of lights
+ * @return false if out of memory
+ */
+bool light_store_init(light_store_t *store, int capacity);
+
+/**
+ * Free a store's arrays
+ */
+void light_store_free(light_store_t *store);
+
+/**
+ * Remove all lights (keeps the allocation)
+ */
+void light_store_clear(light_store_t *store);
+
+/**
+ * Append a light
+ * @return Index of the light, or -1 if the store or its name arena is full
+ */
+int light_store_add(light_store_t *store, const light_state_t *light);
+
+/**
+ * Copy one light out of the store
+ */
+void light_store_get(const light_store_t *store, int index, light_state_t *light);
+
+/**
+ * Overwrite the hot fields of one light
+ * @param fields HA_LIGHT_FIELD_* bits of light to copy
+ */
+void light_store_set(light_store_t *store, int index, const light_state_t *light, uint8_t fields);
+
+/**
+ * Get the name of a light
+ */
+const char *light_store_get_name(const light_store_t *store, int index);
+
+/**
+ * Get the entity ID of a light
+ */
+const char *light_store_get_entity_id(const light_store_t *store, int index);
+
+/**
+ * Turn every light off
+ * @return Number of lights that were on
+ */
+int light_store_all_off(light_store_t *store);
+
+/**
+ * Compare with a snapshot holding the same lights in the same order
+ * @param store Current state
+ * @param snapshot State to compare against (e.g. from the server)
+ * @param fields Output, HA_LIGHT_FIELD_* bits that differ for each light
+ * @return Number of lights with at least one difference
+ */
+int light_store_diff(const light_store_t *store, const light_store_t *snapshot, uint8_t *fields);
+
+/**
+ * Apply a scene to the selected lights
+ * @param store Store to modify
+ * @param members Non-zero for each light the scene applies to (count entries)
+ * @param scene Values to set
+ */
+void light_store_apply_scene(light_store_t *store, const uint8_t *members, const light_scene_t *scene);
+
+#endif /* LIGHT_STORE_H */
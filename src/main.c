@@ -6,10 +6,19 @@
 #include "lvgl/lvgl.h"
 #include "dashboard.h"
 #include "ha_api.h"
+#include "light_control.h"
+#include "light_coalescer.h"
+#include "event_loop.h"
+#include "mem_stats.h"
+#include "display_config.h"
+#include "refresh_governor.h"
+#include "app_config.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h>
+#include <string.h>
 #include <signal.h>
+#include <unistd.h>
 
 /* Display and input device configuration */
 #define DISPLAY_WIDTH  1024
@@ -19,9 +28,27 @@
 #define HA_URL "http://homeassistant.local:8123"
 #define HA_TOKEN "your_long_lived_access_token_here"
 
+/* Refresh period of the heap overlay (DASHBOARD_MEM_STATS set) */
+#define MEM_STATS_PERIOD_MS 1000
+
+/* Light snapshot for warm starts, overridden by the configuration file and
+ * DASHBOARD_SNAPSHOT ("" disables it) */
+#define LIGHT_SNAPSHOT_PATH "lights.snapshot"
+
+/* Configuration file, overridden by DASHBOARD_CONFIG */
+#define CONFIG_PATH "dashboard.ini"
+
+/* Trace output (DASHBOARD_TRACE builds), overridden by DASHBOARD_TRACE_FILE */
+#define TRACE_PATH "dashboard_trace.json"
+
 /* Global flag for graceful shutdown */
 static volatile bool running = true;
 
+/* Applied configuration and the one a reload is parsed into */
+static app_config_t configs[2];
+static int config_index = 0;
+static const char *config_path = CONFIG_PATH;
+
 /**
  * Signal handler for graceful shutdown
  */
@@ -31,6 +58,52 @@ static void signal_handler(int sig)
     running = false;
 }
 
+/**
+ * SIGUSR1: dump the trace from the main loop
+ */
+static void trace_signal_handler(int sig)
+{
+    (void)sig;
+    trace_request_dump();
+}
+
+/**
+ * Home Assistant delivered results or state pushes: show them at full rate
+ */
+static void ha_event_cb(int fd, void *user_data)
+{
+    (void)fd;
+    (void)user_data;
+    refresh_governor_wake();
+}
+
+/**
+ * The configuration file changed: apply it unless it has errors
+ */
+static void config_changed_cb(int fd, void *user_data)
+{
+    (void)user_data;
+    
+    if (!app_config_changed(fd)) {
+        return;
+    }
+    
+    const app_config_t *current = &configs[config_index];
+    app_config_t *next = &configs[config_index ^ 1];
+    if (!app_config_load(config_path, next)) {
+        fprintf(stderr, "Config: keeping the previous configuration\n");
+        return;
+    }
+    
+    printf("Config: reloaded %s\n", config_path);
+    if (strcmp(next->ha_url, current->ha_url) != 0 || strcmp(next->ha_token, current->ha_token) != 0) {
+        printf("Config: Home Assistant endpoint changes apply on restart\n");
+    }
+    config_index ^= 1;
+    dashboard_set_config(next);
+    refresh_governor_wake();
+}
+
 /**
  * Main application entry point
  */
@@ -45,11 +118,29 @@ int main(int argc, char *argv[])
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
     
+    /* Trace dumps on request and at exit */
+    const char *trace_path = getenv("DASHBOARD_TRACE_FILE") ? getenv("DASHBOARD_TRACE_FILE") : TRACE_PATH;
+    if (trace_enabled()) {
+        signal(SIGUSR1, trace_signal_handler);
+        TRACE_THREAD_NAME("ui");
+        printf("Tracing: kill -USR1 %d writes %s\n", (int)getpid(), trace_path);
+    }
+    
     /* Initialize LVGL */
     lv_init();
     
+    /* Sleep in epoll instead of polling (must precede the SDL window) */
+    if (!event_loop_init()) {
+        fprintf(stderr, "Error: failed to create the event loop\n");
+        return 1;
+    }
+    
     /* Initialize SDL display and create window */
     lv_display_t *disp = lv_sdl_window_create(DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    display_config_attach_stats(disp);
+    
+    /* Full refresh rate only while something moves */
+    refresh_governor_init(disp);
     
     /* Create mouse input device */
     lv_indev_t *mouse = lv_sdl_mouse_create();
@@ -60,8 +151,30 @@ int main(int argc, char *argv[])
     /* Create mousewheel input device */
     lv_indev_t *mousewheel = lv_sdl_mousewheel_create();
     
-    /* Initialize Home Assistant API */
-    if (!ha_api_init(HA_URL, HA_TOKEN)) {
+    /* Wake on input rather than polling SDL */
+    event_loop_watch_sdl(disp);
+    
+    /* Runtime configuration (a missing file leaves everything at the defaults) */
+    if (getenv("DASHBOARD_CONFIG")) {
+        config_path = getenv("DASHBOARD_CONFIG");
+    }
+    const app_config_t *config = &configs[config_index];
+    bool have_config = app_config_load(config_path, &configs[config_index]);
+    if (have_config) {
+        printf("Config: loaded %s\n", config_path);
+    }
+    
+    /* Initialize Home Assistant API (environment overrides the configuration
+     * file, which overrides the defaults) */
+    const char *ha_url = config->ha_url[0] ? config->ha_url : HA_URL;
+    const char *ha_token = config->ha_token[0] ? config->ha_token : HA_TOKEN;
+    if (getenv("HA_URL")) {
+        ha_url = getenv("HA_URL");
+    }
+    if (getenv("HA_TOKEN")) {
+        ha_token = getenv("HA_TOKEN");
+    }
+    if (!ha_api_init(ha_url, ha_token)) {
         fprintf(stderr, "Warning: Failed to initialize Home Assistant API\n");
         fprintf(stderr, "Please update HA_URL and HA_TOKEN in main.c\n");
     }
@@ -70,24 +183,92 @@ int main(int argc, char *argv[])
     lv_obj_t *screen = lv_screen_active();
     lv_obj_set_style_bg_color(screen, lv_color_hex(0x0A0A0A), 0);
     
-    /* Initialize dashboard */
+    /* Heap telemetry overlay, with per-subsystem accounting from the start */
+    if (getenv("DASHBOARD_MEM_STATS")) {
+        mem_stats_start(MEM_STATS_PERIOD_MS);
+    }
+    
+    /* Initialize dashboard, from the snapshot when there is one */
+    const char *snapshot = config->has_snapshot ? config->snapshot : LIGHT_SNAPSHOT_PATH;
+    if (getenv("DASHBOARD_SNAPSHOT")) {
+        snapshot = getenv("DASHBOARD_SNAPSHOT");
+    }
+    dashboard_set_snapshot_path(snapshot);
+    if (have_config) {
+        dashboard_set_config(config);
+    }
     dashboard_init(screen);
     
+    /* Apply edits of the configuration file while running */
+    int config_fd = app_config_watch(config_path);
+    if (config_fd >= 0 && !event_loop_add_fd(config_fd, config_changed_cb, NULL)) {
+        close(config_fd);
+        config_fd = -1;
+    }
+    if (config_fd < 0) {
+        printf("Warning: configuration changes need a restart\n");
+    }
+    
+    /* Wake when Home Assistant results or state pushes arrive */
+    event_loop_add_fd(ha_api_get_event_fd(), ha_event_cb, NULL);
+    
     printf("Dashboard initialized successfully\n");
     printf("Press Ctrl+C to exit\n");
     
     /* Main event loop */
     while (running) {
-        /* Handle LVGL tasks */
-        uint32_t time_till_next = lv_timer_handler();
+        uint32_t time_till_next;
+        
+        {
+            TRACE_SCOPE("main_loop");
+            
+            /* Deliver completed Home Assistant requests */
+            ha_api_process();
+            
+            /* Refresh at full rate only while something moves */
+            refresh_governor_update();
+            
+            /* Handle LVGL tasks */
+            TRACE_SCOPE("lv_timer_handler");
+            time_till_next = lv_timer_handler();
+        }
+        
+        trace_dump_if_requested(trace_path);
         
-        /* Sleep for a bit */
-        usleep(time_till_next * 1000);
+        /* Sleep until input, a Home Assistant event or the next timer */
+        event_loop_wait(time_till_next);
     }
     
     printf("\nShutting down gracefully...\n");
+    dashboard_save_snapshot();
+    printf("Coalesced away %u light commands\n", (unsigned)light_coalescer_get_suppressed_count());
+    printf("Rolled back %u light changes\n", (unsigned)light_coalescer_get_rollback_count());
+    printf("Skipped %u unchanged widget updates\n", (unsigned)light_control_get_skipped_updates());
+    printf("Main loop woke up %u times\n", (unsigned)event_loop_get_wakeups());
+    mem_stats_log();
+    display_config_log_stats();
+    refresh_governor_stats_t governor;
+    refresh_governor_get_stats(&governor);
+    printf("Refreshed %u frames at full rate, %u at idle rate, %u wake-ups from Home Assistant\n",
+           (unsigned)governor.active_frames, (unsigned)governor.idle_frames, (unsigned)governor.wakes);
+    for (int i = 0; i < HA_API_POOL_SIZE; i++) {
+        ha_http_stats_t stats;
+        if (ha_api_get_connection_stats(i, &stats) && stats.requests > 0) {
+            printf("HA connection %d: %u requests, %u reused, %u reconnects, %u failures\n",
+                   i, (unsigned)stats.requests, (unsigned)stats.reused,
+                   (unsigned)stats.reconnects, (unsigned)stats.failures);
+        }
+    }
     
     /* Cleanup resources */
+    ha_api_deinit();
+    if (trace_enabled()) {
+        trace_dump(trace_path);
+    }
+    if (config_fd >= 0) {
+        close(config_fd);
+    }
+    event_loop_deinit();
     lv_deinit();
     
     return 0;
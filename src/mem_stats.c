@@ -0,0 +1,204 @@
+/**
+ * @file mem_stats.c
+ * LVGL heap telemetry implementation
+ */
+
+#include "mem_stats.h"
+#include "theme.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/* The overlay refreshes this many times per log line */
+#define MEM_STATS_LOG_EVERY 10
+
+static const char *const subsystem_names[MEM_STATS_SUBSYSTEM_COUNT] = {
+    "cards", "color", "groups"
+};
+
+static bool accounting = false;
+static size_t subsystem_used[MEM_STATS_SUBSYSTEM_COUNT];
+static size_t subsystem_peak[MEM_STATS_SUBSYSTEM_COUNT];
+static uint32_t failures = 0;
+
+#if DASHBOARD_MEM_BACKEND == DASHBOARD_MEM_ARENA
+static int arena_cards = 0;     /* Cards the arena pools are sized for */
+#endif
+
+static lv_obj_t *overlay = NULL;
+static lv_timer_t *overlay_timer = NULL;
+static uint32_t overlay_refreshes = 0;
+
+/**
+ * Name of the heap backend
+ */
+static const char *backend_name(void)
+{
+#if DASHBOARD_MEM_BACKEND == DASHBOARD_MEM_SYSTEM
+    return "system";
+#elif DASHBOARD_MEM_BACKEND == DASHBOARD_MEM_ARENA
+    return "arena";
+#else
+    return "builtin";
+#endif
+}
+
+/**
+ * Enable per-subsystem accounting
+ */
+void mem_stats_enable(bool enable)
+{
+    accounting = enable;
+}
+
+/**
+ * Heap bytes in use
+ */
+size_t mem_stats_used(void)
+{
+    if (!accounting) {
+        return 0;
+    }
+
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    return mon.total_size - mon.free_size;
+}
+
+/**
+ * Charge a subsystem for heap it allocated, or credit it back
+ */
+void mem_stats_charge(mem_stats_subsystem_t subsystem, int32_t bytes)
+{
+    if (bytes < 0 && (size_t)-bytes > subsystem_used[subsystem]) {
+        /* Charged before accounting was enabled */
+        subsystem_used[subsystem] = 0;
+        return;
+    }
+
+    subsystem_used[subsystem] += bytes;
+    if (subsystem_used[subsystem] > subsystem_peak[subsystem]) {
+        subsystem_peak[subsystem] = subsystem_used[subsystem];
+    }
+}
+
+/**
+ * Count an allocation that failed
+ */
+void mem_stats_failure(const char *what)
+{
+    failures++;
+    printf("Error: out of LVGL heap allocating %s\n", what);
+}
+
+/**
+ * Grow the heap arena to hold the given number of cards
+ */
+bool mem_stats_reserve_cards(int cards)
+{
+#if DASHBOARD_MEM_BACKEND == DASHBOARD_MEM_ARENA
+    if (cards <= arena_cards) {
+        return true;
+    }
+
+    /* Never freed: each pool stays part of the heap for the whole run */
+    int added = cards - arena_cards;
+    size_t bytes = (size_t)added * MEM_STATS_ARENA_BYTES_PER_CARD;
+    void *arena = malloc(bytes);
+    if (!arena || !lv_mem_add_pool(arena, bytes)) {
+        free(arena);
+        printf("Error: failed to reserve a %zu byte heap arena for %d more cards\n", bytes, added);
+        return false;
+    }
+
+    arena_cards = cards;
+    printf("Heap arena: %zu bytes for %d more cards (%d in total)\n", bytes, added, cards);
+#else
+    (void)cards;
+#endif
+    return true;
+}
+
+/**
+ * Get a heap snapshot
+ */
+void mem_stats_get(mem_stats_t *stats)
+{
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+
+    stats->total = mon.total_size;
+    stats->used = mon.total_size - mon.free_size;
+    stats->peak = mon.max_used;
+    stats->free_biggest = mon.free_biggest_size;
+    stats->frag_pct = mon.frag_pct;
+    for (int i = 0; i < MEM_STATS_SUBSYSTEM_COUNT; i++) {
+        stats->subsystem_used[i] = subsystem_used[i];
+        stats->subsystem_peak[i] = subsystem_peak[i];
+    }
+    stats->failures = failures;
+}
+
+/**
+ * Print a heap snapshot on one line
+ */
+void mem_stats_log(void)
+{
+    mem_stats_t stats;
+    mem_stats_get(&stats);
+
+    printf("Heap (%s): %zu/%zu bytes, peak %zu, largest free %zu, frag %u%%",
+           backend_name(), stats.used, stats.total, stats.peak, stats.free_biggest,
+           (unsigned)stats.frag_pct);
+    if (accounting) {
+        for (int i = 0; i < MEM_STATS_SUBSYSTEM_COUNT; i++) {
+            printf(", %s %zu (peak %zu)", subsystem_names[i],
+                   stats.subsystem_used[i], stats.subsystem_peak[i]);
+        }
+    }
+    if (stats.failures) {
+        printf(", %u failed allocations", (unsigned)stats.failures);
+    }
+    printf("\n");
+}
+
+/**
+ * Refresh the overlay, log every MEM_STATS_LOG_EVERY refreshes
+ */
+static void overlay_timer_cb(lv_timer_t *timer)
+{
+    (void)timer;
+    mem_stats_t stats;
+    mem_stats_get(&stats);
+
+    lv_label_set_text_fmt(overlay,
+                          "heap %u/%u KB  peak %u KB  frag %u%%\n"
+                          "cards %u KB  color %u KB  groups %u KB",
+                          (unsigned)(stats.used / 1024), (unsigned)(stats.total / 1024),
+                          (unsigned)(stats.peak / 1024), (unsigned)stats.frag_pct,
+                          (unsigned)(stats.subsystem_used[MEM_STATS_CARDS] / 1024),
+                          (unsigned)(stats.subsystem_used[MEM_STATS_COLOR] / 1024),
+                          (unsigned)(stats.subsystem_used[MEM_STATS_GROUPS] / 1024));
+
+    if (++overlay_refreshes % MEM_STATS_LOG_EVERY == 0) {
+        mem_stats_log();
+    }
+}
+
+/**
+ * Show a heap overlay on the top layer and log periodically
+ */
+void mem_stats_start(uint32_t period_ms)
+{
+    mem_stats_enable(true);
+    if (overlay_timer) {
+        lv_timer_set_period(overlay_timer, period_ms);
+        return;
+    }
+
+    overlay = lv_label_create(lv_layer_top());
+    theme_add(overlay, THEME_OVERLAY, 0);
+    lv_obj_align(overlay, LV_ALIGN_BOTTOM_RIGHT, -10, -10);
+
+    overlay_timer = lv_timer_create(overlay_timer_cb, period_ms, NULL);
+    overlay_timer_cb(overlay_timer);
+}
@@ -0,0 +1,91 @@
+/**
+ * @file mem_stats.h
+ * LVGL heap telemetry: usage, fragmentation and peak, per subsystem
+ *
+ * Subsystems are charged with the heap growth measured while they build
+ * their widgets and credited when those widgets are deleted. Measuring
+ * walks the heap, so it only happens once telemetry is enabled.
+ */
+
+#ifndef MEM_STATS_H
+#define MEM_STATS_H
+
+#include "lvgl/lvgl.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Estimated heap needed per light card, used to size the arena */
+#define MEM_STATS_ARENA_BYTES_PER_CARD 4096
+
+/* Subsystems charged for the heap they use */
+typedef enum {
+    MEM_STATS_CARDS,   /* Light cards (compact part) */
+    MEM_STATS_COLOR,   /* Color controls of expanded cards */
+    MEM_STATS_GROUPS,  /* Group cards */
+    MEM_STATS_SUBSYSTEM_COUNT
+} mem_stats_subsystem_t;
+
+/* Heap snapshot */
+typedef struct {
+    size_t total;                                 /* Heap size (in use for the system backend) */
+    size_t used;
+    size_t peak;
+    size_t free_biggest;                          /* Largest free block */
+    uint8_t frag_pct;                             /* 0: free memory in one block */
+    size_t subsystem_used[MEM_STATS_SUBSYSTEM_COUNT];
+    size_t subsystem_peak[MEM_STATS_SUBSYSTEM_COUNT];
+    uint32_t failures;                            /* Allocations that failed */
+} mem_stats_t;
+
+/**
+ * Enable per-subsystem accounting
+ * @param enable true to measure heap growth while widgets are built
+ */
+void mem_stats_enable(bool enable);
+
+/**
+ * Heap bytes in use, for bracketing a build with mem_stats_charge
+ * @return Bytes in use, 0 while accounting is disabled
+ */
+size_t mem_stats_used(void);
+
+/**
+ * Charge a subsystem for heap it allocated, or credit it back
+ * @param subsystem Subsystem
+ * @param bytes Growth measured with mem_stats_used, negative on release
+ */
+void mem_stats_charge(mem_stats_subsystem_t subsystem, int32_t bytes);
+
+/**
+ * Count an allocation that failed
+ * @param what What was being allocated, for the log
+ */
+void mem_stats_failure(const char *what);
+
+/**
+ * Grow the heap arena to hold the given number of cards (arena backend
+ * only): a pool for the cards not reserved yet is added to the heap
+ * @param cards Light cards the dashboard may instantiate
+ * @return false if the arena could not be allocated
+ */
+bool mem_stats_reserve_cards(int cards);
+
+/**
+ * Get a heap snapshot
+ * @param stats Output snapshot
+ */
+void mem_stats_get(mem_stats_t *stats);
+
+/**
+ * Print a heap snapshot on one line
+ */
+void mem_stats_log(void);
+
+/**
+ * Show a heap overlay on the top layer and log periodically
+ * @param period_ms Overlay refresh period; the log is written every tenth refresh
+ */
+void mem_stats_start(uint32_t period_ms);
+
+#endif /* MEM_STATS_H */
@@ -0,0 +1,119 @@
+/**
+ * @file mem_system.c
+ * LVGL heap backend on the system allocator (DASHBOARD_MEM_SYSTEM)
+ *
+ * Like LVGL's own clib backend, but every block carries its size so the
+ * memory monitor can report bytes in use and the peak.
+ */
+
+#include "lvgl/lvgl.h"
+
+#if LV_USE_STDLIB_MALLOC == LV_STDLIB_CUSTOM
+
+#include <stdlib.h>
+
+/* Block header, keeps the payload aligned like malloc's */
+typedef union {
+    size_t size;
+    long double align_float;
+    long long align_int;
+    void *align_ptr;
+} mem_block_t;
+
+static size_t used_bytes = 0;
+static size_t peak_bytes = 0;
+static uint32_t used_blocks = 0;
+
+void lv_mem_init(void)
+{
+    /* Nothing to init */
+}
+
+void lv_mem_deinit(void)
+{
+    /* Nothing to deinit */
+}
+
+lv_mem_pool_t lv_mem_add_pool(void *mem, size_t bytes)
+{
+    /* Not supported */
+    (void)mem;
+    (void)bytes;
+    return NULL;
+}
+
+void lv_mem_remove_pool(lv_mem_pool_t pool)
+{
+    /* Not supported */
+    (void)pool;
+}
+
+void *lv_malloc_core(size_t size)
+{
+    mem_block_t *block = malloc(sizeof(mem_block_t) + size);
+    if (!block) {
+        return NULL;
+    }
+
+    block->size = size;
+    used_bytes += size;
+    used_blocks++;
+    if (used_bytes > peak_bytes) {
+        peak_bytes = used_bytes;
+    }
+    return block + 1;
+}
+
+void *lv_realloc_core(void *p, size_t new_size)
+{
+    if (!p) {
+        return lv_malloc_core(new_size);
+    }
+
+    mem_block_t *block = (mem_block_t *)p - 1;
+    size_t old_size = block->size;
+    block = realloc(block, sizeof(mem_block_t) + new_size);
+    if (!block) {
+        return NULL;
+    }
+
+    block->size = new_size;
+    used_bytes = used_bytes - old_size + new_size;
+    if (used_bytes > peak_bytes) {
+        peak_bytes = used_bytes;
+    }
+    return block + 1;
+}
+
+void lv_free_core(void *p)
+{
+    if (!p) {
+        return;
+    }
+
+    mem_block_t *block = (mem_block_t *)p - 1;
+    used_bytes -= block->size;
+    used_blocks--;
+    free(block);
+}
+
+void lv_mem_monitor_core(lv_mem_monitor_t *mon_p)
+{
+    /* No pool: the heap is as large as what is in use, and fragmentation
+     * is the system allocator's business */
+    mon_p->total_size = (uint32_t)used_bytes;
+    mon_p->free_size = 0;
+    mon_p->free_biggest_size = 0;
+    mon_p->free_cnt = 0;
+    mon_p->used_cnt = used_blocks;
+    mon_p->max_used = (uint32_t)peak_bytes;
+    mon_p->used_pct = 100;
+    mon_p->frag_pct = 0;
+}
+
+lv_result_t lv_mem_test_core(void)
+{
+    return LV_RESULT_OK;
+}
+
+#endif /* LV_USE_STDLIB_MALLOC == LV_STDLIB_CUSTOM */
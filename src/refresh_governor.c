@@ -0,0 +1,128 @@
+/**
+ * @file refresh_governor.c
+ * Adaptive display refresh rate implementation
+ */
+
+#include "refresh_governor.h"
+#include <stdio.h>
+#include <string.h>
+
+static lv_timer_t *refr_timer = NULL;
+static bool active = true;
+static uint32_t last_activity = 0;
+static refresh_governor_stats_t stats;
+
+/**
+ * Count refreshes per rate
+ */
+static void governor_refr_ready_cb(lv_event_t *e)
+{
+    (void)e;
+
+    if (active) {
+        stats.active_frames++;
+    } else {
+        stats.idle_frames++;
+    }
+}
+
+/**
+ * Whether the user is touching the screen or something animates
+ */
+static bool governor_busy(void)
+{
+    if (lv_anim_count_running() > 0) {
+        return true;
+    }
+    for (lv_indev_t *indev = lv_indev_get_next(NULL); indev; indev = lv_indev_get_next(indev)) {
+        if (lv_indev_get_state(indev) == LV_INDEV_STATE_PRESSED) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Switch between the full rate and the idle cadence
+ */
+static void governor_set_active(bool is_active)
+{
+    if (active == is_active) {
+        return;
+    }
+
+    active = is_active;
+    /* A shorter period applies at once: the next run is due from the last one */
+    lv_timer_set_period(refr_timer, active ? LV_DEF_REFR_PERIOD : REFRESH_GOVERNOR_IDLE_PERIOD_MS);
+}
+
+/**
+ * Something was invalidated: if it is the user's doing, go to the full
+ * rate now rather than on the next main loop iteration
+ */
+static void governor_invalidate_cb(lv_event_t *e)
+{
+    (void)e;
+
+    if (!active && governor_busy()) {
+        last_activity = lv_tick_get();
+        governor_set_active(true);
+    }
+}
+
+/**
+ * Govern the refresh timer of a display
+ */
+bool refresh_governor_init(lv_display_t *disp)
+{
+    refr_timer = lv_display_get_refr_timer(disp);
+    if (!refr_timer) {
+        printf("Refresh governor: display has no refresh timer\n");
+        return false;
+    }
+
+    memset(&stats, 0, sizeof(stats));
+    active = true;
+    last_activity = lv_tick_get();
+    lv_timer_set_period(refr_timer, LV_DEF_REFR_PERIOD);
+    lv_display_add_event_cb(disp, governor_refr_ready_cb, LV_EVENT_REFR_READY, NULL);
+    lv_display_add_event_cb(disp, governor_invalidate_cb, LV_EVENT_INVALIDATE_AREA, NULL);
+    return true;
+}
+
+/**
+ * Pick the refresh period for what is happening now
+ */
+void refresh_governor_update(void)
+{
+    if (!refr_timer) {
+        return;
+    }
+
+    if (governor_busy()) {
+        last_activity = lv_tick_get();
+    }
+    governor_set_active(lv_tick_elaps(last_activity) < REFRESH_GOVERNOR_LINGER_MS);
+}
+
+/**
+ * Switch to the full rate for an external change
+ */
+void refresh_governor_wake(void)
+{
+    if (!refr_timer) {
+        return;
+    }
+
+    stats.wakes++;
+    last_activity = lv_tick_get();
+    governor_set_active(true);
+}
+
+/**
+ * Get the governor statistics
+ */
+void refresh_governor_get_stats(refresh_governor_stats_t *out)
+{
+    *out = stats;
+}
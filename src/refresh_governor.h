@@ -0,0 +1,57 @@
+/**
+ * @file refresh_governor.h
+ * Adaptive display refresh rate
+ *
+ * The display refreshes at the full rate (LV_DEF_REFR_PERIOD) while a
+ * pointer is pressed, an animation runs or Home Assistant just pushed a
+ * change, and for a short while after. Otherwise redraws are batched at a
+ * slow idle cadence. When nothing is invalidated the refresh timer stays
+ * paused (LVGL pauses it before each refresh and resumes it on
+ * invalidation), so a static dashboard does not wake up at all.
+ */
+
+#ifndef REFRESH_GOVERNOR_H
+#define REFRESH_GOVERNOR_H
+
+#include "lvgl/lvgl.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Refresh period while nothing interactive is happening */
+#define REFRESH_GOVERNOR_IDLE_PERIOD_MS 250
+
+/* Full rate is kept this long after the last activity */
+#define REFRESH_GOVERNOR_LINGER_MS 1000
+
+/* Governor statistics */
+typedef struct {
+    uint32_t active_frames;  /* Refreshes at the full rate */
+    uint32_t idle_frames;    /* Refreshes at the idle cadence */
+    uint32_t wakes;          /* External wake-ups (state pushes) */
+} refresh_governor_stats_t;
+
+/**
+ * Govern the refresh timer of a display
+ * @param disp Display
+ * @return false if the display has no refresh timer
+ */
+bool refresh_governor_init(lv_display_t *disp);
+
+/**
+ * Pick the refresh period for what is happening now. Call once per main
+ * loop iteration, before lv_timer_handler().
+ */
+void refresh_governor_update(void);
+
+/**
+ * Switch to the full rate because an external change is about to be shown
+ */
+void refresh_governor_wake(void);
+
+/**
+ * Get the governor statistics
+ * @param stats Output statistics
+ */
+void refresh_governor_get_stats(refresh_governor_stats_t *stats);
+
+#endif /* REFRESH_GOVERNOR_H */
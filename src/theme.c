@@ -0,0 +1,107 @@
+/**
+ * @file theme.c
+ * Shared styles of the dashboard implementation
+ */
+
+#include "theme.h"
+
+/* Card geometry shared by light and group cards */
+#define THEME_CARD_RADIUS 10
+#define THEME_CARD_BORDER 2
+
+static lv_style_t styles[THEME_STYLE_COUNT];
+static bool theme_ready = false;
+
+/**
+ * Common card look
+ */
+static void init_card(lv_style_t *style, lv_color_t bg, int32_t pad)
+{
+    lv_style_init(style);
+    lv_style_set_pad_all(style, pad);
+    lv_style_set_bg_color(style, bg);
+    lv_style_set_border_color(style, lv_color_hex(0x404040));
+    lv_style_set_border_width(style, THEME_CARD_BORDER);
+    lv_style_set_radius(style, THEME_CARD_RADIUS);
+    /* Inherited by every label on the card */
+    lv_style_set_text_color(style, lv_color_white());
+}
+
+/**
+ * Initialize the shared styles
+ */
+void theme_init(void)
+{
+    if (theme_ready) {
+        return;
+    }
+
+    init_card(&styles[THEME_CARD], lv_color_hex(0x2C2C2C), 15);
+    init_card(&styles[THEME_GROUP_CARD], lv_color_hex(0x26323F), 10);
+
+    lv_style_init(&styles[THEME_CARD_TITLE]);
+    lv_style_set_text_font(&styles[THEME_CARD_TITLE], &lv_font_montserrat_20);
+
+    lv_style_init(&styles[THEME_TEXT_DIM]);
+    lv_style_set_text_color(&styles[THEME_TEXT_DIM], lv_color_hex(0xAAAAAA));
+
+    lv_style_init(&styles[THEME_STATUS_ON]);
+    lv_style_set_text_color(&styles[THEME_STATUS_ON], lv_color_hex(0x00FF00));
+
+    lv_style_init(&styles[THEME_STATUS_OFF]);
+    lv_style_set_text_color(&styles[THEME_STATUS_OFF], lv_color_hex(0xFF0000));
+
+    lv_style_init(&styles[THEME_SLIDER_INDICATOR]);
+    lv_style_set_bg_color(&styles[THEME_SLIDER_INDICATOR], lv_color_hex(0xFFB300));
+
+    lv_style_init(&styles[THEME_PREVIEW]);
+    lv_style_set_border_width(&styles[THEME_PREVIEW], 2);
+    lv_style_set_border_color(&styles[THEME_PREVIEW], lv_color_white());
+
+    lv_style_init(&styles[THEME_MARKER]);
+    lv_style_set_radius(&styles[THEME_MARKER], LV_RADIUS_CIRCLE);
+    lv_style_set_border_width(&styles[THEME_MARKER], 2);
+    lv_style_set_border_color(&styles[THEME_MARKER], lv_color_white());
+
+    lv_style_init(&styles[THEME_CONTAINER]);
+    lv_style_set_bg_color(&styles[THEME_CONTAINER], lv_color_hex(0x1C1C1C));
+    lv_style_set_border_width(&styles[THEME_CONTAINER], 0);
+    lv_style_set_pad_all(&styles[THEME_CONTAINER], 10);
+
+    lv_style_init(&styles[THEME_BAR]);
+    lv_style_set_bg_opa(&styles[THEME_BAR], LV_OPA_TRANSP);
+    lv_style_set_border_width(&styles[THEME_BAR], 0);
+    lv_style_set_pad_all(&styles[THEME_BAR], 0);
+
+    lv_style_init(&styles[THEME_SCREEN_TITLE]);
+    lv_style_set_text_font(&styles[THEME_SCREEN_TITLE], &lv_font_montserrat_28);
+    lv_style_set_text_color(&styles[THEME_SCREEN_TITLE], lv_color_white());
+
+    lv_style_init(&styles[THEME_OVERLAY]);
+    lv_style_set_bg_color(&styles[THEME_OVERLAY], lv_color_black());
+    lv_style_set_bg_opa(&styles[THEME_OVERLAY], LV_OPA_70);
+    lv_style_set_text_color(&styles[THEME_OVERLAY], lv_color_hex(0xAAAAAA));
+    lv_style_set_text_font(&styles[THEME_OVERLAY], &lv_font_montserrat_12);
+    lv_style_set_pad_all(&styles[THEME_OVERLAY], 6);
+
+    theme_ready = true;
+}
+
+/**
+ * Attach a shared style to an object
+ */
+void theme_add(lv_obj_t *obj, theme_style_t style, lv_style_selector_t selector)
+{
+    theme_init();
+    lv_obj_add_style(obj, &styles[style], selector);
+}
+
+/**
+ * Color a status label for the power state
+ */
+void theme_set_status(lv_obj_t *label, bool is_on)
+{
+    theme_init();
+    lv_obj_remove_style(label, &styles[is_on ? THEME_STATUS_OFF : THEME_STATUS_ON], 0);
+    lv_obj_add_style(label, &styles[is_on ? THEME_STATUS_ON : THEME_STATUS_OFF], 0);
+}
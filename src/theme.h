@@ -0,0 +1,55 @@
+/**
+ * @file theme.h
+ * Shared styles of the dashboard
+ *
+ * Every style is a static lv_style_t initialized once and attached to
+ * objects by reference, so a card costs one style list entry per style
+ * instead of a local style property per call, and objects sharing a style
+ * resolve it from the same place.
+ */
+
+#ifndef THEME_H
+#define THEME_H
+
+#include "lvgl/lvgl.h"
+#include <stdbool.h>
+
+/* Shared styles */
+typedef enum {
+    THEME_CARD,           /* Light card: background, border, radius, padding, white text */
+    THEME_GROUP_CARD,     /* Group card, a compact card in another shade */
+    THEME_CARD_TITLE,     /* Light name on a card */
+    THEME_TEXT_DIM,       /* Secondary text */
+    THEME_STATUS_ON,      /* Power status text when on */
+    THEME_STATUS_OFF,     /* Power status text when off */
+    THEME_SLIDER_INDICATOR, /* Filled part of brightness and temperature sliders */
+    THEME_PREVIEW,        /* Color preview box outline */
+    THEME_MARKER,         /* Round selection marker */
+    THEME_CONTAINER,      /* Light grid background */
+    THEME_BAR,            /* Transparent row of group cards */
+    THEME_SCREEN_TITLE,   /* Dashboard title */
+    THEME_OVERLAY,        /* Diagnostics text over the dashboard */
+    THEME_STYLE_COUNT
+} theme_style_t;
+
+/**
+ * Initialize the shared styles (once; later calls do nothing)
+ */
+void theme_init(void);
+
+/**
+ * Attach a shared style to an object
+ * @param obj Object
+ * @param style Style to attach
+ * @param selector Part and state the style applies to
+ */
+void theme_add(lv_obj_t *obj, theme_style_t style, lv_style_selector_t selector);
+
+/**
+ * Color a status label for the power state
+ * @param label Status label
+ * @param is_on true for the "on" color
+ */
+void theme_set_status(lv_obj_t *label, bool is_on);
+
+#endif /* THEME_H */
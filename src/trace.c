@@ -0,0 +1,233 @@
+/**
+ * @file trace.c
+ * Hot path tracing implementation
+ */
+
+#include "trace.h"
+#include <stdio.h>
+#include <signal.h>
+
+#if DASHBOARD_TRACE
+
+#include <time.h>
+#include <unistd.h>
+
+#define TRACE_RING_MASK (TRACE_RING_SIZE - 1)
+
+/* Complete event. seq is the event's index + 1 once written and 0 while the
+ * owning thread rewrites the slot, so a dump can skip torn events. */
+typedef struct {
+    uint32_t seq;
+    const char *name;
+    uint64_t start_ns;
+    uint64_t end_ns;
+} trace_event_t;
+
+/* Events of one thread; only that thread writes */
+typedef struct {
+    uint32_t head;          /* Events written so far */
+    const char *thread_name;
+    trace_event_t events[TRACE_RING_SIZE];
+} trace_ring_t;
+
+static trace_ring_t rings[TRACE_MAX_THREADS];
+static int num_rings = 0;
+static __thread trace_ring_t *thread_ring = NULL;
+static __thread bool thread_untraced = false;   /* Came after TRACE_MAX_THREADS */
+static volatile sig_atomic_t dump_requested = 0;
+
+/**
+ * Ring of the calling thread, claimed on first use
+ */
+static trace_ring_t *ring_get(void)
+{
+    if (thread_ring || thread_untraced) {
+        return thread_ring;
+    }
+
+    int index = __atomic_fetch_add(&num_rings, 1, __ATOMIC_ACQ_REL);
+    if (index >= TRACE_MAX_THREADS) {
+        thread_untraced = true;
+        return NULL;
+    }
+    thread_ring = &rings[index];
+    return thread_ring;
+}
+
+/**
+ * Monotonic clock in nanoseconds
+ */
+uint64_t trace_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Record a complete event in the calling thread's ring
+ */
+void trace_record(const char *name, uint64_t start_ns, uint64_t end_ns)
+{
+    trace_ring_t *ring = ring_get();
+    if (!ring) {
+        return;
+    }
+
+    uint32_t head = ring->head;
+    trace_event_t *event = &ring->events[head & TRACE_RING_MASK];
+
+    __atomic_store_n(&event->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&event->name, name, __ATOMIC_RELAXED);
+    __atomic_store_n(&event->start_ns, start_ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&event->end_ns, end_ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&event->seq, head + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Cleanup handler of TRACE_SCOPE
+ */
+void trace_scope_end(trace_scope_t *scope)
+{
+    trace_record(scope->name, scope->start_ns, trace_now_ns());
+}
+
+/**
+ * Name the calling thread in the trace
+ */
+void trace_set_thread_name(const char *name)
+{
+    trace_ring_t *ring = ring_get();
+    if (ring) {
+        __atomic_store_n(&ring->thread_name, name, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * Copy one event unless its slot is being rewritten
+ * @return false if the event at index is gone or torn
+ */
+static bool event_read(const trace_ring_t *ring, uint32_t index, trace_event_t *out)
+{
+    const trace_event_t *event = &ring->events[index & TRACE_RING_MASK];
+
+    uint32_t seq = __atomic_load_n(&event->seq, __ATOMIC_ACQUIRE);
+    if (seq != index + 1) {
+        return false;
+    }
+    out->name = __atomic_load_n(&event->name, __ATOMIC_RELAXED);
+    out->start_ns = __atomic_load_n(&event->start_ns, __ATOMIC_RELAXED);
+    out->end_ns = __atomic_load_n(&event->end_ns, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&event->seq, __ATOMIC_RELAXED) == seq;
+}
+
+/**
+ * Check whether tracing was compiled in
+ */
+bool trace_enabled(void)
+{
+    return true;
+}
+
+/**
+ * Write the recorded events as Chrome trace JSON
+ */
+bool trace_dump(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+
+    int pid = (int)getpid();
+    int count = __atomic_load_n(&num_rings, __ATOMIC_ACQUIRE);
+    uint32_t written = 0;
+    const char *sep = "";
+
+    if (count > TRACE_MAX_THREADS) {
+        count = TRACE_MAX_THREADS;
+    }
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (int t = 0; t < count; t++) {
+        const trace_ring_t *ring = &rings[t];
+        const char *thread_name = __atomic_load_n(&ring->thread_name, __ATOMIC_ACQUIRE);
+
+        if (thread_name) {
+            fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                    "\"args\":{\"name\":\"%s\"}}", sep, pid, t + 1, thread_name);
+            sep = ",";
+        }
+
+        uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        uint32_t first = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+        for (uint32_t i = first; i != head; i++) {
+            trace_event_t event;
+            if (!event_read(ring, i, &event)) {
+                continue;
+            }
+            /* Names are string literals and function names: no escaping */
+            fprintf(f, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    sep, event.name, pid, t + 1, (double)event.start_ns / 1000.0,
+                    (double)(event.end_ns - event.start_ns) / 1000.0);
+            sep = ",";
+            written++;
+        }
+    }
+    fprintf(f, "\n]}\n");
+
+    bool ok = fclose(f) == 0;
+    if (ok) {
+        printf("Trace: wrote %u events to %s\n", (unsigned)written, path);
+    } else {
+        perror(path);
+    }
+    return ok;
+}
+
+#else
+
+/**
+ * Check whether tracing was compiled in
+ */
+bool trace_enabled(void)
+{
+    return false;
+}
+
+/**
+ * Write the recorded events as Chrome trace JSON
+ */
+bool trace_dump(const char *path)
+{
+    (void)path;
+    fprintf(stderr, "Trace: not compiled in (configure with -DDASHBOARD_TRACE=ON)\n");
+    return false;
+}
+
+static volatile sig_atomic_t dump_requested = 0;
+
+#endif /* DASHBOARD_TRACE */
+
+/**
+ * Request a dump from a signal handler
+ */
+void trace_request_dump(void)
+{
+    dump_requested = 1;
+}
+
+/**
+ * Dump the trace if it was requested
+ */
+void trace_dump_if_requested(const char *path)
+{
+    if (dump_requested) {
+        dump_requested = 0;
+        trace_dump(path);
+    }
+}
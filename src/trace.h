@@ -0,0 +1,115 @@
+/**
+ * @file trace.h
+ * Hot path tracing with Chrome trace export
+ *
+ * Built with DASHBOARD_TRACE=1 (cmake -DDASHBOARD_TRACE=ON) the TRACE_*
+ * macros record complete events with their duration into a ring buffer of
+ * the calling thread; without it they compile to nothing. Each thread
+ * writes only its own ring, so recording takes no lock. trace_dump()
+ * writes the events still in the rings as Chrome trace JSON, which
+ * chrome://tracing and ui.perfetto.dev open.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef DASHBOARD_TRACE
+#define DASHBOARD_TRACE 0
+#endif
+
+/* Events kept per thread, the oldest are overwritten (power of two) */
+#define TRACE_RING_SIZE 16384
+
+/* Most threads that can record events */
+#define TRACE_MAX_THREADS 8
+
+#if DASHBOARD_TRACE
+
+/* Scope being timed, closed by trace_scope_end when it goes out of scope */
+typedef struct {
+    const char *name;
+    uint64_t start_ns;
+} trace_scope_t;
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+/** Time the rest of the enclosing block; name must be a string literal */
+#define TRACE_SCOPE(name) \
+    trace_scope_t TRACE_CONCAT(trace_scope_, __LINE__) __attribute__((cleanup(trace_scope_end))) = \
+        {(name), trace_now_ns()}
+
+/** Time the rest of the enclosing function under its own name */
+#define TRACE_FUNC() TRACE_SCOPE(__func__)
+
+/** Record an event that started at start_ns (from trace_now_ns) and ends now */
+#define TRACE_COMPLETE(name, start_ns) trace_record((name), (start_ns), trace_now_ns())
+
+/** Name the calling thread in the trace */
+#define TRACE_THREAD_NAME(name) trace_set_thread_name(name)
+
+/**
+ * Monotonic clock in nanoseconds
+ * @return Current time
+ */
+uint64_t trace_now_ns(void);
+
+/**
+ * Record a complete event in the calling thread's ring
+ * @param name Event name, must stay valid until the trace is dumped
+ * @param start_ns Start time from trace_now_ns
+ * @param end_ns End time from trace_now_ns
+ */
+void trace_record(const char *name, uint64_t start_ns, uint64_t end_ns);
+
+/**
+ * Cleanup handler of TRACE_SCOPE
+ * @param scope Scope that ends
+ */
+void trace_scope_end(trace_scope_t *scope);
+
+/**
+ * Name the calling thread in the trace
+ * @param name Thread name, must stay valid until the trace is dumped
+ */
+void trace_set_thread_name(const char *name);
+
+#else
+
+#define TRACE_SCOPE(name) do { } while (0)
+#define TRACE_FUNC() do { } while (0)
+#define TRACE_COMPLETE(name, start_ns) do { } while (0)
+#define TRACE_THREAD_NAME(name) do { } while (0)
+
+#endif /* DASHBOARD_TRACE */
+
+/**
+ * Check whether tracing was compiled in
+ * @return true with DASHBOARD_TRACE=1
+ */
+bool trace_enabled(void);
+
+/**
+ * Write the recorded events as Chrome trace JSON. Threads may keep
+ * recording meanwhile; events overwritten during the dump are skipped.
+ * @param path Output file
+ * @return true if the file was written
+ */
+bool trace_dump(const char *path);
+
+/**
+ * Request a dump from a signal handler; the main loop performs it
+ * through trace_dump_if_requested (async-signal-safe)
+ */
+void trace_request_dump(void);
+
+/**
+ * Dump the trace if trace_request_dump was called since the last dump
+ * @param path Output file
+ */
+void trace_dump_if_requested(const char *path);
+
+#endif /* TRACE_H */
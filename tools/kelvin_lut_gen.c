@@ -0,0 +1,71 @@
+/**
+ * @file kelvin_lut_gen.c
+ * Generator of the Kelvin to RGB table (src/kelvin_lut_table.h)
+ *
+ * Evaluates a blackbody color approximation (Tanner Helland's fit of
+ * Mitchell Charity's blackbody data) once per table entry on the build
+ * host, so the panel only ever does a table lookup.
+ *
+ * Usage: kelvin_lut_gen > src/kelvin_lut_table.h
+ */
+
+#include "../src/kelvin_lut.h"
+#include <math.h>
+#include <stdio.h>
+
+/**
+ * Clamp a channel to 0-255 and round it
+ */
+static int channel(double value)
+{
+    if (value < 0.0) return 0;
+    if (value > 255.0) return 255;
+    return (int)(value + 0.5);
+}
+
+/**
+ * Approximate sRGB color of a blackbody at the given temperature
+ */
+static void kelvin_to_rgb(double kelvin, int *red, int *green, int *blue)
+{
+    double t = kelvin / 100.0;
+
+    if (t <= 66.0) {
+        *red = 255;
+        *green = channel(99.4708025861 * log(t) - 161.1195681661);
+    } else {
+        *red = channel(329.698727446 * pow(t - 60.0, -0.1332047592));
+        *green = channel(288.1221695283 * pow(t - 60.0, -0.0755148492));
+    }
+
+    if (t >= 66.0) {
+        *blue = 255;
+    } else if (t <= 19.0) {
+        *blue = 0;
+    } else {
+        *blue = channel(138.5177312231 * log(t - 10.0) - 305.0447927307);
+    }
+}
+
+/**
+ * Print the table as a C header
+ */
+int main(void)
+{
+    printf("/**\n");
+    printf(" * @file kelvin_lut_table.h\n");
+    printf(" * Kelvin to RGB table, generated by tools/kelvin_lut_gen.c - do not edit\n");
+    printf(" */\n\n");
+    printf("/* %d K to %d K in %d K steps */\n", KELVIN_LUT_MIN, KELVIN_LUT_MAX, KELVIN_LUT_STEP);
+    printf("static const uint8_t kelvin_lut_table[KELVIN_LUT_SIZE][3] = {\n");
+
+    for (int i = 0; i < KELVIN_LUT_SIZE; i++) {
+        int kelvin = KELVIN_LUT_MIN + i * KELVIN_LUT_STEP;
+        int red, green, blue;
+        kelvin_to_rgb(kelvin, &red, &green, &blue);
+        printf("    {%3d, %3d, %3d},  /* %d K */\n", red, green, blue, kelvin);
+    }
+
+    printf("};\n");
+    return 0;
+}
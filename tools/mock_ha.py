@@ -0,0 +1,369 @@
+#!/usr/bin/env python3
+"""Mock Home Assistant server for running the dashboard without an instance.
+
+Serves the REST calls the dashboard makes, over HTTP/1.1 keep-alive
+connections (pipelined requests are answered in order):
+
+  GET  /api/states                        every light
+  GET  /api/states/<entity_id>            one light
+  POST /api/services/light/turn_on        brightness, rgb_color, color_temp_kelvin
+  POST /api/services/light/turn_off
+  POST /api/services/light/toggle
+  GET  /api/websocket                     auth, subscribe_events, state_changed
+
+Service calls target an "entity_id" (string or list) or an "area_id"; the
+mock's lights are spread over the areas living_room, kitchen and bedroom.
+
+Usage:
+  tools/mock_ha.py [--port 8123] [--token test] [--lights 8] [--close-after N] [--drop-after N]
+                   [--ws-drop-every S]
+
+  HA_URL=http://127.0.0.1:8123 HA_TOKEN=test ./lvgl_dashboard
+
+--close-after N closes every connection after its Nth response, announced
+with "Connection: close", so the dashboard has to open a new one.
+--drop-after N closes every connection without answering its Nth request,
+like a server restart, so the dashboard has to retry the request. Each
+connection and request is logged; compare them with the "HA connection"
+lines the dashboard prints at exit.
+
+WebSocket clients go through auth_required -> auth -> auth_ok (auth_invalid
+for a wrong token) and subscribe_events; every service call then pushes a
+state_changed event per light it changed. --ws-drop-every S closes the
+WebSocket connections every S seconds and toggles light.mock_1 while they
+are down, a change the dashboard only sees by resynchronizing when it
+reconnects.
+"""
+
+import argparse
+import base64
+import hashlib
+import json
+import socket
+import socketserver
+import struct
+import sys
+import threading
+import time
+
+AREAS = ("living_room", "kitchen", "bedroom")
+COLOR_MODES = ["color_temp", "rgb"]
+WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+
+class LightStore:
+    """Light states shared by all connections"""
+
+    def __init__(self, count):
+        self.lock = threading.Lock()
+        self.lights = {}
+        self.areas = {}
+        for i in range(1, count + 1):
+            entity_id = "light.mock_%d" % i
+            color = i % 2 == 0
+            attributes = {"friendly_name": "Mock Light %d" % i}
+            if color:
+                attributes["supported_color_modes"] = COLOR_MODES
+            else:
+                attributes["supported_color_modes"] = ["onoff"]
+            self.lights[entity_id] = {"entity_id": entity_id, "state": "off", "attributes": attributes,
+                                      "brightness": 255, "rgb_color": [255, 255, 255],
+                                      "color_temp_kelvin": 4000, "color": color}
+            self.areas[entity_id] = AREAS[(i - 1) % len(AREAS)]
+
+    def state(self, entity_id):
+        """Home Assistant's JSON view of one light (caller holds the lock)"""
+        light = self.lights[entity_id]
+        attributes = dict(light["attributes"])
+        if light["state"] == "on":
+            attributes["brightness"] = light["brightness"]
+            if light["color"]:
+                attributes["rgb_color"] = light["rgb_color"]
+                attributes["color_temp_kelvin"] = light["color_temp_kelvin"]
+        else:
+            attributes["brightness"] = None
+        return {"entity_id": entity_id, "state": light["state"], "attributes": attributes}
+
+    def all_states(self):
+        with self.lock:
+            return [self.state(entity_id) for entity_id in self.lights]
+
+    def one_state(self, entity_id):
+        with self.lock:
+            return self.state(entity_id) if entity_id in self.lights else None
+
+    def targets(self, data):
+        """Entity IDs a service call addresses"""
+        if "area_id" in data:
+            return [e for e, area in self.areas.items() if area == data["area_id"]]
+        entity_ids = data.get("entity_id", [])
+        if isinstance(entity_ids, str):
+            entity_ids = [entity_ids]
+        return [e for e in entity_ids if e in self.lights]
+
+    def call(self, service, data):
+        """Apply a light service call, return the new states"""
+        changed = []
+        with self.lock:
+            for entity_id in self.targets(data):
+                light = self.lights[entity_id]
+                action = service
+                if action == "toggle":
+                    action = "turn_off" if light["state"] == "on" else "turn_on"
+                if action == "turn_off":
+                    light["state"] = "off"
+                else:
+                    light["state"] = "on"
+                    if "brightness" in data:
+                        light["brightness"] = max(0, min(255, int(data["brightness"])))
+                    if "rgb_color" in data:
+                        light["rgb_color"] = [max(0, min(255, int(c))) for c in data["rgb_color"][:3]]
+                    if "color_temp_kelvin" in data:
+                        light["color_temp_kelvin"] = int(data["color_temp_kelvin"])
+                changed.append(self.state(entity_id))
+        return changed
+
+
+class WebSocketClient:
+    """Subscribed WebSocket connection; frames may be sent from any thread"""
+
+    def __init__(self, connection, wfile):
+        self.connection = connection
+        self.wfile = wfile
+        self.lock = threading.Lock()
+        self.subscription = None
+
+    def send(self, payload, opcode=0x1):
+        data = json.dumps(payload).encode() if opcode == 0x1 else payload
+        if len(data) < 126:
+            head = struct.pack("!BB", 0x80 | opcode, len(data))
+        elif len(data) < 65536:
+            head = struct.pack("!BBH", 0x80 | opcode, 126, len(data))
+        else:
+            head = struct.pack("!BBQ", 0x80 | opcode, 127, len(data))
+        with self.lock:
+            try:
+                self.wfile.write(head + data)
+                self.wfile.flush()
+            except OSError:
+                pass
+
+    def event(self, state):
+        if self.subscription is not None:
+            self.send({"id": self.subscription, "type": "event",
+                       "event": {"event_type": "state_changed",
+                                 "data": {"entity_id": state["entity_id"], "new_state": state}}})
+
+    def drop(self):
+        try:
+            self.connection.shutdown(socket.SHUT_RDWR)
+        except OSError:
+            pass
+
+
+class Handler(socketserver.StreamRequestHandler):
+    """One client connection: requests are answered in order until it closes"""
+
+    def log(self, fmt, *args):
+        sys.stdout.write("[%s:%d] %s\n" % (self.client_address[0], self.client_address[1], fmt % args))
+        sys.stdout.flush()
+
+    def read_request(self):
+        line = self.rfile.readline()
+        if not line:
+            return None
+        parts = line.decode("latin-1").split()
+        if len(parts) != 3:
+            return None
+        headers = {}
+        while True:
+            header = self.rfile.readline()
+            if not header or header in (b"\r\n", b"\n"):
+                break
+            name, _, value = header.decode("latin-1").partition(":")
+            headers[name.strip().lower()] = value.strip()
+        length = int(headers.get("content-length", "0") or 0)
+        body = self.rfile.read(length) if length else b""
+        return parts[0], parts[1], headers, body
+
+    def respond(self, status, reason, payload, close=False):
+        body = json.dumps(payload).encode() if payload is not None else b""
+        head = "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %d\r\n" % (
+            status, reason, len(body))
+        if close:
+            head += "Connection: close\r\n"
+        self.wfile.write(head.encode() + b"\r\n" + body)
+        self.wfile.flush()
+
+    def read_frame(self):
+        """Next client frame as (opcode, payload), or None once closed"""
+        head = self.rfile.read(2)
+        if len(head) < 2:
+            return None
+        opcode = head[0] & 0x0F
+        length = head[1] & 0x7F
+        if length == 126:
+            length = struct.unpack("!H", self.rfile.read(2))[0]
+        elif length == 127:
+            length = struct.unpack("!Q", self.rfile.read(8))[0]
+        mask = self.rfile.read(4) if head[1] & 0x80 else b"\0\0\0\0"
+        data = self.rfile.read(length)
+        if len(data) < length:
+            return None
+        return opcode, bytes(b ^ mask[i & 3] for i, b in enumerate(data))
+
+    def websocket(self, headers):
+        """Serve the WebSocket API on an upgraded connection"""
+        key = headers.get("sec-websocket-key", "")
+        accept = base64.b64encode(hashlib.sha1((key + WS_GUID).encode()).digest()).decode()
+        self.wfile.write(("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                          "Connection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n" % accept).encode())
+        self.wfile.flush()
+
+        client = WebSocketClient(self.connection, self.wfile)
+        client.send({"type": "auth_required", "ha_version": "mock"})
+        authorized = False
+        try:
+            while True:
+                frame = self.read_frame()
+                if frame is None:
+                    break
+                opcode, data = frame
+                if opcode == 0x8:
+                    client.send(b"", 0x8)
+                    break
+                if opcode == 0x9:
+                    client.send(data, 0xA)
+                    continue
+                if opcode != 0x1:
+                    continue
+
+                message = json.loads(data)
+                if message.get("type") == "auth":
+                    authorized = message.get("access_token") == self.server.token
+                    client.send({"type": "auth_ok" if authorized else "auth_invalid", "ha_version": "mock"})
+                    self.log("WebSocket %s", "authenticated" if authorized else "rejected the token")
+                    if not authorized:
+                        break
+                elif authorized and message.get("type") == "subscribe_events":
+                    client.subscription = message.get("id")
+                    with self.server.ws_lock:
+                        self.server.ws_clients.add(client)
+                    client.send({"id": message.get("id"), "type": "result", "success": True, "result": None})
+                    self.log("WebSocket subscribed to %s", message.get("event_type"))
+        finally:
+            with self.server.ws_lock:
+                self.server.ws_clients.discard(client)
+        self.log("WebSocket closed")
+
+    def route(self, method, path, body):
+        """Answer one authorized REST request: (status, reason, payload)"""
+        if method == "GET" and path == "/api/states":
+            return 200, "OK", self.server.store.all_states()
+        if method == "GET" and path.startswith("/api/states/"):
+            state = self.server.store.one_state(path[len("/api/states/"):])
+            return (200, "OK", state) if state else (404, "Not Found", {"message": "Entity not found."})
+        if method == "POST" and path.startswith("/api/services/light/"):
+            service = path[len("/api/services/light/"):]
+            if service not in ("turn_on", "turn_off", "toggle"):
+                return 400, "Bad Request", {"message": "Service not found."}
+            try:
+                data = json.loads(body or b"{}")
+            except ValueError:
+                return 400, "Bad Request", {"message": "Invalid JSON."}
+            changed = self.server.store.call(service, data)
+            self.server.broadcast(changed)
+            return 200, "OK", changed
+        return 404, "Not Found", {"message": "Not found."}
+
+    def handle(self):
+        self.log("connected")
+        responses = 0
+        while True:
+            request = self.read_request()
+            if request is None:
+                break
+            method, path, headers, body = request
+            if path == "/api/websocket" and headers.get("upgrade", "").lower() == "websocket":
+                self.websocket(headers)
+                return
+
+            if self.server.drop_after > 0 and responses + 1 >= self.server.drop_after:
+                self.log("%s %s dropped", method, path)
+                break
+
+            responses += 1
+            close = self.server.close_after > 0 and responses >= self.server.close_after
+            if headers.get("authorization") != "Bearer " + self.server.token:
+                status, reason, payload = 401, "Unauthorized", {"message": "Invalid token."}
+            else:
+                status, reason, payload = self.route(method, path, body)
+            self.log("%s %s -> %d (request %d on this connection)", method, path, status, responses)
+            self.respond(status, reason, payload, close)
+            if close:
+                break
+        self.log("closed after %d responses", responses)
+
+
+class Server(socketserver.ThreadingTCPServer):
+    allow_reuse_address = True
+    daemon_threads = True
+
+    def broadcast(self, states):
+        """Push state_changed events to every subscribed client"""
+        with self.ws_lock:
+            clients = list(self.ws_clients)
+        for state in states:
+            for client in clients:
+                client.event(state)
+
+    def drop_websockets(self, period):
+        """Close the WebSocket connections every period seconds and change a
+        light while they are down"""
+        while True:
+            time.sleep(period)
+            with self.ws_lock:
+                clients = list(self.ws_clients)
+            for client in clients:
+                client.drop()
+            # Clients reconnect after a backoff of at least a second
+            time.sleep(0.2)
+            changed = self.store.call("toggle", {"entity_id": "light.mock_1"})
+            print("Dropped %d WebSocket connections, then turned light.mock_1 %s"
+                  % (len(clients), changed[0]["state"] if changed else "?"))
+            sys.stdout.flush()
+            self.broadcast(changed)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Mock Home Assistant server")
+    parser.add_argument("--port", type=int, default=8123)
+    parser.add_argument("--token", default="test", help="accepted access token")
+    parser.add_argument("--lights", type=int, default=8, help="number of lights")
+    parser.add_argument("--close-after", type=int, default=0, metavar="N",
+                        help="close each connection after N responses (0: keep alive)")
+    parser.add_argument("--drop-after", type=int, default=0, metavar="N",
+                        help="drop each connection instead of answering its Nth request")
+    parser.add_argument("--ws-drop-every", type=float, default=0, metavar="S",
+                        help="close WebSocket connections every S seconds and change a light meanwhile")
+    args = parser.parse_args()
+
+    server = Server(("127.0.0.1", args.port), Handler)
+    server.store = LightStore(args.lights)
+    server.token = args.token
+    server.close_after = args.close_after
+    server.drop_after = args.drop_after
+    server.ws_lock = threading.Lock()
+    server.ws_clients = set()
+    if args.ws_drop_every > 0:
+        threading.Thread(target=server.drop_websockets, args=(args.ws_drop_every,), daemon=True).start()
+    print("Mock Home Assistant on http://127.0.0.1:%d with %d lights, token '%s'"
+          % (args.port, args.lights, args.token))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()